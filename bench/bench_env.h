@@ -0,0 +1,49 @@
+// Copyright (c) 2019 EPI-ONE Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef EPIC_BENCH_ENV_H
+#define EPIC_BENCH_ENV_H
+
+#include "test_env.h"
+
+/**
+ * Sets up STORE and DAG in a fresh directory for the lifetime of a benchmark
+ */
+class ScopedDAG {
+public:
+    explicit ScopedDAG(std::string prefix) : prefix_(std::move(prefix)) {
+        EpicTestEnvironment::SetUpDAG(prefix_);
+    }
+
+    ~ScopedDAG() {
+        EpicTestEnvironment::TearDownDAG(prefix_);
+    }
+
+private:
+    std::string prefix_;
+};
+
+/**
+ * A synthetic chain of level sets on top of the genesis,
+ * created once and shared by all of the benchmarks
+ */
+inline const TestChain& GetBenchChain() {
+    static const TestChain chain = [] {
+        TestFactory fac;
+        auto result = fac.CreateChain(GENESIS_VERTEX, 50);
+        SetLogLevel(SPDLOG_LEVEL_OFF);
+        return result;
+    }();
+    return chain;
+}
+
+inline size_t CountBlocks(const TestChain& chain) {
+    size_t n = 0;
+    for (const auto& lvs : chain) {
+        n += lvs.size();
+    }
+    return n;
+}
+
+#endif // EPIC_BENCH_ENV_H
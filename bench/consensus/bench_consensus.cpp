@@ -0,0 +1,94 @@
+// Copyright (c) 2019 EPI-ONE Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <benchmark/benchmark.h>
+
+#include "bench_env.h"
+#include "chain.h"
+#include "mempool.h"
+#include "obc.h"
+
+#include <limits>
+
+static void ChainVerify(benchmark::State& state) {
+    const auto& chain = GetBenchChain();
+    ScopedDAG dag("bench_chain_verify/");
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto c = std::make_unique<Chain>();
+        state.ResumeTiming();
+
+        // verify the level sets one by one as they come on the main chain
+        for (const auto& lvs : chain) {
+            for (const auto& vtx : lvs) {
+                c->AddPendingBlock(vtx->cblock);
+            }
+            auto ms = c->Verify(lvs.back()->cblock);
+            c->AddNewMilestone(*ms);
+        }
+
+        state.PauseTiming();
+        c.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * CountBlocks(chain));
+}
+BENCHMARK(ChainVerify)->Unit(benchmark::kMillisecond);
+
+static void ChainSelectTip(benchmark::State& state) {
+    Chain chain;
+    for (const auto& lvs : GetBenchChain()) {
+        for (const auto& vtx : lvs) {
+            chain.AddPendingBlock(vtx->cblock);
+        }
+    }
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(chain.GetRandomForeignTip());
+    }
+}
+BENCHMARK(ChainSelectTip);
+
+static void OrphanBlocksAddSubmit(benchmark::State& state) {
+    // blocks of the synthetic chain are linked by their prev hashes,
+    // so receiving them in reverse order makes all of them orphans
+    std::vector<ConstBlockPtr> blocks;
+    for (const auto& lvs : GetBenchChain()) {
+        for (const auto& vtx : lvs) {
+            blocks.push_back(vtx->cblock);
+        }
+    }
+
+    for (auto _ : state) {
+        OrphanBlocksContainer obc;
+        for (auto it = blocks.rbegin(); it != blocks.rend(); ++it) {
+            obc.AddBlock(ConstBlockPtr{*it}, P_MISSING);
+        }
+        benchmark::DoNotOptimize(obc.SubmitHash(GENESIS->GetHash()));
+    }
+    state.SetItemsProcessed(state.iterations() * blocks.size());
+}
+BENCHMARK(OrphanBlocksAddSubmit);
+
+static void MemPoolInsertExtract(benchmark::State& state) {
+    TestFactory fac;
+    std::vector<ConstTxPtr> txns;
+    txns.reserve(state.range(0));
+    for (int i = 0; i < state.range(0); ++i) {
+        txns.emplace_back(std::make_shared<const Transaction>(fac.CreateTx(2, 2)));
+    }
+    const auto blkHash = fac.CreateRandomHash();
+
+    MemPool pool;
+    for (auto _ : state) {
+        for (const auto& tx : txns) {
+            pool.Insert(tx);
+        }
+        // a threshold beyond the distance of any two hashes extracts everything
+        benchmark::DoNotOptimize(pool.ExtractTransactions(blkHash, std::numeric_limits<double>::max()));
+    }
+    state.SetItemsProcessed(state.iterations() * txns.size());
+}
+BENCHMARK(MemPoolInsertExtract)->Arg(1000)->Arg(10000);
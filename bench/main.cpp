@@ -0,0 +1,27 @@
+// Copyright (c) 2019 EPI-ONE Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <benchmark/benchmark.h>
+
+#include "bench_env.h"
+
+int main(int argc, char** argv) {
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+
+    ECC_Start();
+    {
+        ECCVerifyHandle handle;
+        SelectParams(ParamsType::UNITTEST);
+        SetLogLevel(SPDLOG_LEVEL_OFF);
+
+        benchmark::RunSpecifiedBenchmarks();
+        benchmark::Shutdown();
+    }
+    ECC_Stop();
+
+    return 0;
+}
@@ -0,0 +1,79 @@
+// Copyright (c) 2019 EPI-ONE Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <benchmark/benchmark.h>
+
+#include "bench_env.h"
+
+namespace {
+// a solved block holding the given number of transactions of 4 inputs and 4 outputs
+Block CreateSolvedBlock(int nTxns) {
+    TestFactory fac;
+    auto block = fac.CreateBlock(4, 4, false, nTxns);
+    Miner m{1};
+    m.Start();
+    m.Solve(block);
+    m.Stop();
+    return block;
+}
+} // namespace
+
+static void BlockSerialize(benchmark::State& state) {
+    const auto block = CreateSolvedBlock(state.range(0));
+    for (auto _ : state) {
+        VStream s;
+        s << block;
+        benchmark::DoNotOptimize(s.data());
+    }
+    state.SetBytesProcessed(state.iterations() * block.GetOptimalEncodingSize());
+}
+BENCHMARK(BlockSerialize)->Arg(1)->Arg(100)->Arg(1000);
+
+static void BlockDeserialize(benchmark::State& state) {
+    VStream raw;
+    raw << CreateSolvedBlock(state.range(0));
+    for (auto _ : state) {
+        VStream s{raw};
+        Block block{s};
+        benchmark::DoNotOptimize(block.GetHash());
+    }
+    state.SetBytesProcessed(state.iterations() * raw.size());
+}
+BENCHMARK(BlockDeserialize)->Arg(1)->Arg(100)->Arg(1000);
+
+static void TransactionSerialize(benchmark::State& state) {
+    TestFactory fac;
+    const auto tx = fac.CreateTx(state.range(0), state.range(0));
+    for (auto _ : state) {
+        VStream s;
+        s << tx;
+        benchmark::DoNotOptimize(s.data());
+    }
+}
+BENCHMARK(TransactionSerialize)->Arg(1)->Arg(16)->Arg(256);
+
+static void TransactionDeserialize(benchmark::State& state) {
+    TestFactory fac;
+    VStream raw;
+    raw << fac.CreateTx(state.range(0), state.range(0));
+    for (auto _ : state) {
+        VStream s{raw};
+        Transaction tx{s};
+        benchmark::DoNotOptimize(tx.GetHash());
+    }
+    state.SetBytesProcessed(state.iterations() * raw.size());
+}
+BENCHMARK(TransactionDeserialize)->Arg(1)->Arg(16)->Arg(256);
+
+static void BlockVerify(benchmark::State& state) {
+    const auto block = CreateSolvedBlock(state.range(0));
+    if (!block.Verify()) {
+        state.SkipWithError("the block is invalid");
+        return;
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(block.Verify());
+    }
+}
+BENCHMARK(BlockVerify)->Arg(1)->Arg(100);
@@ -0,0 +1,60 @@
+// Copyright (c) 2019 EPI-ONE Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <benchmark/benchmark.h>
+
+#include "bench_env.h"
+
+static void StoreLevelSet(benchmark::State& state) {
+    const auto& chain = GetBenchChain();
+    ScopedDAG dag("bench_store_lvs/");
+
+    size_t i = 0, nBlocks = 0;
+    for (auto _ : state) {
+        const auto& lvs = chain[i];
+        benchmark::DoNotOptimize(STORE->StoreLevelSet(lvs));
+        nBlocks += lvs.size();
+        i = (i + 1) % chain.size();
+    }
+    state.SetItemsProcessed(nBlocks);
+}
+BENCHMARK(StoreLevelSet);
+
+static void ReadLevelSet(benchmark::State& state) {
+    const auto& chain = GetBenchChain();
+    ScopedDAG dag("bench_read_lvs/");
+    for (const auto& lvs : chain) {
+        STORE->StoreLevelSet(lvs);
+    }
+
+    size_t i = 0, nBytes = 0;
+    for (auto _ : state) {
+        auto raw = STORE->GetRawLevelSetAt(chain[i].back()->height);
+        nBytes += raw.size();
+        i = (i + 1) % chain.size();
+    }
+    state.SetBytesProcessed(nBytes);
+}
+BENCHMARK(ReadLevelSet);
+
+static void FindBlock(benchmark::State& state) {
+    const auto& chain = GetBenchChain();
+    ScopedDAG dag("bench_find_block/");
+
+    std::vector<uint256> hashes;
+    for (const auto& lvs : chain) {
+        STORE->StoreLevelSet(lvs);
+        for (const auto& vtx : lvs) {
+            hashes.push_back(vtx->cblock->GetHash());
+        }
+    }
+
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(STORE->FindBlock(hashes[i]));
+        i = (i + 1) % hashes.size();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(FindBlock);
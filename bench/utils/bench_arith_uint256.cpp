@@ -0,0 +1,101 @@
+// Copyright (c) 2019 EPI-ONE Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <benchmark/benchmark.h>
+
+#include "arith_uint256.h"
+
+#include <random>
+#include <vector>
+
+namespace {
+// Difficulty-like operands together with full-width hash-like ones
+std::vector<arith_uint256> RandomOperands(size_t n) {
+    std::mt19937_64 rng(n);
+    std::vector<arith_uint256> result;
+    result.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        arith_uint256 a;
+        for (int j = 0; j < 4; ++j) {
+            a <<= 64;
+            a |= rng();
+        }
+        result.emplace_back(a >> (rng() % 64));
+    }
+    return result;
+}
+
+const std::vector<arith_uint256>& Operands() {
+    static const auto operands = RandomOperands(1024);
+    return operands;
+}
+
+template <typename F>
+void RunBinary(benchmark::State& state, F&& f) {
+    const auto& ops = Operands();
+    size_t i        = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(f(ops[i], ops[(i + 1) & 1023]));
+        i = (i + 1) & 1023;
+    }
+}
+} // namespace
+
+static void ArithAdd(benchmark::State& state) {
+    RunBinary(state, [](const arith_uint256& a, const arith_uint256& b) { return a + b; });
+}
+BENCHMARK(ArithAdd);
+
+static void ArithSub(benchmark::State& state) {
+    RunBinary(state, [](const arith_uint256& a, const arith_uint256& b) { return a - b; });
+}
+BENCHMARK(ArithSub);
+
+static void ArithMul(benchmark::State& state) {
+    RunBinary(state, [](const arith_uint256& a, const arith_uint256& b) { return a * b; });
+}
+BENCHMARK(ArithMul);
+
+static void ArithDivChainwork(benchmark::State& state) {
+    // Block::GetChainWork divides the max target by the block target
+    const arith_uint256 maxTarget = arith_uint256().SetCompact(0x2100ffff);
+    const auto& ops               = Operands();
+    size_t i                      = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(maxTarget / ((ops[i] >> 16) + 1));
+        i = (i + 1) & 1023;
+    }
+}
+BENCHMARK(ArithDivChainwork);
+
+static void ArithDivSmall(benchmark::State& state) {
+    RunBinary(state, [](const arith_uint256& a, const arith_uint256& b) { return a / (b.GetLow64() | 1); });
+}
+BENCHMARK(ArithDivSmall);
+
+static void ArithXorCompare(benchmark::State& state) {
+    // Distance test of PartitionCmp-like checks
+    RunBinary(state, [](const arith_uint256& a, const arith_uint256& b) { return (a ^ b) < b; });
+}
+BENCHMARK(ArithXorCompare);
+
+static void ArithGetDouble(benchmark::State& state) {
+    const auto& ops = Operands();
+    size_t i        = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(ops[i].GetDouble());
+        i = (i + 1) & 1023;
+    }
+}
+BENCHMARK(ArithGetDouble);
+
+static void ArithCompactRoundTrip(benchmark::State& state) {
+    const auto& ops = Operands();
+    size_t i        = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(arith_uint256().SetCompact(ops[i].GetCompact()));
+        i = (i + 1) & 1023;
+    }
+}
+BENCHMARK(ArithCompactRoundTrip);
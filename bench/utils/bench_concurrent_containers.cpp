@@ -0,0 +1,54 @@
+// Copyright (c) 2019 EPI-ONE Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <benchmark/benchmark.h>
+
+#include "blocking_queue.h"
+#include "concurrent_container.h"
+
+#include <random>
+
+namespace {
+constexpr uint64_t kKeySpace = 1 << 16;
+ConcurrentHashMap<uint64_t, uint64_t> sharedMap;
+BlockingQueue<uint64_t> sharedQueue;
+} // namespace
+
+static void ConcurrentHashMapContention(benchmark::State& state) {
+    if (state.thread_index() == 0) {
+        sharedMap.clear();
+        sharedMap.reserve(kKeySpace);
+    }
+
+    // the share of lookups in percents, the rest being writes
+    const auto readRatio = state.range(0);
+    std::mt19937_64 rng(state.thread_index());
+    for (auto _ : state) {
+        uint64_t key = rng() % kKeySpace;
+        if (static_cast<int64_t>(rng() % 100) < readRatio) {
+            benchmark::DoNotOptimize(sharedMap.contains(key));
+        } else if (key & 1) {
+            sharedMap.insert_or_assign(key, uint64_t{key});
+        } else {
+            sharedMap.erase(key);
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(ConcurrentHashMapContention)->Arg(50)->Arg(90)->ThreadRange(1, 8)->UseRealTime();
+
+static void BlockingQueuePutTake(benchmark::State& state) {
+    // half of the threads produce and the other half consume, all running the same iterations
+    bool producer = state.thread_index() % 2 == 0;
+    uint64_t element = 0;
+    for (auto _ : state) {
+        if (producer) {
+            sharedQueue.Put(element++);
+        } else {
+            sharedQueue.Take(element);
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BlockingQueuePutTake)->ThreadRange(2, 8)->UseRealTime();
@@ -0,0 +1,64 @@
+// Copyright (c) 2019 EPI-ONE Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <benchmark/benchmark.h>
+
+#include "binary_trace.h"
+#include "log.h"
+#include "tracing.h"
+
+#include <cstdio>
+
+namespace {
+const uint256 kHash = uintS<256>("8a1f4d5e6b7c");
+} // namespace
+
+static void LogDisabledEager(benchmark::State& state) {
+    auto level = spdlog::default_logger()->level();
+    spdlog::set_level(spdlog::level::info);
+    for (auto _ : state) {
+        spdlog::trace("[Validation] Validating {} in block {}", kHash.to_substr(), std::to_string(kHash));
+    }
+    spdlog::set_level(level);
+}
+BENCHMARK(LogDisabledEager);
+
+static void LogDisabledLazy(benchmark::State& state) {
+    auto level = spdlog::default_logger()->level();
+    spdlog::set_level(spdlog::level::info);
+    for (auto _ : state) {
+        LOG_TRACE("[Validation] Validating {} in block {}", kHash.to_substr(), std::to_string(kHash));
+    }
+    spdlog::set_level(level);
+}
+BENCHMARK(LogDisabledLazy);
+
+static void BinaryTraceRecord(benchmark::State& state) {
+    const std::string path = "bench_trace.bin";
+    if (state.thread_index() == 0) {
+        BinaryTrace::Open(path);
+    }
+
+    uint64_t i = 0;
+    for (auto _ : state) {
+        TRACE_EVENT(BLOCK_VALIDATED, kHash, i++);
+    }
+    state.SetItemsProcessed(state.iterations());
+
+    if (state.thread_index() == 0) {
+        BinaryTrace::Close();
+        std::remove(path.c_str());
+    }
+}
+BENCHMARK(BinaryTraceRecord)->ThreadRange(1, 4)->UseRealTime();
+
+static void TraceSpanRecord(benchmark::State& state) {
+    Tracer::Enable(state.range(0));
+    for (auto _ : state) {
+        TRACE_SPAN("Chain::Validate", kHash, kHash);
+    }
+    Tracer::Enable(false);
+    Tracer::Clear();
+}
+BENCHMARK(TraceSpanRecord)->Arg(0)->Arg(1);
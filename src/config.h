@@ -75,6 +75,46 @@ public:
         loggerFilename_ = loggerFilename;
     }
 
+    bool IsAsyncLogger() const {
+        return asyncLogger_;
+    }
+
+    void SetAsyncLogger(bool asyncLogger) {
+        asyncLogger_ = asyncLogger;
+    }
+
+    size_t GetLoggerQueueSize() const {
+        return loggerQueueSize_;
+    }
+
+    void SetLoggerQueueSize(size_t size) {
+        loggerQueueSize_ = size;
+    }
+
+    bool IsLoggerOverrun() const {
+        return loggerOverrun_;
+    }
+
+    void SetLoggerOverrun(bool overrun) {
+        loggerOverrun_ = overrun;
+    }
+
+    const std::string GetTraceFile() const {
+        return traceFilename_.empty() ? "" : GetLoggerPath() + traceFilename_;
+    }
+
+    void SetTraceFilename(const std::string& traceFilename) {
+        traceFilename_ = traceFilename;
+    }
+
+    bool IsTracing() const {
+        return tracing_;
+    }
+
+    void SetTracing(bool tracing) {
+        tracing_ = tracing;
+    }
+
     const std::string GetAddressPath() const {
         return GetRoot() + addressPath_;
     }
@@ -139,6 +179,14 @@ public:
         dbPath_ = dbPath;
     }
 
+    void SetPruneWindow(uint64_t window) {
+        pruneWindow_ = window;
+    }
+
+    uint64_t GetPruneWindow() const {
+        return pruneWindow_;
+    }
+
     void AddSeedByIP(const std::string& ip, const uint16_t& port) {
         auto address = NetAddress::GetByIP(ip, port);
         if (address) {
@@ -204,6 +252,10 @@ public:
         ss << "logger level = " << loggerLevel_ << std::endl;
         ss << "use logger file = " << useFileLogger_ << std::endl;
         ss << "logger file path = " << GetLoggerPath() << loggerFilename_ << std::endl;
+        ss << "async logger = " << (asyncLogger_ ? "yes" : "no") << " with queue size " << loggerQueueSize_
+           << (loggerOverrun_ ? ", discarding the oldest message when full" : ", blocking when full") << std::endl;
+        ss << "binary trace = " << (traceFilename_.empty() ? "(disabled)" : GetTraceFile()) << std::endl;
+        ss << "tracing spans = " << (tracing_ ? "yes" : "no") << std::endl;
         ss << "saved address path = " << GetAddressPath() << addressFilename_ << std::endl;
         ss << "interval of saving address = " << saveInterval_ << " seconds" << std::endl;
         ss << "bind ip = " << bindAddress_ << std::endl;
@@ -211,10 +263,12 @@ public:
         ss << "external address = " << external_address_ << std::endl;
         ss << "network type = " << networkType_ << std::endl;
         ss << "dbpath = " << GetDBPath() << std::endl;
+        ss << "prune window = " << pruneWindow_ << (pruneWindow_ ? " heights" : " (disabled)") << std::endl;
         ss << "disable rpc = " << (disableRPC_ ? "yes" : "no") << std::endl;
         ss << "rpc port = " << rpcPort_ << std::endl;
         ss << "wallet path = " << GetWalletPath() << " with backup period " << GetWalletBackup()
-           << ", login session time " << GetWalletLogin() << std::endl;
+           << ", login session time " << GetWalletLogin() << " and key pool size " << GetWalletKeyPool()
+           << std::endl;
         ss << "solver addr = " << GetSolverAddr() << std::endl;
         ss << "number of solver threads = " << GetSolverThreads() << std::endl;
         ss << "seeds = [" << std::endl;
@@ -259,6 +313,14 @@ public:
         return loginSesseion_;
     }
 
+    void SetWalletKeyPool(uint32_t size) {
+        keyPoolSize_ = size;
+    }
+
+    uint32_t GetWalletKeyPool() {
+        return keyPoolSize_;
+    }
+
     void SetSolverAddr(std::string addr) {
         solver_addr = std::move(addr);
     }
@@ -309,6 +371,11 @@ private:
     bool useFileLogger_         = false;
     std::string loggerPath_     = "logs/";
     std::string loggerFilename_ = "Debug.log";
+    bool asyncLogger_           = false;
+    size_t loggerQueueSize_     = 8192;
+    bool loggerOverrun_         = false;
+    std::string traceFilename_  = "";
+    bool tracing_               = false;
 
     // address manager
     std::string addressPath_     = "";
@@ -328,6 +395,8 @@ private:
     // db
     bool startWithNewDB = false;
     std::string dbPath_ = "db/";
+    // number of recent level sets kept on disk, 0 for an archive node
+    uint64_t pruneWindow_ = 0;
 
     // rpc
     bool disableRPC_;
@@ -337,6 +406,7 @@ private:
     std::string walletPath_ = "wallet/";
     uint32_t backupPeriod_;
     uint32_t loginSesseion_;
+    uint32_t keyPoolSize_ = 0;
 
     // daemon
     bool daemon_;
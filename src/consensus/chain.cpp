@@ -3,11 +3,14 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "chain.h"
+#include "binary_trace.h"
 #include "block_store.h"
 #include "functors.h"
+#include "log.h"
 #include "mempool.h"
 #include "subscription.h"
 #include "tasm.h"
+#include "tracing.h"
 
 ////////////////////
 // Chain
@@ -16,8 +19,10 @@
 Chain::Chain() : ismainchain_(true) {}
 
 Chain::Chain(const Chain& chain, const ConstBlockPtr& pfork)
-    : ismainchain_(false), milestones_(chain.milestones_), pendingBlocks_(chain.pendingBlocks_),
-      recentHistory_(chain.recentHistory_), ledger_(chain.ledger_), prevRedempHashMap_(chain.prevRedempHashMap_),
+    : ismainchain_(false), milestones_(chain.milestones_), nCachedBlks_(chain.nCachedBlks_.load()),
+      nCachedTxs_(chain.nCachedTxs_.load()), pendingBlocks_(chain.pendingBlocks_), tips_(chain.tips_),
+      pendingGraph_(chain.pendingGraph_), recentHistory_(chain.recentHistory_), ledger_(chain.ledger_),
+      cumulatorMap_(chain.cumulatorMap_), prevRedempHashMap_(chain.prevRedempHashMap_),
       prevRegsToModify_(chain.prevRegsToModify_) {
     if (milestones_.empty()) {
         return;
@@ -28,10 +33,14 @@ Chain::Chain(const Chain& chain, const ConstBlockPtr& pfork)
 
     // We don't do any verification here but only data copying and rolling back
     for (auto it = milestones_.rbegin(); (*it)->GetMilestoneHash() != target && it != milestones_.rend(); it++) {
+        nCachedBlks_ -= (*it)->GetLevelSet().size();
+        nCachedTxs_ -= (*it)->GetNumOfValidTxns();
         for (const auto& rwp : (*it)->GetLevelSet()) {
             const auto& rpt = *rwp.lock();
             const auto& h   = rpt.cblock->GetHash();
             pendingBlocks_.insert({h, rpt.cblock});
+            tips_.Insert(rpt.cblock);
+            pendingGraph_.Insert(rpt.cblock);
             recentHistory_.erase(h);
             ledger_.Rollback((*it)->GetTXOC());
 
@@ -57,6 +66,8 @@ MilestonePtr Chain::GetChainHead() const {
 }
 
 void Chain::AddPendingBlock(ConstBlockPtr pblock) {
+    tips_.Insert(pblock);
+    pendingGraph_.Insert(pblock);
     pendingBlocks_.insert_or_assign(pblock->GetHash(), std::move(pblock));
 }
 
@@ -86,72 +97,43 @@ std::size_t Chain::GetPendingBlockCount() const {
 }
 
 ConstBlockPtr Chain::GetRandomTip() const {
-    auto tip = pendingBlocks_.random_value();
-    if (tip) {
-        return *tip;
-    }
+    return tips_.Random();
+}
 
-    return nullptr;
+ConstBlockPtr Chain::GetRandomForeignTip() const {
+    return tips_.RandomForeign();
 }
 
 std::vector<ConstBlockPtr> Chain::GetSortedSubgraph(const ConstBlockPtr& pblock) {
-    std::vector<ConstBlockPtr> stack = {pblock};
-    std::vector<ConstBlockPtr> result;
-    ConstBlockPtr cursor;
-
-    /**
-     * reserve memory for efficiency;
-     * please note that n/2 is a not really precise upper bound and can be improved
-     */
-    stack.reserve(pendingBlocks_.size() / 2);
-    result.reserve(pendingBlocks_.size());
-
-    while (!stack.empty()) {
-        cursor = stack.back();
-
-        auto swap = pendingBlocks_.find(cursor->GetMilestoneHash());
-        if (swap != pendingBlocks_.end()) {
-            stack.push_back(swap->second);
-            continue;
-        }
-
-        swap = pendingBlocks_.find(cursor->GetPrevHash());
-        if (swap != pendingBlocks_.end()) {
-            stack.push_back(swap->second);
-            continue;
-        }
-
-        swap = pendingBlocks_.find(cursor->GetTipHash());
-        if (swap != pendingBlocks_.end()) {
-            stack.push_back(swap->second);
-            continue;
-        }
-
-        uint256 cursorHash = cursor->GetHash();
-        pendingBlocks_.erase(cursorHash);
-        result.push_back(cursor);
-        stack.pop_back();
+    auto result = pendingGraph_.ExtractSorted(pblock);
+    for (const auto& block : result) {
+        const auto& hash = block->GetHash();
+        pendingBlocks_.erase(hash);
+        tips_.Erase(hash);
     }
 
-    result.shrink_to_fit();
-    spdlog::debug("[Validation] {} block(s) sorted, {} pending block(s) left. Ratio: {}", result.size(),
-                  pendingBlocks_.size(), static_cast<double>(result.size()) / (result.size() + pendingBlocks_.size()));
+    LOG_DEBUG("[Validation] {} block(s) sorted, {} pending block(s) left. Ratio: {}", result.size(),
+              pendingBlocks_.size(), static_cast<double>(result.size()) / (result.size() + pendingBlocks_.size()));
     return result;
 }
 
+std::vector<ConstBlockPtr> Chain::PeekSortedSubgraph(const ConstBlockPtr& pblock) const {
+    return pendingGraph_.GetSorted(pblock);
+}
+
 void Chain::CheckTxPartition(Vertex& b, float ms_hashrate) {
     if (b.minerChainHeight <= GetParams().sortitionThreshold) {
         if (b.cblock->IsRegistration()) {
             if (b.cblock->GetTransactionSize() > 1) {
                 memset(&b.validity[1], Vertex::Validity::INVALID, b.validity.size() - 1);
-                spdlog::info(
+                LOG_INFO(
                     "[Validation] Does not reach height of partition threshold but contains transactions other than "
                     "registration [{}]",
                     std::to_string(b.cblock->GetHash()));
             }
         } else {
             memset(&b.validity[0], Vertex::Validity::INVALID, b.validity.size());
-            spdlog::info(
+            LOG_INFO(
                 "[Validation] Does not reach height of partition threshold but contains non-reg transactions [{}]",
                 std::to_string(b.cblock->GetHash()));
         }
@@ -161,22 +143,28 @@ void Chain::CheckTxPartition(Vertex& b, float ms_hashrate) {
     auto search = cumulatorMap_.find(b.cblock->GetPrevHash());
     if (search == cumulatorMap_.end()) {
         // Construct a cumulator for the block if it is not cached
-        Cumulator cum;
+        std::vector<ConstBlockPtr> window;
+        window.reserve(GetParams().sortitionThreshold);
 
         ConstBlockPtr cursor = b.cblock;
         VertexPtr previous;
-        while (!cum.Full()) {
+        while (window.size() < GetParams().sortitionThreshold) {
             previous = GetVertex(cursor->GetPrevHash());
 
             if (!previous) {
                 // should not happen
                 throw std::logic_error("Cannot find " + std::to_string(cursor->GetPrevHash()) + " in cumulatorMap.");
             }
-            cum.Add(previous->cblock, false);
+            window.push_back(previous->cblock);
             cursor = previous->cblock;
         }
 
-        cumulatorMap_.emplace(b.cblock->GetPrevHash(), cum);
+        Cumulator cum;
+        for (auto it = window.rbegin(); it != window.rend(); ++it) {
+            cum.Add(*it);
+        }
+
+        cumulatorMap_.emplace(b.cblock->GetPrevHash(), std::move(cum));
     }
 
     auto nodeHandler = cumulatorMap_.extract(b.cblock->GetPrevHash());
@@ -196,21 +184,22 @@ void Chain::CheckTxPartition(Vertex& b, float ms_hashrate) {
 
         if (!PartitionCmp(dist, allowed)) {
             b.validity[i] = Vertex::Validity::INVALID;
-            spdlog::info("[Validation] Transaction distance exceeds its allowed distance! [{}]",
-                         std::to_string(b.cblock->GetHash()));
+            LOG_INFO("[Validation] Transaction distance exceeds its allowed distance! [{}]",
+                     std::to_string(b.cblock->GetHash()));
         }
     }
 
     // Update key for the cumulator
-    cum.Add(b.cblock, true);
+    cum.Add(b.cblock);
     nodeHandler.key() = b.cblock->GetHash();
     cumulatorMap_.insert(std::move(nodeHandler));
 }
 
 VertexPtr Chain::Verify(const ConstBlockPtr& pblock) {
+    TRACE_SPAN("Chain::Verify", pblock->GetHash(), pblock->GetHash());
     auto height = GetChainHead()->height + 1;
 
-    spdlog::debug("[Validation] Validating level set of ms {} at height {}", pblock->GetHash().to_substr(), height);
+    LOG_DEBUG("[Validation] Validating level set of ms {} at height {}", pblock->GetHash().to_substr(), height);
 
     // get a path for validation by the post ordered DFS search
     std::vector<ConstBlockPtr> blocksToValidate = GetSortedSubgraph(pblock);
@@ -230,6 +219,10 @@ VertexPtr Chain::Verify(const ConstBlockPtr& pblock) {
 
     // validate each block in order
     for (auto& vtx : vtcs) {
+        TRACE_SPAN("Chain::Validate", vtx->cblock->GetHash(), pblock->GetHash());
+        if (ismainchain_) {
+            TRACE_ASYNC_END("Pending", vtx->cblock->GetHash());
+        }
         vtx->height = height;
         if (vtx->cblock->IsFirstRegistration()) {
             const auto& blkHash = vtx->cblock->GetHash();
@@ -269,8 +262,8 @@ VertexPtr Chain::Verify(const ConstBlockPtr& pblock) {
 
     CreateNextMilestone(GetChainHead(), *vtcs.back(), std::move(wvtcs), std::move(regChange), std::move(txoc));
     const auto& ms = vtcs.back()->snapshot;
-    spdlog::debug("[Validation] New milestone {} has milestone difficulty target in compact form {} as difficulty {}",
-                  vtcs.back()->cblock->GetHash().to_substr(), ms->milestoneTarget.GetCompact(), ms->GetMsDifficulty());
+    LOG_DEBUG("[Validation] New milestone {} has milestone difficulty target in compact form {} as difficulty {}",
+              vtcs.back()->cblock->GetHash().to_substr(), ms->milestoneTarget.GetCompact(), ms->GetMsDifficulty());
     vtcs.back()->UpdateMilestoneReward();
 
     recentHistory_.merge(std::move(verifying_));
@@ -284,7 +277,7 @@ std::pair<TXOC, TXOC> Chain::Validate(Vertex& vertex, RegChange& regChange) {
 
     // update miner chain height
     vertex.minerChainHeight = GetVertex(prevHash)->minerChainHeight + 1;
-    spdlog::trace("[Validation] Validating {} at its miner chain {}", blkHash.to_substr(), vertex.minerChainHeight);
+    LOG_TRACE("[Validation] Validating {} at its miner chain {}", blkHash.to_substr(), vertex.minerChainHeight);
 
     // update the key of the prev redemption hashes
     uint256 oldRedempHash;
@@ -294,7 +287,7 @@ std::pair<TXOC, TXOC> Chain::Validate(Vertex& vertex, RegChange& regChange) {
         oldRedempHash = STORE->GetPrevRedemHash(prevHash);
 
         if (oldRedempHash.IsNull()) {
-            spdlog::warn("[Validation] Peer chain forks here [{}]", std::to_string(blkHash));
+            LOG_WARN("[Validation] Peer chain forks here [{}]", std::to_string(blkHash));
             auto b = GetVertex(prevHash);
             while (!b->cblock->IsRegistration() || b->validity[0] != Vertex::VALID) {
                 b = GetVertex(b->cblock->GetPrevHash());
@@ -338,6 +331,7 @@ std::pair<TXOC, TXOC> Chain::Validate(Vertex& vertex, RegChange& regChange) {
             if (vertex.validity[i] == Vertex::Validity::UNKNOWN) {
                 vertex.validity[i] = Vertex::Validity::INVALID;
                 invalidTXOC.Merge(CreateTXOCFromInvalid(*txns[i], i));
+                TRACE_EVENT(TX_INVALID, blkHash, i);
             }
 
             if (MEMPOOL) {
@@ -346,6 +340,7 @@ std::pair<TXOC, TXOC> Chain::Validate(Vertex& vertex, RegChange& regChange) {
         }
     }
 
+    TRACE_EVENT(BLOCK_VALIDATED, blkHash, vertex.minerChainHeight);
     return std::make_pair(validTXOC, invalidTXOC);
 }
 
@@ -359,8 +354,7 @@ uint256 Chain::GetPrevRedempHash(const uint256& h) const {
 
 std::optional<TXOC> Chain::ValidateRedemption(Vertex& vertex, RegChange& regChange) {
     const auto& blkHash = vertex.cblock->GetHash();
-    const auto hashstr  = std::to_string(blkHash);
-    spdlog::trace("[Validation] Validating redemption in block {}", blkHash.to_substr());
+    LOG_TRACE("[Validation] Validating redemption in block {}", blkHash.to_substr());
 
     uint256 prevRedempHash = GetPrevRedempHash(blkHash);
     VertexPtr prevReg      = GetVertex(prevRedempHash);
@@ -371,29 +365,29 @@ std::optional<TXOC> Chain::ValidateRedemption(Vertex& vertex, RegChange& regChan
     const auto& vout  = redem->GetOutputs().at(0); // only the first tx output will be regarded as valid
 
     if (vin.outpoint.bHash != prevRedempHash) {
-        spdlog::info("[Validation] Invalid redemption on the previous registration block: outpoint {} not matching the "
-                     "last valid redemption hash {} [{}]",
-                     vin.outpoint.bHash.to_substr(), prevRedempHash.to_substr(), hashstr);
+        LOG_INFO("[Validation] Invalid redemption on the previous registration block: outpoint {} not matching the "
+                 "last valid redemption hash {} [{}]",
+                 vin.outpoint.bHash.to_substr(), prevRedempHash.to_substr(), std::to_string(blkHash));
         return {};
     }
 
     if (prevReg->isRedeemed != Vertex::NOT_YET_REDEEMED || prevRegsToModify_.contains(prevRedempHash)) {
-        spdlog::info("[Validation] Double redemption on the previous registration block: already redeemed {} [{}]",
-                     prevRedempHash.to_substr(), hashstr);
+        LOG_INFO("[Validation] Double redemption on the previous registration block: already redeemed {} [{}]",
+                 prevRedempHash.to_substr(), std::to_string(blkHash));
         return {};
     }
 
     auto prevBlock = GetVertex(vertex.cblock->GetPrevHash());
     // value of the output should be less or equal to the previous counter
     if (!(vout.value <= prevBlock->cumulativeReward)) {
-        spdlog::info("[Validation] Wrong redemption value ({}) that exceeds the total cumulative reward ({}) [{}]",
-                     vout.value.GetValue(), prevBlock->cumulativeReward.GetValue(), hashstr);
+        LOG_INFO("[Validation] Wrong redemption value ({}) that exceeds the total cumulative reward ({}) [{}]",
+                 vout.value.GetValue(), prevBlock->cumulativeReward.GetValue(), std::to_string(blkHash));
         return {};
     }
 
     if (!VerifyInOut(vin, prevReg->cblock->GetTransactions().at(0)->GetOutputs()[0].listingContent)) {
-        spdlog::info("[Validation] Signature failed in redemption {} [{}]", vin.GetParentTx()->GetHash().to_substr(),
-                     hashstr);
+        LOG_INFO("[Validation] Signature failed in redemption {} [{}]", vin.GetParentTx()->GetHash().to_substr(),
+                 std::to_string(blkHash));
         return {};
     }
 
@@ -409,7 +403,7 @@ std::optional<TXOC> Chain::ValidateRedemption(Vertex& vertex, RegChange& regChan
 
 bool Chain::ValidateTx(const Transaction& tx, uint32_t index, TXOC& txoc, Coin& fee) {
     const auto& blkHash = tx.GetParentBlock()->GetHash();
-    spdlog::trace("[Validation] Validating tx {} in block {}", tx.GetHash().to_substr(), blkHash.to_substr());
+    LOG_TRACE("[Validation] Validating tx {} in block {}", tx.GetHash().to_substr(), blkHash.to_substr());
 
     Coin valueIn{};
     Coin valueOut{};
@@ -423,13 +417,13 @@ bool Chain::ValidateTx(const Transaction& tx, uint32_t index, TXOC& txoc, Coin&
         auto prevOut = ledger_.FindSpendable(ComputeUTXOKey(outpoint.bHash, outpoint.txIndex, outpoint.outIndex));
 
         if (!prevOut) {
-            spdlog::info("[Validation] Attempting to spend a non-existent or spent output {} in tx {} [{}]",
-                         std::to_string(outpoint), tx.GetHash().to_substr(), std::to_string(blkHash));
+            LOG_INFO("[Validation] Attempting to spend a non-existent or spent output {} in tx {} [{}]",
+                     std::to_string(outpoint), tx.GetHash().to_substr(), std::to_string(blkHash));
             return false;
         }
-        valueIn += prevOut->GetOutput().value;
+        valueIn += prevOut->GetValue();
 
-        prevOutListing.emplace_back(prevOut->GetOutput().listingContent);
+        prevOutListing.emplace_back(prevOut->GetListing());
         txoc.AddToSpent(vin);
     }
 
@@ -438,9 +432,9 @@ bool Chain::ValidateTx(const Transaction& tx, uint32_t index, TXOC& txoc, Coin&
         const auto& out = tx.GetOutputs()[j];
         if (out.value > valueIn) {
             // To prevent overflow of the outputs' sum
-            spdlog::info("[Validation] Transaction {} has an output whose value ({}) is greater than the sum of all "
-                         "inputs ({}) [{}]",
-                         tx.GetHash().to_substr(), out.value.GetValue(), valueIn.GetValue(), std::to_string(blkHash));
+            LOG_INFO("[Validation] Transaction {} has an output whose value ({}) is greater than the sum of all "
+                     "inputs ({}) [{}]",
+                     tx.GetHash().to_substr(), out.value.GetValue(), valueIn.GetValue(), std::to_string(blkHash));
             return false;
         }
         valueOut += out.value;
@@ -450,8 +444,8 @@ bool Chain::ValidateTx(const Transaction& tx, uint32_t index, TXOC& txoc, Coin&
     // check total amount of value in and value out and record the fee received
     fee = valueIn - valueOut;
     if (!(valueIn >= valueOut && fee <= GetParams().maxMoney)) {
-        spdlog::info("[Validation] Transaction {} input value goes out of range! [{}]", tx.GetHash().to_substr(),
-                     std::to_string(blkHash));
+        LOG_INFO("[Validation] Transaction {} input value goes out of range! [{}]", tx.GetHash().to_substr(),
+                 std::to_string(blkHash));
         return false;
     }
 
@@ -459,8 +453,7 @@ bool Chain::ValidateTx(const Transaction& tx, uint32_t index, TXOC& txoc, Coin&
     auto itprevOut = prevOutListing.cbegin();
     for (const auto& input : tx.GetInputs()) {
         if (!VerifyInOut(input, *itprevOut)) {
-            spdlog::info("[Validation] Signature failed in tx {}! [{}]", tx.GetHash().to_substr(),
-                         std::to_string(blkHash));
+            LOG_INFO("[Validation] Signature failed in tx {}! [{}]", tx.GetHash().to_substr(), std::to_string(blkHash));
             return false;
         }
         itprevOut++;
@@ -471,7 +464,7 @@ bool Chain::ValidateTx(const Transaction& tx, uint32_t index, TXOC& txoc, Coin&
 
 TXOC Chain::ValidateTxns(Vertex& vertex) {
     const auto& blkHash = vertex.cblock->GetHash();
-    spdlog::trace("[Validation] Validating transactions in block {}", blkHash.to_substr());
+    LOG_TRACE("[Validation] Validating transactions in block {}", blkHash.to_substr());
 
     TXOC validTXOC{};
 
@@ -525,6 +518,9 @@ VertexPtr Chain::GetMsVertexCache(const uint256& msHash) const {
 }
 
 void Chain::PopOldest(const std::vector<uint256>& vtxToRemove, const TXOC& txocToRemove) {
+    nCachedBlks_ -= milestones_.front()->GetLevelSet().size();
+    nCachedTxs_ -= milestones_.front()->GetNumOfValidTxns();
+
     for (const auto& lvsh : vtxToRemove) {
         // Modify redemption status for those prev regs in DB
         const auto& vtx = GetVertexCache(lvsh);
@@ -592,42 +588,33 @@ bool Chain::IsTxFitsLedger(const ConstTxPtr& tx) const {
 // Cumulator
 ////////////////////
 
-void Cumulator::Add(const ConstBlockPtr& block, bool ascending) {
-    const auto& chainwork   = block->GetChainWork();
-    uint32_t chainwork_comp = chainwork.GetCompact();
+void Cumulator::Add(const ConstBlockPtr& block) {
+    const auto& chainwork = block->GetChainWork();
+
+    if (!buffer_ || end_ == buffer_->capacity || !buffer_->Claim(end_)) {
+        Relocate();
+        buffer_->Claim(end_);
+    }
 
-    if (timestamps.size() < GetParams().sortitionThreshold) {
+    // Note that the chainwork leaving the window is subtracted in its compact form
+    if (size_ < GetParams().sortitionThreshold) {
         sum += chainwork;
+        ++size_;
     } else {
-        arith_uint256 subtrahend = arith_uint256().SetCompact(chainworks.front().first);
-        sum += (chainwork - subtrahend);
-
-        // Pop the first element if the counter is already 1,
-        // or decrease the counter of the first element by 1
-        if (chainworks.front().second == 1) {
-            chainworks.pop_front();
-        } else {
-            chainworks.front().second--;
-        }
-
-        timestamps.pop_front();
+        sum += (chainwork - Front().chainwork);
     }
 
-    if (ascending) {
-        if (!chainworks.empty() && chainworks.back().first == chainwork_comp) {
-            chainworks.back().second++;
-        } else {
-            chainworks.emplace_back(chainwork_comp, 1);
-        }
-        timestamps.emplace_back(block->GetTime());
-    } else {
-        if (!chainworks.empty() && chainworks.front().first == chainwork_comp) {
-            chainworks.front().second++;
-        } else {
-            chainworks.emplace_front(chainwork_comp, 1);
-        }
-        timestamps.emplace_front(block->GetTime());
+    buffer_->entries[end_++] = {arith_uint256().SetCompact(chainwork.GetCompact()), block->GetTime()};
+}
+
+void Cumulator::Relocate() {
+    auto buffer = std::make_shared<Buffer>(GetParams().sortitionThreshold * 2);
+    if (buffer_) {
+        std::copy(buffer_->entries.get() + end_ - size_, buffer_->entries.get() + end_, buffer->entries.get());
     }
+    buffer->used = size_;
+    buffer_      = std::move(buffer);
+    end_         = size_;
 }
 
 arith_uint256 Cumulator::Sum() const {
@@ -635,36 +622,31 @@ arith_uint256 Cumulator::Sum() const {
 }
 
 uint32_t Cumulator::TimeSpan() const {
-    return timestamps.back() - timestamps.front();
+    return Back().timestamp - Front().timestamp;
 }
 
 bool Cumulator::Full() const {
-    return timestamps.size() == GetParams().sortitionThreshold;
+    return size_ == GetParams().sortitionThreshold;
 }
 
 bool Cumulator::Empty() const {
-    return timestamps.empty();
+    return size_ == 0;
 }
 
 void Cumulator::Clear() {
-    chainworks.clear();
-    timestamps.clear();
-    sum = 0;
+    buffer_.reset();
+    end_  = 0;
+    size_ = 0;
+    sum   = 0;
 }
 
 std::string std::to_string(const Cumulator& cum) {
     std::string s;
     s += " Cumulator { \n";
-    s += "   chainworks { \n";
-    for (auto& e : cum.chainworks) {
-        s += strprintf("     { %s, %s }\n", arith_uint256().SetCompact(e.first).GetLow64(), e.second);
-    }
-    s += "   }\n";
-    s += "   timestamps { \n";
-    for (auto& t : cum.timestamps) {
-        s += strprintf("     %s\n", t);
+    for (size_t i = cum.end_ - cum.size_; i < cum.end_; ++i) {
+        const auto& e = cum.buffer_->entries[i];
+        s += strprintf("     { %s, %s }\n", e.chainwork.GetLow64(), e.timestamp);
     }
-    s += "   }\n";
     s += " }";
 
     return s;
@@ -6,10 +6,15 @@
 #define EPIC_CHAIN_H
 
 #include "concurrent_container.h"
+#include "pending_graph.h"
+#include "tip_set.h"
 #include "vertex.h"
 
 #include <algorithm>
+#include <atomic>
 #include <deque>
+#include <memory>
+#include <mutex>
 #include <optional>
 #include <vector>
 
@@ -18,9 +23,23 @@ namespace std {
 string to_string(const Cumulator& b);
 } // namespace std
 
+/**
+ * Sliding window of the latest sortitionThreshold blocks of a miner chain,
+ * summing up their chainwork and measuring their time span.
+ *
+ * The window lives in a fixed-capacity buffer shared by all the copies of
+ * a cumulator. A copy extends the buffer in place as long as nobody else has
+ * claimed the next slot, and only moves its window to a new buffer when the
+ * miner chain forks or the buffer is used up, so that both sliding and
+ * copying are O(1) amortized.
+ */
 class Cumulator {
 public:
-    void Add(const ConstBlockPtr& block, bool ascending);
+    /**
+     * Slides the window forward by the block,
+     * which has to be the child of the last block added
+     */
+    void Add(const ConstBlockPtr& block);
     arith_uint256 Sum() const;
     uint32_t TimeSpan() const;
     bool Full() const;
@@ -30,15 +49,53 @@ public:
     friend std::string std::to_string(const Cumulator&);
 
 private:
-    // Elements in chainworks:
-    //      {chainwork, counter of consecutive chainworks that are equal}
-    // For example, the queue of chainworks
-    //      { 1, 1, 3, 2, 2, 2, 2, 2, 2, 2 }
-    // are stored as:
-    //      { {1, 2}, {3, 1}, {2, 7} }
-    std::deque<std::pair<uint32_t, uint16_t>> chainworks;
-    std::deque<uint32_t> timestamps;
+    struct Entry {
+        // chainwork decoded from its compact form
+        arith_uint256 chainwork;
+        uint32_t timestamp;
+    };
+
+    struct Buffer {
+        explicit Buffer(size_t capacity) : entries(new Entry[capacity]), capacity(capacity) {}
+
+        /**
+         * Returns true if the slot at pos is not used by any other cumulator
+         * and marks it as used by the caller
+         */
+        bool Claim(size_t pos) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (pos != used) {
+                return false;
+            }
+            ++used;
+            return true;
+        }
+
+        std::unique_ptr<Entry[]> entries;
+        const size_t capacity;
+        std::mutex mutex;
+        size_t used = 0;
+    };
+
+    std::shared_ptr<Buffer> buffer_;
+
+    // the window is [end_ - size_, end_) in the buffer
+    size_t end_  = 0;
+    size_t size_ = 0;
     arith_uint256 sum = 0;
+
+    const Entry& Front() const {
+        return buffer_->entries[end_ - size_];
+    }
+
+    const Entry& Back() const {
+        return buffer_->entries[end_ - 1];
+    }
+
+    /**
+     * Copies the window to the front of a new buffer
+     */
+    void Relocate();
 };
 
 /** Hasher for unordered_map */
@@ -74,6 +131,8 @@ public:
     std::size_t GetPendingBlockCount() const;
     std::vector<uint256> GetPendingHashes() const;
     ConstBlockPtr GetRandomTip() const;
+    /** Gets a random pending block not mined by this node */
+    ConstBlockPtr GetRandomForeignTip() const;
 
     VertexPtr GetVertexCache(const uint256&) const;
     VertexPtr GetVertex(const uint256&) const;
@@ -82,6 +141,9 @@ public:
     /** Gets a list of block to verify by the post-order DFS */
     std::vector<ConstBlockPtr> GetSortedSubgraph(const ConstBlockPtr& pblock);
 
+    /** Gets the same list as GetSortedSubgraph but keeps the blocks pending */
+    std::vector<ConstBlockPtr> PeekSortedSubgraph(const ConstBlockPtr& pblock) const;
+
     friend inline bool operator<(const Chain& a, const Chain& b) {
         auto a_chainwork = a.GetMilestones().empty() ? 0 : a.GetChainHead()->chainwork;
         auto b_chainwork = b.GetMilestones().empty() ? 0 : b.GetChainHead()->chainwork;
@@ -107,9 +169,16 @@ public:
     std::vector<uint256> GetPeerChainHead() const;
 
     void AddNewMilestone(const Vertex& ms) {
+        nCachedBlks_ += ms.snapshot->GetLevelSet().size();
+        nCachedTxs_ += ms.snapshot->GetNumOfValidTxns();
         milestones_.emplace_back(ms.snapshot);
     }
 
+    /** Gets the number of blocks and valid transactions in the cached milestones */
+    std::pair<size_t, size_t> GetCachedCount() const {
+        return {nCachedBlks_.load(), nCachedTxs_.load()};
+    }
+
     /**
      * Off-line verification (building ledger) on a level set
      * performed when we add a milestone block to this chain.
@@ -138,11 +207,27 @@ private:
      */
     ConcurrentQueue<MilestonePtr> milestones_;
 
+    /**
+     * Counts the level sets of milestones_ for statistics
+     */
+    std::atomic<size_t> nCachedBlks_{0};
+    std::atomic<size_t> nCachedTxs_{0};
+
     /**
      * Stores data not yet verified in this chain
      */
     ConcurrentHashMap<uint256, ConstBlockPtr> pendingBlocks_;
 
+    /**
+     * Indexes pendingBlocks_ for the constant-time sampling of tips
+     */
+    TipSet tips_;
+
+    /**
+     * Links pendingBlocks_ to their pending parents for sorting level sets
+     */
+    PendingGraph pendingGraph_;
+
     /**
      * Stores verified blocks on this chain as cache
      */
@@ -3,17 +3,25 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "dag_manager.h"
+#include "binary_trace.h"
 #include "block_store.h"
+#include "log.h"
 #include "peer_manager.h"
 #include "rpc_server.h"
+#include "tracing.h"
 
-DAGManager::DAGManager() : verifyThread_(1), syncPool_(1), storagePool_(1) {
+DAGManager::DAGManager()
+    : verifyThread_(1, LARGE_CAPACITY),
+      syncPool_(1, LARGE_CAPACITY),
+      serializeThread_(1, LARGE_CAPACITY),
+      storagePool_(1, LARGE_CAPACITY) {
     milestoneChains_.push(std::make_unique<Chain>());
     msVertices_.emplace(GENESIS->GetHash(), GENESIS_VERTEX);
 
     // Start threadpools
     verifyThread_.Start();
     syncPool_.Start();
+    serializeThread_.Start();
     storagePool_.Start();
 }
 
@@ -30,7 +38,7 @@ void DAGManager::RequestInv(uint256 fromHash, const size_t& length, PeerPtr peer
     syncPool_.Execute([peer = std::move(peer), fromHash = std::move(fromHash), length, this]() {
         std::vector<uint256> locator = ConstructLocator(fromHash, length, peer);
         if (locator.empty()) {
-            spdlog::debug("RequestInv return: locator is null");
+            LOG_DEBUG("RequestInv return: locator is null");
             return;
         }
 
@@ -47,8 +55,8 @@ void DAGManager::CallbackRequestInv(std::unique_ptr<Inv> inv, PeerPtr peer) {
     syncPool_.Execute([inv = std::move(inv), peer = std::move(peer), this]() {
         auto& result = inv->hashes;
         if (result.empty()) {
-            spdlog::info("Received an empty inv, which means we have reached the same height as the peer's {}.",
-                         peer->address.ToString());
+            LOG_INFO("Received an empty inv, which means we have reached the same height as the peer's {}.",
+                     peer->address.ToString());
             auto task = std::make_shared<GetDataTask>(GetDataTask::PENDING_SET, sync_task_timeout);
             peer->AddPendingGetDataTask(task);
             auto pending_request = std::make_unique<GetData>(task->type);
@@ -56,7 +64,7 @@ void DAGManager::CallbackRequestInv(std::unique_ptr<Inv> inv, PeerPtr peer) {
             peer->SendMessage(std::move(pending_request));
         } else if (result.size() == 1 && result.at(0) == GENESIS->GetHash()) {
             if (peer->GetLastGetInvEnd() == GENESIS->GetHash()) {
-                spdlog::info("peer {} response fork to genesis hash request", peer->address.ToString());
+                LOG_INFO("peer {} response fork to genesis hash request", peer->address.ToString());
                 peer->Disconnect();
                 return;
             }
@@ -66,7 +74,7 @@ void DAGManager::CallbackRequestInv(std::unique_ptr<Inv> inv, PeerPtr peer) {
                 length = max_get_inv_length;
             }
             RequestInv(peer->GetLastGetInvEnd(), length, peer);
-            spdlog::debug("We are probably on a fork... sending a larger locator.");
+            LOG_DEBUG("We are probably on a fork... sending a larger locator.");
         } else {
             RequestData(result, peer);
         }
@@ -81,19 +89,19 @@ void DAGManager::RespondRequestInv(std::vector<uint256>& locator, uint32_t nonce
         for (const uint256& start : locator) {
             if (start == GetMilestoneHead()->cblock->GetHash()) {
                 // The peer already reach our head. Send an empty inv.
-                spdlog::debug("The peer should already reach our head. Sending empty inv. "
-                              "Last bundle sent to this peer: {}",
-                              std::to_string(peer->GetLastSentBundleHash()));
+                LOG_DEBUG("The peer should already reach our head. Sending empty inv. "
+                          "Last bundle sent to this peer: {}",
+                          std::to_string(peer->GetLastSentBundleHash()));
                 std::vector<uint256> empty;
                 peer->SendMessage(std::make_unique<Inv>(empty, nonce));
                 return;
             }
             if (IsMainChainMS(start)) {
-                auto startMs = GetMsVertex(start);
                 // This locator intersects with our database. We now have a starting point.
                 // Traverse the milestone chain forward from the starting point itself.
-                spdlog::debug("Constructing inv... Found a starting point of height {}", startMs->height);
-                hashes = TraverseMilestoneForward(startMs, Inv::kMaxInventorySize);
+                size_t startHeight = GetHeight(start);
+                LOG_DEBUG("Constructing inv... Found a starting point of height {}", startHeight);
+                hashes = TraverseMilestoneForward(startHeight, Inv::kMaxInventorySize);
                 break;
             }
         }
@@ -123,10 +131,10 @@ void DAGManager::RespondRequestInv(std::vector<uint256>& locator, uint32_t nonce
             }
 
             if (hashes.empty()) {
-                spdlog::debug("Sublist of inv is empty. Sending empty inv. "
-                              "Last {} sent to this peer: {}",
-                              lih.IsNull() ? "bundle" : "inv",
-                              lih.IsNull() ? std::to_string(lbh) : std::to_string(lih));
+                LOG_DEBUG("Sublist of inv is empty. Sending empty inv. "
+                          "Last {} sent to this peer: {}",
+                          lih.IsNull() ? "bundle" : "inv",
+                          lih.IsNull() ? std::to_string(lbh) : std::to_string(lih));
             } else {
                 peer->SetLastSentInvHash(hashes.back());
             }
@@ -148,25 +156,70 @@ void DAGManager::RespondRequestLVS(const std::vector<uint256>& hashes,
     auto nc_iter = nonces.begin();
     while (hs_iter != hashes.end() && nc_iter != nonces.end()) {
         syncPool_.Execute([n = *nc_iter, h = *hs_iter, peer, this]() {
-            auto bundle  = std::make_unique<Bundle>(n);
-            auto payload = GetMainChainRawLevelSet(h);
-            if (payload.empty()) {
-                spdlog::debug("Milestone {} cannot be found. Sending a Not Found Message instead", h.to_substr());
-                peer->SendMessage(std::make_unique<NotFound>(h, n));
+            auto respond = [n, h, peer](VStream payload) {
+                if (payload.empty()) {
+                    LOG_DEBUG("Milestone {} cannot be found. Sending a Not Found Message instead", h.to_substr());
+                    peer->SendMessage(std::make_unique<NotFound>(h, n));
+                    return;
+                }
+
+                auto bundle = std::make_unique<Bundle>(n);
+                bundle->SetPayload(std::move(payload));
+                LOG_DEBUG("Sending bundle of LVS with nonce {} with MS hash {} to peer {}", n, h.to_substr(),
+                          peer->address.ToString());
+                peer->SetLastSentBundleHash(h);
+                peer->SendMessage(std::move(bundle));
+            };
+
+            size_t height = GetHeight(h);
+            if (height >= STORE->GetLowestHeight() && height < GetBestChain()->GetLeastHeightCached()) {
+                ReadAheadLevelSets(height);
+
+                if (auto cached = lvsCache_.Get(h)) {
+                    respond(*cached);
+                    return;
+                }
+
+                // Don't hold up the sync pool while reading files
+                STORE->GetRawLevelSetAtAsync(height, syncPool_,
+                                             [this, h, height, respond = std::move(respond)](VStream payload) {
+                                                 if (!payload.empty()) {
+                                                     lvsCache_.Put(h, height, payload);
+                                                 }
+                                                 respond(std::move(payload));
+                                             });
                 return;
             }
 
-            bundle->SetPayload(std::move(payload));
-            spdlog::debug("Sending bundle of LVS with nonce {} with MS hash {} to peer {}", n, h.to_substr(),
-                          peer->address.ToString());
-            peer->SetLastSentBundleHash(h);
-            peer->SendMessage(std::move(bundle));
+            respond(GetMainChainRawLevelSet(height));
         });
         hs_iter++;
         nc_iter++;
     }
 }
 
+void DAGManager::ReadAheadLevelSets(size_t height) {
+    if (height == 0 || !lvsCache_.ContainsHeight(height - 1)) {
+        return;
+    }
+
+    const size_t end = std::min(height + lvs_read_ahead + 1, GetBestChain()->GetLeastHeightCached());
+    for (size_t next = height + 1; next < end; ++next) {
+        uint256 msHash = STORE->GetMilestoneHashAt(next);
+        if (msHash.IsNull() || !lvsCache_.MarkReadAhead(msHash)) {
+            continue;
+        }
+
+        STORE->GetRawLevelSetAtAsync(next, syncPool_, [this, msHash, next](VStream payload) {
+            if (payload.empty()) {
+                lvsCache_.UnmarkReadAhead(msHash);
+                return;
+            }
+            lvsCache_.Put(msHash, next, std::move(payload));
+        });
+    }
+}
+
 void DAGManager::RequestData(std::vector<uint256>& requests, const PeerPtr& requestFrom) {
     auto message = std::make_unique<GetData>(GetDataTask::LEVEL_SET);
     for (auto& h : requests) {
@@ -180,16 +233,15 @@ void DAGManager::RequestData(std::vector<uint256>& requests, const PeerPtr& requ
         downloading_.insert(h);
 
         if (message->hashes.size() >= maxGetDataSize) {
-            spdlog::debug("Requesting lvs {} to {}", message->hashes.front().to_substr(),
-                          message->hashes.back().to_substr());
+            LOG_DEBUG("Requesting lvs {} to {}", message->hashes.front().to_substr(),
+                      message->hashes.back().to_substr());
             requestFrom->SendMessage(std::move(message));
             message = std::make_unique<GetData>(GetDataTask::LEVEL_SET);
         }
     }
 
     if (!message->hashes.empty()) {
-        spdlog::debug("Requesting lvs {} to {}", message->hashes.front().to_substr(),
-                      message->hashes.back().to_substr());
+        LOG_DEBUG("Requesting lvs {} to {}", message->hashes.front().to_substr(), message->hashes.back().to_substr());
         requestFrom->SendMessage(std::move(message));
     }
 }
@@ -207,45 +259,77 @@ std::vector<uint256> DAGManager::TraverseMilestoneBackward(VertexPtr cursor, siz
     std::vector<uint256> result;
     result.reserve(length);
 
-    for (int i = 0; i < length; ++i) {
-        assert(cursor);
+    // Walk milestone by milestone until the cursor joins the main chain
+    while (cursor && result.size() < length && !IsMainChainMS(cursor->cblock->GetHash())) {
         assert(cursor->isMilestone);
         result.push_back(cursor->cblock->GetHash());
-        if (cursor->cblock->GetHash() == GENESIS->GetHash()) {
+        cursor = GetMsVertex(cursor->cblock->GetMilestoneHash());
+    }
+
+    // milestones below the lowest height of a pruned node are gone
+    if (!cursor) {
+        return result;
+    }
+
+    // On the main chain milestones are indexed by height, so we can jump
+    const size_t lowest = STORE->GetLowestHeight();
+    size_t height       = cursor->height;
+    size_t stride       = 1;
+    while (result.size() < length) {
+        uint256 msHash = GetMainChainMsHashAt(height);
+        if (msHash.IsNull()) {
             break;
         }
-        cursor = GetMsVertex(cursor->cblock->GetMilestoneHash());
+        result.push_back(msHash);
+
+        if (height <= lowest) {
+            break;
+        }
+        if (result.size() >= locator_dense_length) {
+            stride = std::min(stride * 2, max_locator_stride);
+        }
+        height = height > lowest + stride ? height - stride : lowest;
     }
 
     return result;
 }
 
 std::vector<uint256> DAGManager::TraverseMilestoneForward(const VertexPtr cursor, size_t length) const {
+    return TraverseMilestoneForward(cursor->height, length);
+}
+
+std::vector<uint256> DAGManager::TraverseMilestoneForward(size_t fromHeight, size_t length) const {
     std::vector<uint256> result;
     result.reserve(length);
-    const auto bestChain = GetBestChain();
-    std::shared_lock<std::shared_mutex> reader(bestChain->GetMilestones().get_mutex());
-
-    size_t cursorHeight = cursor->height + 1;
 
-    // If the cursor height is less than the least height in cache, traverse DB.
-    while (cursorHeight <= STORE->GetHeadHeight() && result.size() <= length) {
-        result.push_back(STORE->GetMilestoneAt(cursorHeight)->cblock->GetHash());
-        ++cursorHeight;
+    for (size_t height = fromHeight + 1; result.size() < length; ++height) {
+        uint256 msHash = GetMainChainMsHashAt(height);
+        if (msHash.IsNull()) {
+            break;
+        }
+        result.push_back(msHash);
     }
 
-    if (!bestChain->GetMilestones().empty()) {
-        uint64_t min_height = bestChain->GetMilestones().front()->height;
-        uint64_t max_height = bestChain->GetMilestones().back()->height;
-        // If we have reached the hightest milestone in DB and still don't get enough hashes,
-        // continue to traverse the best chain cache until we reach the head or the capacity.
-        while (cursorHeight <= max_height && result.size() <= length) {
-            result.push_back(bestChain->GetMilestones()[cursorHeight - min_height]->GetMilestoneHash());
-            ++cursorHeight;
+    return result;
+}
+
+uint256 DAGManager::GetMainChainMsHashAt(size_t height) const {
+    const auto bestChain   = GetBestChain();
+    const auto& milestones = bestChain->GetMilestones();
+    std::shared_lock<std::shared_mutex> reader(milestones.get_mutex());
+
+    if (!milestones.empty()) {
+        size_t leastHeightCached = milestones.front()->height;
+        if (height >= leastHeightCached) {
+            if (height - leastHeightCached < milestones.size()) {
+                return milestones[height - leastHeightCached]->GetMilestoneHash();
+            }
+            return uint256();
         }
     }
 
-    return result;
+    // If the height is less than the least height in cache, look up DB.
+    return STORE->GetMilestoneHashAt(height);
 }
 
 void DAGManager::EnableOBC() {
@@ -262,21 +346,26 @@ void DAGManager::EnableOBC() {
 
 void DAGManager::AddNewBlock(ConstBlockPtr blk, PeerPtr peer) {
     verifyThread_.Execute([=, blk = std::move(blk), peer = std::move(peer)]() mutable {
-        spdlog::trace("[Verify Thread] Adding blocks to pending {}", blk->GetHash().to_substr());
+        TRACE_SPAN("AddNewBlock", blk->GetHash());
+        LOG_TRACE("[Verify Thread] Adding blocks to pending {}", blk->GetHash().to_substr());
         if (*blk == *GENESIS) {
-            spdlog::trace("[Syntax] Abort adding the genesis block.");
+            LOG_TRACE("[Syntax] Abort adding the genesis block.");
             return;
         }
 
         if (STORE->Exists(blk->GetHash())) {
-            spdlog::trace("[Syntax] Abort adding existed block [{}].", std::to_string(blk->GetHash()));
+            LOG_TRACE("[Syntax] Abort adding existed block [{}].", std::to_string(blk->GetHash()));
             return;
         }
+        TRACE_EVENT(BLOCK_RECEIVED, blk->GetHash());
 
         /////////////////////////////////
         // Start of online verification
 
         if (!blk->Verify()) {
+            if (peer) {
+                peer->quality.AddMessage(false);
+            }
             return;
         }
 
@@ -293,8 +382,10 @@ void DAGManager::AddNewBlock(ConstBlockPtr blk, PeerPtr peer) {
         // First, check if we already received its preceding blocks
         if (STORE->IsWeaklySolid(blk)) {
             if (STORE->AnyLinkIsOrphan(blk)) {
-                spdlog::info("[Syntax] Block is not solid (link in obc) with mask {} [{}]", mask(),
-                             blk->GetHash().to_substr());
+                LOG_INFO("[Syntax] Block is not solid (link in obc) with mask {} [{}]", mask(),
+                         blk->GetHash().to_substr());
+                TRACE_EVENT(BLOCK_ORPHANED, blk->GetHash(), mask());
+                rollingStat_.AddReceived(blk->GetTime(), true);
                 STORE->AddBlockToOBC(std::move(blk), mask());
                 return;
             }
@@ -307,8 +398,10 @@ void DAGManager::AddNewBlock(ConstBlockPtr blk, PeerPtr peer) {
                 return;
             }
             // Abort and send GetBlock requests.
-            spdlog::info("[Syntax] Block is not solid with mask {} [{}] prev {} tip {} ms {}", mask(),
-                         std::to_string(blk->GetHash()), prevHash.to_substr(), tipHash.to_substr(), msHash.to_substr());
+            TRACE_EVENT(BLOCK_ORPHANED, blk->GetHash(), mask());
+            rollingStat_.AddReceived(blk->GetTime(), true);
+            LOG_INFO("[Syntax] Block is not solid with mask {} [{}] prev {} tip {} ms {}", mask(),
+                     std::to_string(blk->GetHash()), prevHash.to_substr(), tipHash.to_substr(), msHash.to_substr());
             STORE->AddBlockToOBC(std::move(blk), mask());
 
             if (peer) {
@@ -322,14 +415,20 @@ void DAGManager::AddNewBlock(ConstBlockPtr blk, PeerPtr peer) {
 
         VertexPtr ms = GetMsVertex(msHash, false);
         if (!ms) {
-            spdlog::warn("[Syntax] Block has missing or invalid milestone link [{}]", blk->GetHash().to_substr());
+            LOG_WARN("[Syntax] Block has missing or invalid milestone link [{}]", blk->GetHash().to_substr());
+            if (peer) {
+                peer->quality.AddMessage(false);
+            }
             return;
         }
 
         uint32_t expectedTarget = ms->snapshot->blockTarget.GetCompact();
         if (blk->GetDifficultyTarget() != expectedTarget) {
-            spdlog::warn("[Syntax] Block has unexpected change in difficulty: current {} v.s. expected {} [{}]",
-                         blk->GetDifficultyTarget(), expectedTarget, blk->GetHash().to_substr());
+            LOG_WARN("[Syntax] Block has unexpected change in difficulty: current {} v.s. expected {} [{}]",
+                     blk->GetDifficultyTarget(), expectedTarget, blk->GetHash().to_substr());
+            if (peer) {
+                peer->quality.AddMessage(false);
+            }
             return;
         }
 
@@ -343,6 +442,7 @@ void DAGManager::AddNewBlock(ConstBlockPtr blk, PeerPtr peer) {
         /////////////////////////////////
 
         STORE->Cache(blk);
+        rollingStat_.AddReceived(blk->GetTime(), false);
 
         if (peer) {
             PEERMAN->RelayBlock(blk, peer);
@@ -360,8 +460,8 @@ bool DAGManager::CheckPuntuality(const ConstBlockPtr& blk, const VertexPtr& ms)
 
     auto bestHeight = GetBestMilestoneHeight();
     if (bestHeight > ms->height && (bestHeight - ms->height) >= GetParams().punctualityThred) {
-        spdlog::info("[Syntax] Block is too old: pointing to height {} vs. current head height {} [{}]", ms->height,
-                     bestHeight, std::to_string(blk->GetHash()));
+        LOG_INFO("[Syntax] Block is too old: pointing to height {} vs. current head height {} [{}]", ms->height,
+                 bestHeight, std::to_string(blk->GetHash()));
         return false;
     }
 
@@ -369,6 +469,9 @@ bool DAGManager::CheckPuntuality(const ConstBlockPtr& blk, const VertexPtr& ms)
 }
 
 void DAGManager::AddBlockToPending(const ConstBlockPtr& block) {
+    TRACE_EVENT(BLOCK_PENDING, block->GetHash());
+    TRACE_ASYNC_BEGIN("Pending", block->GetHash());
+
     // Extract utxos from outputs and pass their pointers to chains
     std::vector<UTXOPtr> utxos;
     const auto& txns = block->GetTransactions();
@@ -376,7 +479,7 @@ void DAGManager::AddBlockToPending(const ConstBlockPtr& block) {
         const auto& outs = txns[i]->GetOutputs();
         utxos.reserve(utxos.size() + outs.size());
         for (size_t j = 0; j < outs.size(); ++j) {
-            utxos.emplace_back(std::make_shared<UTXO>(outs[j], i, j));
+            utxos.emplace_back(CreateUTXO(outs[j], i, j));
         }
     }
 
@@ -388,6 +491,10 @@ void DAGManager::AddBlockToPending(const ConstBlockPtr& block) {
         }
     }
 
+    if (onBlockAddedCallback_) {
+        onBlockAddedCallback_(block);
+    }
+
     // Check if it's a new ms from the main chain
     auto const mainchain = GetBestChain();
     const auto& msHash   = block->GetMilestoneHash();
@@ -401,8 +508,8 @@ void DAGManager::AddBlockToPending(const ConstBlockPtr& block) {
         if (CheckMsPOW(block, ms)) {
             if (*msBlock->cblock == *GetMilestoneHead()->cblock) {
                 // new milestone on mainchain
-                spdlog::debug("[Verify Thread] Updating main chain head {} pointing to the previous MS {}",
-                              block->GetHash().to_substr(), block->GetMilestoneHash().to_substr());
+                LOG_DEBUG("[Verify Thread] Updating main chain head {} pointing to the previous MS {}",
+                          block->GetHash().to_substr(), block->GetMilestoneHash().to_substr());
                 ProcessMilestone(mainchain, block);
                 NotifyOnChainUpdated(block, true);
                 EnableOBC();
@@ -410,18 +517,19 @@ void DAGManager::AddBlockToPending(const ConstBlockPtr& block) {
                 FlushTrigger();
             } else {
                 // new fork
-                spdlog::debug(
+                LOG_DEBUG(
                     "[Verify Thread] A fork created with head {} pointing to the previous main chain MS {} --- "
                     "total chains {}",
                     block->GetHash().to_substr(), block->GetMilestoneHash().to_substr(), milestoneChains_.size());
+                rollingStat_.AddFork(block->GetTime());
                 auto new_fork = std::make_shared<Chain>(*mainchain, block);
                 ProcessMilestone(new_fork, block);
                 bool isMainchain = milestoneChains_.emplace(std::move(new_fork));
                 NotifyOnChainUpdated(block, isMainchain);
                 if (isMainchain) {
-                    spdlog::debug("[Verify Thread] Switched to the best chain: head from {} to {}",
-                                  mainchain->GetChainHead()->GetMilestoneHash().to_substr(),
-                                  GetBestChain()->GetChainHead()->GetMilestoneHash().to_substr());
+                    LOG_DEBUG("[Verify Thread] Switched to the best chain: head from {} to {}",
+                              mainchain->GetChainHead()->GetMilestoneHash().to_substr(),
+                              GetBestChain()->GetChainHead()->GetMilestoneHash().to_substr());
                 }
             }
         }
@@ -448,16 +556,16 @@ void DAGManager::AddBlockToPending(const ConstBlockPtr& block) {
             bool isMainchain;
             if (msBlock->cblock->GetHash() == chain->GetChainHead()->GetMilestoneHash()) {
                 // new milestone on fork
-                spdlog::debug("[Verify Thread] A fork grows with head {} pointing to the previous MS {}",
-                              block->GetHash().to_substr(), block->GetMilestoneHash().to_substr());
+                LOG_DEBUG("[Verify Thread] A fork grows with head {} pointing to the previous MS {}",
+                          block->GetHash().to_substr(), block->GetMilestoneHash().to_substr());
                 ProcessMilestone(*chainIt, block);
                 isMainchain = milestoneChains_.update_best(chainIt);
             } else {
                 // new fork
-                spdlog::debug("[Verify Thread] A fork created with head {} pointing to the previous forking MS {} --- "
-                              "total chains {}",
-                              block->GetHash().to_substr(), block->GetMilestoneHash().to_substr(),
-                              milestoneChains_.size());
+                LOG_DEBUG("[Verify Thread] A fork created with head {} pointing to the previous forking MS {} --- "
+                          "total chains {}",
+                          block->GetHash().to_substr(), block->GetMilestoneHash().to_substr(), milestoneChains_.size());
+                rollingStat_.AddFork(block->GetTime());
                 auto new_fork = std::make_shared<Chain>(*chain, block);
                 ProcessMilestone(new_fork, block);
                 isMainchain = milestoneChains_.emplace(std::move(new_fork));
@@ -465,9 +573,9 @@ void DAGManager::AddBlockToPending(const ConstBlockPtr& block) {
 
             NotifyOnChainUpdated(block, isMainchain);
             if (isMainchain) {
-                spdlog::debug("[Verify Thread] Switched to the best chain: head from {} to {}",
-                              mainchain->GetChainHead()->GetMilestoneHash().to_substr(),
-                              GetBestChain()->GetChainHead()->GetMilestoneHash().to_substr());
+                LOG_DEBUG("[Verify Thread] Switched to the best chain: head from {} to {}",
+                          mainchain->GetChainHead()->GetMilestoneHash().to_substr(),
+                          GetBestChain()->GetChainHead()->GetMilestoneHash().to_substr());
             }
             return;
         }
@@ -475,12 +583,14 @@ void DAGManager::AddBlockToPending(const ConstBlockPtr& block) {
 }
 
 void DAGManager::ProcessMilestone(const ChainPtr& chain, const ConstBlockPtr& block) {
+    TRACE_SPAN("ProcessMilestone", block->GetHash(), block->GetHash());
     auto newMs = chain->Verify(block);
     msVertices_.emplace(block->GetHash(), newMs);
     chain->AddNewMilestone(*newMs);
+    TRACE_EVENT(MILESTONE, block->GetHash(), newMs->height);
 
     if (EraseDownloading(block->GetHash())) {
-        spdlog::debug("[Verify Thread] Size of downloading = {}, removed successfully", downloading_.size());
+        LOG_DEBUG("[Verify Thread] Size of downloading = {}, removed successfully", downloading_.size());
     }
 }
 
@@ -504,8 +614,8 @@ void DAGManager::DeleteFork() {
                 }
                 msVertices_.erase((*it)->GetMilestoneHash());
             }
-            spdlog::info("[Verify Thread] Deleting fork with chain head {} --- total chains {}",
-                         (*chain_it)->GetChainHead()->GetMilestoneHash().to_substr(), milestoneChains_.size());
+            LOG_INFO("[Verify Thread] Deleting fork with chain head {} --- total chains {}",
+                     (*chain_it)->GetChainHead()->GetMilestoneHash().to_substr(), milestoneChains_.size());
             chain_it = milestoneChains_.erase(chain_it);
         } else {
             chain_it++;
@@ -527,7 +637,7 @@ VertexPtr DAGManager::GetMsVertex(const uint256& msHash, bool withBlock) const {
     // will happen only for finding ms of nonsolid block
     // may return nullptr when rpc is requesting some non-existing milestones
     auto ms = GetBestChain()->GetVertexCache(msHash);
-    spdlog::trace("Milestone with hash {} is not found", msHash.to_substr());
+    LOG_TRACE("Milestone with hash {} is not found", msHash.to_substr());
     return nullptr;
 }
 
@@ -536,16 +646,18 @@ ChainPtr DAGManager::GetBestChain() const {
 }
 
 void DAGManager::Stop() {
-    spdlog::info("Stopping DAG...");
+    LOG_INFO("Stopping DAG...");
     Wait();
     syncPool_.Stop();
     verifyThread_.Stop();
+    serializeThread_.Stop();
     storagePool_.Stop();
-    spdlog::info("DAG stopped");
+    LOG_INFO("DAG stopped");
 }
 
 void DAGManager::Wait() {
-    while (!verifyThread_.IsIdle() || !storagePool_.IsIdle() || !syncPool_.IsIdle()) {
+    while (flushing_ > 0 || !verifyThread_.IsIdle() || !serializeThread_.IsIdle() || !storagePool_.IsIdle() ||
+           !syncPool_.IsIdle()) {
         std::this_thread::yield();
     }
 }
@@ -582,6 +694,11 @@ void DAGManager::FlushTrigger() {
             fork_it++;
         }
 
+        // The rest will be flushed when the pipeline drains
+        if (flushing_ >= max_flushing_milestones) {
+            return;
+        }
+
         FlushToSTORE(*cursor);
     }
 
@@ -589,70 +706,77 @@ void DAGManager::FlushTrigger() {
 }
 
 void DAGManager::FlushToSTORE(MilestonePtr ms) {
-    spdlog::debug("[Verify Thread] Flushing {} at height {}", ms->GetMilestoneHash().to_substr(), ms->height);
+    TRACE_SPAN("FlushToSTORE", uint256{}, ms->GetMilestoneHash());
+    LOG_DEBUG("[Verify Thread] Flushing {} at height {}", ms->GetMilestoneHash().to_substr(), ms->height);
 
     UpdateStatOnLvsStored(ms);
 
-    // first store data to STORE
+    // first take a snapshot of the data to store
     auto [vtxToStore, utxoToStore, utxoToRemove] = GetBestChain()->GetDataToSTORE(ms);
+    std::vector<VertexPtr> lvs;
+    lvs.reserve(vtxToStore.size());
+    std::transform(vtxToStore.begin(), vtxToStore.end(), std::back_inserter(lvs),
+                   [](const VertexWPtr& vtx) { return vtx.lock(); });
 
     ms->stored = true;
-    storagePool_.Execute([=, vtxToStore = std::move(vtxToStore), utxoToStore = std::move(utxoToStore),
-                          utxoToRemove = std::move(utxoToRemove)]() mutable {
-        spdlog::debug("[Storage pool] Flushing {} vertices, {} utxos to store, {} utxos to remove", vtxToStore.size(),
-                      utxoToStore.size(), utxoToRemove.size());
+    ++flushing_;
 
-        std::vector<VertexPtr> blocksToListener;
-        blocksToListener.reserve(vtxToStore.size());
+    serializeThread_.Execute([=, lvs = std::move(lvs), utxoToStore = std::move(utxoToStore),
+                              utxoToRemove = std::move(utxoToRemove)]() mutable {
+        TRACE_SPAN("SerializeLevelSet", uint256{}, lvs.back()->cblock->GetHash());
+        auto serialized = BlockStore::SerializeLevelSet(lvs);
 
-        const auto& ms = *vtxToStore.back().lock();
-        STORE->StoreLevelSet(vtxToStore);
-        STORE->UpdatePrevRedemHashes(ms.snapshot->GetRegChange());
+        storagePool_.Execute([=, lvs = std::move(lvs), serialized = std::move(serialized),
+                              utxoToStore = std::move(utxoToStore), utxoToRemove = std::move(utxoToRemove)]() mutable {
+            TRACE_SPAN("StoreLevelSet", uint256{}, serialized.msHash);
+            LOG_DEBUG("[Storage pool] Flushing {} vertices, {} utxos to store, {} utxos to remove", lvs.size(),
+                      utxoToStore.size(), utxoToRemove.size());
 
-        for (auto& vtx : vtxToStore) {
-            blocksToListener.emplace_back(vtx.lock());
-            STORE->UnCache((*vtx.lock()).cblock->GetHash());
-        }
+            const auto& ms = *lvs.back();
+            STORE->StoreLevelSet(serialized);
+            STORE->UpdatePrevRedemHashes(ms.snapshot->GetRegChange());
 
-        for (const auto& [utxoKey, utxoPtr] : utxoToStore) {
-            STORE->AddUTXO(utxoKey, utxoPtr);
-        }
+            for (auto& vtx : lvs) {
+                STORE->UnCache(vtx->cblock->GetHash());
+            }
 
-        for (const auto& utxoKey : utxoToRemove) {
-            STORE->RemoveUTXO(utxoKey);
-        }
-        STORE->SaveHeadHeight(ms.height);
+            for (const auto& [utxoKey, utxoPtr] : utxoToStore) {
+                STORE->AddUTXO(utxoKey, utxoPtr);
+            }
 
-        // notify the listener
-        if (onLvsConfirmedCallback_) {
-            onLvsConfirmedCallback_(std::move(blocksToListener), utxoToStore, utxoToRemove);
-        }
+            for (const auto& utxoKey : utxoToRemove) {
+                STORE->RemoveUTXO(utxoKey);
+            }
+            STORE->SaveHeadHeight(ms.height);
 
-        // then remove the milestone from chains
-        std::vector<uint256> vtxHashes{};
-        vtxHashes.reserve(vtxToStore.size());
-        std::unordered_set<uint256> utxoCreated{};
-        utxoCreated.reserve(utxoToStore.size());
+            // then remove the milestone from chains
+            std::unordered_set<uint256> utxoCreated{};
+            utxoCreated.reserve(utxoToStore.size());
+            for (const auto& [key, value] : utxoToStore) {
+                utxoCreated.emplace(key);
+            }
 
-        for (auto& vtx : vtxToStore) {
-            vtxHashes.emplace_back((*vtx.lock()).cblock->GetHash());
-        }
+            TXOC txocToRemove{std::move(utxoCreated), utxoToRemove};
 
-        for (const auto& [key, value] : utxoToStore) {
-            utxoCreated.emplace(key);
-        }
+            verifyThread_.Execute([=, msHash = serialized.msHash, vtxHashes = std::move(serialized.hashes),
+                                   txocToRemove = std::move(txocToRemove)]() {
+                LOG_TRACE("[Verify Thread] Removing level set {} cache", msHash.to_substr());
+                msVertices_.erase(msHash);
+                for (auto& chain : milestoneChains_) {
+                    chain->PopOldest(vtxHashes, txocToRemove);
+                }
 
-        TXOC txocToRemove{std::move(utxoCreated), std::move(utxoToRemove)};
+                --flushing_;
+                FlushTrigger();
+            });
 
-        verifyThread_.Execute([=, msHash = ms.cblock->GetHash(), vtxHashes = std::move(vtxHashes),
-                               txocToRemove = std::move(txocToRemove)]() {
-            spdlog::trace("[Verify Thread] Removing level set {} cache", msHash.to_substr());
-            msVertices_.erase(msHash);
-            for (auto& chain : milestoneChains_) {
-                chain->PopOldest(vtxHashes, txocToRemove);
+            // notify the listener
+            if (onLvsConfirmedCallback_) {
+                TRACE_SPAN("OnLvsConfirmed", uint256{}, serialized.msHash);
+                onLvsConfirmedCallback_(std::move(lvs), std::move(utxoToStore), std::move(utxoToRemove));
             }
+            LOG_TRACE("[Storage Pool] End of flushing {}", serialized.msHash.to_substr());
         });
-        spdlog::trace("[Storage Pool] End of flushing {}", ms.cblock->GetHash().to_substr());
     });
 }
 
@@ -741,6 +865,11 @@ VStream DAGManager::GetMainChainRawLevelSet(size_t height) const {
     const auto bestChain     = GetBestChain();
     size_t leastHeightCached = bestChain->GetLeastHeightCached();
 
+    // Level sets either pruned or not received yet
+    if (height < STORE->GetLowestHeight() || height >= leastHeightCached + bestChain->GetMilestones().size()) {
+        return {};
+    }
+
     // Find in DB
     if (height < leastHeightCached) {
         return STORE->GetRawLevelSetAt(height);
@@ -780,15 +909,29 @@ void DAGManager::RegisterOnChainUpdatedCallback(OnChainUpdatedCallback&& func) {
     onChainUpdatedCallback_ = std::move(func);
 }
 
+void DAGManager::RegisterOnBlockAddedCallback(OnBlockAddedCallback&& func) {
+    onBlockAddedCallback_ = std::move(func);
+}
+
 StatData DAGManager::GetStatData() const {
     std::shared_lock<std::shared_mutex> lk(statLock_);
     return stat_;
 }
 
+std::vector<StatWindow> DAGManager::GetRecentStat() const {
+    return rollingStat_.GetWindows();
+}
+
 void DAGManager::UpdateStatOnLvsStored(const MilestonePtr& pms) {
+    const auto nTxs  = pms->GetNumOfValidTxns();
+    const auto nBlks = pms->GetLevelSet().size();
+    const auto tEnd  = pms->GetMilestone()->cblock->GetTime();
+    rollingStat_.AddLevelSet(tEnd, nBlks, nTxs);
+
     std::unique_lock<std::shared_mutex> lk(statLock_);
-    stat_.nTxCnt += pms->GetNumOfValidTxns();
-    stat_.nBlkCnt += pms->GetLevelSet().size();
+    stat_.nTxCnt += nTxs;
+    stat_.nBlkCnt += nBlks;
+    stat_.tEnd = tEnd;
     if (stat_.tStart == 0) {
         stat_.tStart = pms->GetLevelSet().front().lock()->cblock->GetTime();
     }
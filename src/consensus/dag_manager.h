@@ -6,6 +6,8 @@
 #define EPIC_DAG_MANAGER_H
 
 #include "chains.h"
+#include "lvs_cache.h"
+#include "rolling_stat.h"
 #include "sync_messages.h"
 #include "threadpool.h"
 
@@ -18,8 +20,9 @@ struct StatData {
     size_t nTxCnt;
     size_t nBlkCnt;
     uint32_t tStart;
+    uint32_t tEnd;
 
-    StatData() : nTxCnt(0), nBlkCnt(0), tStart(0) {}
+    StatData() : nTxCnt(0), nBlkCnt(0), tStart(0), tEnd(0) {}
 };
 
 class DAGManager {
@@ -76,11 +79,24 @@ public:
     std::vector<VertexPtr> GetLevelSet(const uint256&, bool withBlock = true) const;
 
     /**
-     * Starting from the given hash, traverses the main milestone chain
-     * backward/forward by the given length
+     * Starting from the given milestone, traverses the milestone chain
+     * backward with an exponential stride once it is on the main chain,
+     * which yields at most the given number of hashes
      */
     std::vector<uint256> TraverseMilestoneBackward(VertexPtr, size_t) const;
+
+    /**
+     * Starting from the given milestone, traverses the main milestone
+     * chain forward by the given length
+     */
     std::vector<uint256> TraverseMilestoneForward(const VertexPtr, size_t) const;
+    std::vector<uint256> TraverseMilestoneForward(size_t fromHeight, size_t) const;
+
+    /**
+     * Returns the hash of the main chain milestone at the height,
+     * or a null hash if there is none
+     */
+    uint256 GetMainChainMsHashAt(size_t height) const;
 
     // Checkout a milestone either in different chain or in db
     VertexPtr GetMsVertex(const uint256&, bool withBlock = true) const;
@@ -101,6 +117,8 @@ public:
 
     using OnChainUpdatedCallback = std::function<void(ConstBlockPtr, bool)>;
 
+    using OnBlockAddedCallback = std::function<void(const ConstBlockPtr&)>;
+
     /**
      * Actions to be performed by wallet when a level set is confirmed
      */
@@ -108,6 +126,12 @@ public:
 
     void RegisterOnChainUpdatedCallback(OnChainUpdatedCallback&& func);
 
+    /**
+     * Called on the verify thread when a block passes the checks and
+     * is added to the pending sets of the chains
+     */
+    void RegisterOnBlockAddedCallback(OnBlockAddedCallback&& func);
+
     void NotifyOnChainUpdated(ConstBlockPtr block, bool isMainchain) {
         if (onChainUpdatedCallback_) {
             onChainUpdatedCallback_(block, isMainchain);
@@ -124,6 +148,9 @@ public:
 
     StatData GetStatData() const;
 
+    /** Gets the rolling statistics over the last minute, hour and day */
+    std::vector<StatWindow> GetRecentStat() const;
+
     /**
      * Blocks the main thread from going forward
      * until DAG completes all the tasks
@@ -137,10 +164,36 @@ private:
     const uint32_t sync_task_timeout  = 180; // in seconds
     const uint32_t max_get_inv_length = 1000;
 
+    // A locator lists the most recent milestones one by one and then
+    // doubles the stride, which is capped at half an inv so that the
+    // inv answering it always contains milestones we don't have yet
+    const size_t locator_dense_length = 10;
+    const size_t max_locator_stride   = 500;
+
+    // Max number of milestones between being handed over
+    // for flushing and being removed from the cache
+    const size_t max_flushing_milestones = 8;
+
+    // Bytes of flushed level sets kept for serving sync requests, and
+    // the number of heights to read ahead for sequential requests
+    const size_t lvs_cache_capacity = 64 << 20;
+    const size_t lvs_read_ahead     = 8;
+
     ThreadPool verifyThread_;
     ThreadPool syncPool_;
+    ThreadPool serializeThread_;
     ThreadPool storagePool_;
 
+    /**
+     * Number of milestones in the flush pipeline
+     */
+    std::atomic_size_t flushing_ = 0;
+
+    /**
+     * Raw level sets recently sent to peers, shared by all of them
+     */
+    LevelSetCache lvsCache_{lvs_cache_capacity};
+
     /**
      * A list of hashes we've sent out in GetData requests.
      * Should be thread-safe.
@@ -165,16 +218,29 @@ private:
 
     OnChainUpdatedCallback onChainUpdatedCallback_ = nullptr;
 
+    OnBlockAddedCallback onBlockAddedCallback_ = nullptr;
+
     /**
      * a simple data structure to store statistic data from when the node starts
      */
     StatData stat_;
     mutable std::shared_mutex statLock_;
 
+    /**
+     * rolling windows of the same data as well as forks and orphans
+     */
+    RollingStat rollingStat_;
+
     void UpdateStatOnLvsStored(const MilestonePtr& pms);
 
     std::vector<uint256> ConstructLocator(const uint256& fromHash, size_t length, const PeerPtr&);
 
+    /**
+     * Reads the next few flushed level sets into lvsCache_ if
+     * the one below the height has been requested recently
+     */
+    void ReadAheadLevelSets(size_t height);
+
     /**
      * Start a new thread and create a list of GetData tasks that is either added
      * to preDownloading (if it's not empty) or a peer's task queue. If preDownloading
@@ -215,7 +281,12 @@ private:
      */
     void FlushTrigger();
 
-    // flush the oldest milestone
+    /**
+     * Flushes the oldest milestone through a pipeline of
+     * serialization, appending to files and DB, and cache eviction,
+     * each stage on its own thread. The verify thread only hands over
+     * a snapshot of the level set and the UTXOs it creates and spends
+     */
     void FlushToSTORE(MilestonePtr);
 
     void EnableOBC();
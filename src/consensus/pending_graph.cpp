@@ -0,0 +1,176 @@
+// Copyright (c) 2019 EPI-ONE Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "pending_graph.h"
+
+#include <algorithm>
+
+PendingGraph::PendingGraph(const PendingGraph& other) {
+    std::lock_guard<std::mutex> lock(other.mutex_);
+    nodes_.reserve(other.nodes_.size());
+    for (const auto& [hash, node] : other.nodes_) {
+        InsertNode(node->block);
+    }
+}
+
+void PendingGraph::Insert(const ConstBlockPtr& block) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    InsertNode(block);
+}
+
+size_t PendingGraph::Size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return nodes_.size();
+}
+
+std::vector<ConstBlockPtr> PendingGraph::ExtractSorted(const ConstBlockPtr& block) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<Node*> visited;
+    auto result = Traverse(block, visited);
+    Remove(visited);
+    return result;
+}
+
+std::vector<ConstBlockPtr> PendingGraph::GetSorted(const ConstBlockPtr& block) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<Node*> visited;
+    return Traverse(block, visited);
+}
+
+std::array<uint256, 3> PendingGraph::GetParentHashes(const Block& block) {
+    return {block.GetMilestoneHash(), block.GetPrevHash(), block.GetTipHash()};
+}
+
+void PendingGraph::InsertNode(const ConstBlockPtr& block) {
+    const auto& hash = block->GetHash();
+    auto& slot       = nodes_[hash];
+    if (slot) {
+        slot->block = block;
+        return;
+    }
+    slot        = std::make_unique<Node>();
+    Node* node  = slot.get();
+    node->block = block;
+
+    const auto parentHashes = GetParentHashes(*block);
+    for (size_t i = 0; i < parentHashes.size(); ++i) {
+        auto it = nodes_.find(parentHashes[i]);
+        if (it == nodes_.end()) {
+            waiting_[parentHashes[i]].push_back(node);
+            continue;
+        }
+
+        // the same parent may be referred to more than once
+        Node* parent = it->second.get();
+        if (std::find(node->parents.begin(), node->parents.end(), parent) == node->parents.end()) {
+            parent->children.push_back(node);
+        }
+        node->parents[i] = parent;
+    }
+
+    // link the children inserted earlier
+    auto waiting = waiting_.find(hash);
+    if (waiting == waiting_.end()) {
+        return;
+    }
+    for (Node* child : waiting->second) {
+        bool linked             = false;
+        const auto childParents = GetParentHashes(*child->block);
+        for (size_t i = 0; i < childParents.size(); ++i) {
+            if (!child->parents[i] && childParents[i] == hash) {
+                child->parents[i] = node;
+                linked            = true;
+            }
+        }
+        if (linked) {
+            node->children.push_back(child);
+        }
+    }
+    waiting_.erase(waiting);
+}
+
+std::vector<ConstBlockPtr> PendingGraph::Traverse(const ConstBlockPtr& block, std::vector<Node*>& visited) const {
+    const uint64_t epoch = ++epoch_;
+
+    // the block itself may not be pending
+    Node temp;
+    Node* start = &temp;
+    auto it     = nodes_.find(block->GetHash());
+    if (it != nodes_.end()) {
+        start = it->second.get();
+    } else {
+        temp.block        = block;
+        const auto hashes = GetParentHashes(*block);
+        for (size_t i = 0; i < hashes.size(); ++i) {
+            auto parent = nodes_.find(hashes[i]);
+            if (parent != nodes_.end()) {
+                temp.parents[i] = parent->second.get();
+            }
+        }
+    }
+
+    std::vector<ConstBlockPtr> result;
+    std::vector<Node*> stack = {start};
+    while (!stack.empty()) {
+        Node* cursor = stack.back();
+
+        auto next = std::find_if(cursor->parents.begin(), cursor->parents.end(),
+                                 [epoch](const Node* parent) { return parent && parent->mark != epoch; });
+        if (next != cursor->parents.end()) {
+            stack.push_back(*next);
+            continue;
+        }
+
+        cursor->mark = epoch;
+        result.push_back(cursor->block);
+        if (cursor != &temp) {
+            visited.push_back(cursor);
+        }
+        stack.pop_back();
+    }
+
+    return result;
+}
+
+void PendingGraph::Remove(const std::vector<Node*>& visited) {
+    const uint64_t epoch = epoch_;
+    for (Node* node : visited) {
+        const auto& hash = node->block->GetHash();
+
+        // the children left wait for the block to be inserted again
+        for (Node* child : node->children) {
+            if (child->mark == epoch) {
+                continue;
+            }
+            for (auto& parent : child->parents) {
+                if (parent == node) {
+                    parent = nullptr;
+                }
+            }
+            waiting_[hash].push_back(child);
+        }
+
+        const auto parentHashes = GetParentHashes(*node->block);
+        for (size_t i = 0; i < parentHashes.size(); ++i) {
+            Node* parent = node->parents[i];
+            if (parent && parent->mark != epoch) {
+                auto& siblings = parent->children;
+                siblings.erase(std::remove(siblings.begin(), siblings.end(), node), siblings.end());
+            } else if (!parent) {
+                auto waiting = waiting_.find(parentHashes[i]);
+                if (waiting != waiting_.end()) {
+                    auto& nodes = waiting->second;
+                    nodes.erase(std::remove(nodes.begin(), nodes.end(), node), nodes.end());
+                    if (nodes.empty()) {
+                        waiting_.erase(waiting);
+                    }
+                }
+            }
+        }
+    }
+
+    for (Node* node : visited) {
+        nodes_.erase(node->block->GetHash());
+    }
+}
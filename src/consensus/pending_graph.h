@@ -0,0 +1,75 @@
+// Copyright (c) 2019 EPI-ONE Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef EPIC_PENDING_GRAPH_H
+#define EPIC_PENDING_GRAPH_H
+
+#include "block.h"
+
+#include <array>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * The pending blocks of a chain linked to their pending milestone, previous
+ * and tip blocks as they are inserted, in any order, so that the level set
+ * of a new milestone is sorted by following pointers instead of looking up
+ * the parents of every visited block in a hash map.
+ */
+class PendingGraph {
+public:
+    PendingGraph() = default;
+    PendingGraph(const PendingGraph&);
+    PendingGraph& operator=(const PendingGraph&) = delete;
+
+    /** Inserts the block, or replaces the one of the same hash */
+    void Insert(const ConstBlockPtr&);
+    size_t Size() const;
+
+    /**
+     * Gets the block and its pending ancestors in the post order of the DFS
+     * visiting the milestone, previous and tip blocks in turn, and removes
+     * them from the graph
+     */
+    std::vector<ConstBlockPtr> ExtractSorted(const ConstBlockPtr&);
+
+    /**
+     * Gets the same blocks as ExtractSorted without removing them,
+     * i.e., the blocks that the block would confirm as a milestone
+     */
+    std::vector<ConstBlockPtr> GetSorted(const ConstBlockPtr&) const;
+
+private:
+    struct Node {
+        ConstBlockPtr block;
+        // the pending milestone, previous and tip blocks, or nullptr if not pending
+        std::array<Node*, 3> parents{};
+        std::vector<Node*> children;
+        uint64_t mark = 0;
+    };
+
+    mutable std::mutex mutex_;
+    std::unordered_map<uint256, std::unique_ptr<Node>> nodes_;
+
+    // the nodes linked to their parents once the parents are inserted
+    std::unordered_map<uint256, std::vector<Node*>> waiting_;
+
+    // marks the visited nodes of a traversal
+    mutable uint64_t epoch_ = 0;
+
+    static std::array<uint256, 3> GetParentHashes(const Block&);
+
+    void InsertNode(const ConstBlockPtr&);
+
+    /**
+     * the post-order DFS from the block, which returns the blocks visited
+     * and fills the visited nodes, excluding the block if not in the graph
+     */
+    std::vector<ConstBlockPtr> Traverse(const ConstBlockPtr&, std::vector<Node*>& visited) const;
+    void Remove(const std::vector<Node*>& visited);
+};
+
+#endif // EPIC_PENDING_GRAPH_H
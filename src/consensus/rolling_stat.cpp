@@ -0,0 +1,132 @@
+// Copyright (c) 2019 EPI-ONE Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "rolling_stat.h"
+
+#include <algorithm>
+#include <mutex>
+
+StatCounters& StatCounters::operator+=(const StatCounters& other) {
+    nBlks += other.nBlks;
+    nTxs += other.nTxs;
+    nLvs += other.nLvs;
+    nForks += other.nForks;
+    nOrphans += other.nOrphans;
+    nReceived += other.nReceived;
+    return *this;
+}
+
+StatCounters& StatCounters::operator-=(const StatCounters& other) {
+    nBlks -= other.nBlks;
+    nTxs -= other.nTxs;
+    nLvs -= other.nLvs;
+    nForks -= other.nForks;
+    nOrphans -= other.nOrphans;
+    nReceived -= other.nReceived;
+    return *this;
+}
+
+double StatWindow::GetTPS() const {
+    auto span = std::min(seconds, timeTo - timeFrom);
+    return span ? counters.nTxs / static_cast<double>(span) : 0;
+}
+
+double StatWindow::GetAvgLvsSize() const {
+    return counters.nLvs ? counters.nBlks / static_cast<double>(counters.nLvs) : 0;
+}
+
+double StatWindow::GetOrphanRate() const {
+    return counters.nReceived ? counters.nOrphans / static_cast<double>(counters.nReceived) : 0;
+}
+
+RollingStat::RollingStat() {
+    for (size_t i = 0; i < WINDOWS.size(); ++i) {
+        windows_[i].granularity = WINDOWS[i] / NBUCKETS;
+    }
+}
+
+void RollingStat::AddLevelSet(uint32_t time, uint64_t nBlks, uint64_t nTxs) {
+    StatCounters counters;
+    counters.nBlks = nBlks;
+    counters.nTxs  = nTxs;
+    counters.nLvs  = 1;
+    Add(time, counters);
+}
+
+void RollingStat::AddFork(uint32_t time) {
+    StatCounters counters;
+    counters.nForks = 1;
+    Add(time, counters);
+}
+
+void RollingStat::AddReceived(uint32_t time, bool orphan) {
+    StatCounters counters;
+    counters.nReceived = 1;
+    counters.nOrphans  = orphan;
+    Add(time, counters);
+}
+
+StatWindow RollingStat::GetWindow(uint32_t seconds) const {
+    auto it = std::find(WINDOWS.begin(), WINDOWS.end(), seconds);
+    if (it == WINDOWS.end()) {
+        return {};
+    }
+
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    const auto& buckets = windows_[it - WINDOWS.begin()];
+
+    // the window starts at the oldest bucket kept
+    const uint64_t start = buckets.head + 1 > NBUCKETS ? (buckets.head + 1 - NBUCKETS) * buckets.granularity : 0;
+
+    StatWindow window;
+    window.seconds  = seconds;
+    window.timeTo   = tLast_;
+    window.timeFrom = std::max<uint64_t>(tFirst_, start);
+    window.counters = buckets.sum;
+    return window;
+}
+
+std::vector<StatWindow> RollingStat::GetWindows() const {
+    std::vector<StatWindow> windows;
+    windows.reserve(WINDOWS.size());
+    for (auto seconds : WINDOWS) {
+        windows.emplace_back(GetWindow(seconds));
+    }
+    return windows;
+}
+
+void RollingStat::Add(uint32_t time, const StatCounters& counters) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    if (tFirst_ == 0 || time < tFirst_) {
+        tFirst_ = time;
+    }
+    tLast_ = std::max(tLast_, time);
+
+    for (auto& window : windows_) {
+        window.Add(time, counters);
+    }
+}
+
+void RollingStat::Window::Add(uint32_t time, const StatCounters& counters) {
+    const uint64_t index = time / granularity;
+
+    // drops the events older than the window
+    if (index + NBUCKETS <= head) {
+        return;
+    }
+
+    // expires the buckets the window slides over
+    if (index > head) {
+        const uint64_t steps = std::min<uint64_t>(index - head, NBUCKETS);
+        for (uint64_t i = 1; i <= steps; ++i) {
+            auto& bucket = buckets[(head + i) % NBUCKETS];
+            sum -= bucket;
+            bucket = {};
+        }
+        head = index;
+    }
+
+    buckets[index % NBUCKETS] += counters;
+    sum += counters;
+}
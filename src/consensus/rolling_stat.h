@@ -0,0 +1,80 @@
+// Copyright (c) 2019 EPI-ONE Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef EPIC_ROLLING_STAT_H
+#define EPIC_ROLLING_STAT_H
+
+#include <array>
+#include <cstdint>
+#include <shared_mutex>
+#include <vector>
+
+struct StatCounters {
+    uint64_t nBlks     = 0;
+    uint64_t nTxs      = 0;
+    uint64_t nLvs      = 0;
+    uint64_t nForks    = 0;
+    uint64_t nOrphans  = 0;
+    uint64_t nReceived = 0;
+
+    StatCounters& operator+=(const StatCounters&);
+    StatCounters& operator-=(const StatCounters&);
+};
+
+struct StatWindow {
+    uint32_t seconds  = 0;
+    uint32_t timeFrom = 0;
+    uint32_t timeTo   = 0;
+    StatCounters counters;
+
+    double GetTPS() const;
+    double GetAvgLvsSize() const;
+    double GetOrphanRate() const;
+};
+
+/**
+ * Counters of the recent chain over the last minute, hour and day, updated
+ * as events are recorded and read in constant time. Each window is a ring
+ * of NBUCKETS buckets summed incrementally, so that a window spans its
+ * length up to the granularity of a bucket. The time is the block time, so
+ * windows are relative to the newest block recorded rather than the clock.
+ */
+class RollingStat {
+public:
+    static constexpr std::array<uint32_t, 3> WINDOWS = {60, 60 * 60, 24 * 60 * 60};
+
+    RollingStat();
+
+    /** Records a level set stored with its milestone time */
+    void AddLevelSet(uint32_t time, uint64_t nBlks, uint64_t nTxs);
+    void AddFork(uint32_t time);
+    /** Records a block received, either added to pending or put aside as an orphan */
+    void AddReceived(uint32_t time, bool orphan);
+
+    /** Gets the counters over the window of the seconds in WINDOWS */
+    StatWindow GetWindow(uint32_t seconds) const;
+    std::vector<StatWindow> GetWindows() const;
+
+private:
+    static constexpr size_t NBUCKETS = 60;
+
+    struct Window {
+        uint32_t granularity;
+        // the index of the newest bucket, i.e., time / granularity
+        uint64_t head = 0;
+        std::array<StatCounters, NBUCKETS> buckets{};
+        StatCounters sum;
+
+        void Add(uint32_t time, const StatCounters&);
+    };
+
+    mutable std::shared_mutex mutex_;
+    std::array<Window, WINDOWS.size()> windows_;
+    uint32_t tFirst_ = 0;
+    uint32_t tLast_  = 0;
+
+    void Add(uint32_t time, const StatCounters&);
+};
+
+#endif // EPIC_ROLLING_STAT_H
@@ -0,0 +1,102 @@
+// Copyright (c) 2019 EPI-ONE Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "tip_set.h"
+
+#include <mutex>
+#include <random>
+
+TipSet::TipSet(const TipSet& other) {
+    std::shared_lock<std::shared_mutex> lock(other.mutex_);
+    all_     = other.all_;
+    foreign_ = other.foreign_;
+}
+
+TipSet& TipSet::operator=(const TipSet& other) {
+    if (this != &other) {
+        std::unique_lock<std::shared_mutex> lock(mutex_, std::defer_lock);
+        std::shared_lock<std::shared_mutex> otherLock(other.mutex_, std::defer_lock);
+        std::lock(lock, otherLock);
+        all_     = other.all_;
+        foreign_ = other.foreign_;
+    }
+    return *this;
+}
+
+void TipSet::Insert(const ConstBlockPtr& block) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    all_.Insert(block);
+    if (block->source == Block::MINER) {
+        foreign_.Erase(block->GetHash());
+    } else {
+        foreign_.Insert(block);
+    }
+}
+
+bool TipSet::Erase(const uint256& hash) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    foreign_.Erase(hash);
+    return all_.Erase(hash);
+}
+
+void TipSet::Clear() {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    all_     = {};
+    foreign_ = {};
+}
+
+size_t TipSet::Size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return all_.blocks.size();
+}
+
+bool TipSet::Contains(const uint256& hash) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return all_.index.count(hash);
+}
+
+ConstBlockPtr TipSet::Random() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return all_.Random();
+}
+
+ConstBlockPtr TipSet::RandomForeign() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return foreign_.Random();
+}
+
+void TipSet::DenseSet::Insert(const ConstBlockPtr& block) {
+    auto [it, inserted] = index.emplace(block->GetHash(), blocks.size());
+    if (inserted) {
+        blocks.push_back(block);
+    } else {
+        blocks[it->second] = block;
+    }
+}
+
+bool TipSet::DenseSet::Erase(const uint256& hash) {
+    auto it = index.find(hash);
+    if (it == index.end()) {
+        return false;
+    }
+
+    // fill the hole with the last block
+    auto pos = it->second;
+    index.erase(it);
+    if (pos != blocks.size() - 1) {
+        blocks[pos]                   = std::move(blocks.back());
+        index[blocks[pos]->GetHash()] = pos;
+    }
+    blocks.pop_back();
+    return true;
+}
+
+ConstBlockPtr TipSet::DenseSet::Random() const {
+    if (blocks.empty()) {
+        return nullptr;
+    }
+
+    thread_local std::mt19937_64 gen{std::random_device{}()};
+    return blocks[std::uniform_int_distribution<size_t>(0, blocks.size() - 1)(gen)];
+}
@@ -0,0 +1,56 @@
+// Copyright (c) 2019 EPI-ONE Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef EPIC_TIP_SET_H
+#define EPIC_TIP_SET_H
+
+#include "block.h"
+
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * The pending blocks of a chain as candidate tips of new blocks, kept
+ * in a dense vector indexed by hash, so that a uniformly random tip is
+ * sampled, inserted and removed in O(1). The blocks not mined by this
+ * node are indexed once more, so that the miner samples among them
+ * without retrying.
+ */
+class TipSet {
+public:
+    TipSet() = default;
+    TipSet(const TipSet&);
+    TipSet& operator=(const TipSet&);
+
+    /** Inserts the block, or replaces the one of the same hash */
+    void Insert(const ConstBlockPtr&);
+    bool Erase(const uint256&);
+    void Clear();
+
+    size_t Size() const;
+    bool Contains(const uint256&) const;
+
+    /** Returns a uniformly random tip, or nullptr if there is none */
+    ConstBlockPtr Random() const;
+
+    /** Returns a uniformly random tip not mined by this node, or nullptr if there is none */
+    ConstBlockPtr RandomForeign() const;
+
+private:
+    struct DenseSet {
+        std::vector<ConstBlockPtr> blocks;
+        std::unordered_map<uint256, size_t> index;
+
+        void Insert(const ConstBlockPtr&);
+        bool Erase(const uint256&);
+        ConstBlockPtr Random() const;
+    };
+
+    mutable std::shared_mutex mutex_;
+    DenseSet all_;
+    DenseSet foreign_;
+};
+
+#endif // EPIC_TIP_SET_H
@@ -4,12 +4,84 @@
 
 #include "utxo.h"
 #include "block_store.h"
+#include "opcodes.h"
+#include "pool_allocator.h"
+
+//////////////////////
+// CompactListing
+//
+CompactListing::CompactListing(const tasm::Listing& listing) {
+    // a VERIFY of a serialized string no longer than an address, whose length takes a single byte
+    const auto& data = listing.data;
+    if (listing.program.size() == 1 && listing.program[0] == tasm::VERIFY && data.size() > 1 &&
+        data.size() <= MAX_ADDRESS_SIZE + 1 && static_cast<uint8_t>(data[0]) == data.size() - 1) {
+        Address address{static_cast<uint8_t>(data.size() - 1), {}};
+        std::copy(data.begin() + 1, data.end(), address.text.begin());
+        content_ = address;
+        return;
+    }
+
+    content_ = std::make_shared<tasm::Listing>(listing);
+}
+
+std::optional<CKeyID> CompactListing::GetKeyID() const {
+    if (GetTemplate() == ADDRESS) {
+        return DecodeAddress(GetAddress());
+    }
+    return {};
+}
+
+tasm::Listing CompactListing::Expand() const {
+    if (GetTemplate() == ADDRESS) {
+        const auto& address = std::get<ADDRESS>(content_);
+        tasm::Listing listing;
+        listing.program = {tasm::VERIFY};
+        listing.data.reserve(address.size + 1);
+        listing.data.push_back(static_cast<char>(address.size));
+        listing.data.insert(listing.data.end(), address.text.begin(), address.text.begin() + address.size);
+        return listing;
+    }
+
+    const auto& listing = std::get<RAW>(content_);
+    return listing ? *listing : tasm::Listing{};
+}
+
+bool CompactListing::operator==(const CompactListing& another) const {
+    if (GetTemplate() != another.GetTemplate()) {
+        return false;
+    }
+    if (GetTemplate() == ADDRESS) {
+        const auto& a = std::get<ADDRESS>(content_);
+        const auto& b = std::get<ADDRESS>(another.content_);
+        return a.size == b.size && std::equal(a.text.begin(), a.text.begin() + a.size, b.text.begin());
+    }
+    return Expand() == another.Expand();
+}
+
+std::string CompactListing::GetAddress() const {
+    const auto& address = std::get<ADDRESS>(content_);
+    return std::string(address.text.begin(), address.text.begin() + address.size);
+}
+
+void CompactListing::SetAddress(const std::string& str) {
+    if (str.size() > MAX_ADDRESS_SIZE) {
+        throw std::ios_base::failure("Address too long");
+    }
+
+    Address address{static_cast<uint8_t>(str.size()), {}};
+    std::copy(str.begin(), str.end(), address.text.begin());
+    content_ = address;
+}
 
 //////////////////////
 // UTXO
 //
+UTXOPtr CreateUTXO(const TxOutput& output, uint32_t txIdx, uint32_t outIdx) {
+    return std::allocate_shared<UTXO>(pool_allocator<UTXO>(), output, txIdx, outIdx);
+}
+
 uint256 UTXO::GetContainingBlkHash() const {
-    return output_.GetParentTx()->GetParentBlock()->GetHash();
+    return parentTx_->GetParentBlock()->GetHash();
 }
 
 uint256 UTXO::GetKey() const {
@@ -150,8 +222,8 @@ bool ChainLedger::IsSpendable(const uint256& utxokey) const {
 std::string std::to_string(const UTXO& utxo) {
     std::string s;
     s += "UTXO { \n";
-    s += "   " + std::to_string(utxo.output_) + " with index " + std::to_string(utxo.txIndex_) + ", " +
-         std::to_string(utxo.outIndex_);
+    s += "   " + std::to_string(TxOutput{utxo.value_, utxo.GetListing()}) + " with index " +
+         std::to_string(utxo.txIndex_) + ", " + std::to_string(utxo.outIndex_);
     s += "   }";
     return s;
 }
@@ -7,8 +7,12 @@
 
 #include "block.h"
 #include "increment.h"
+#include "pubkey.h"
 
+#include <array>
+#include <optional>
 #include <unordered_set>
+#include <variant>
 
 class UTXO;
 class TXOC;
@@ -20,36 +24,133 @@ string to_string(const TXOC&);
 string to_string(const ChainLedger&);
 } // namespace std
 
+/**
+ * A listing stored compactly. The standard pay-to-address listing, i.e., the
+ * one of Transaction::AddOutput(coin, addr), is recognized by its program and
+ * the length prefix of its data, and its address is kept inline, so that it is
+ * recognized and rebuilt without decoding base58. Any other listing is kept as
+ * is behind a shared pointer.
+ *
+ * When serialized, an address collapses further to a tag and the key ID.
+ */
+class CompactListing {
+public:
+    enum Template : uint8_t { RAW = 0, ADDRESS = 1 };
+
+    // the longest base58 encoding of an address, i.e., of 25 bytes
+    static constexpr size_t MAX_ADDRESS_SIZE = 35;
+
+    CompactListing() = default;
+    explicit CompactListing(const tasm::Listing&);
+
+    Template GetTemplate() const {
+        return content_.index() == 0 ? RAW : ADDRESS;
+    }
+
+    /** Decodes the key ID of a pay-to-address listing */
+    std::optional<CKeyID> GetKeyID() const;
+
+    /** Rebuilds the original listing */
+    tasm::Listing Expand() const;
+
+    bool operator==(const CompactListing& another) const;
+
+    template <typename Stream>
+    void Serialize(Stream& s) const {
+        // collapses only if the address is rebuilt byte by byte from the key ID
+        if (GetTemplate() == ADDRESS) {
+            auto keyId = GetKeyID();
+            if (keyId && EncodeAddress(*keyId) == GetAddress()) {
+                ::Serialize(s, static_cast<uint8_t>(ADDRESS));
+                ::Serialize(s, *keyId);
+                return;
+            }
+        }
+
+        ::Serialize(s, static_cast<uint8_t>(RAW));
+        ::Serialize(s, Expand());
+    }
+
+    template <typename Stream>
+    void Deserialize(Stream& s) {
+        uint8_t tag;
+        ::Deserialize(s, tag);
+
+        switch (tag) {
+            case RAW: {
+                tasm::Listing listing;
+                ::Deserialize(s, listing);
+                *this = CompactListing(listing);
+                break;
+            }
+            case ADDRESS: {
+                CKeyID keyId;
+                ::Deserialize(s, keyId);
+                SetAddress(EncodeAddress(keyId));
+                break;
+            }
+            default:
+                throw std::ios_base::failure("Unknown listing template");
+        }
+    }
+
+private:
+    struct Address {
+        uint8_t size;
+        std::array<char, MAX_ADDRESS_SIZE> text;
+    };
+
+    std::variant<std::shared_ptr<tasm::Listing>, Address> content_;
+
+    std::string GetAddress() const;
+    void SetAddress(const std::string&);
+};
+
 /**
  * UTXO stands for unspend transaction output
  */
 class UTXO {
 public:
     UTXO(const TxOutput& output, uint32_t txIdx, uint32_t outIdx)
-        : output_(output), txIndex_(txIdx), outIndex_(outIdx) {}
+        : value_(output.value), listing_(output.listingContent), parentTx_(output.GetParentTx()), txIndex_(txIdx),
+          outIndex_(outIdx) {}
 
     UTXO(const UTXO&) = default;
 
     explicit UTXO(VStream& s) : txIndex_(-1), outIndex_(-1) {
-        s >> output_;
+        s >> *this;
     }
 
+    /**
+     * Serializes as the listing template first and then the value,
+     * with pay-to-address listings collapsed to the key ID
+     */
     ADD_SERIALIZE_METHODS
     template <typename Stream, typename Operation>
     inline void SerializationOp(Stream& s, Operation ser_action) {
-        READWRITE(output_);
+        READWRITE(listing_);
+        READWRITE(value_);
     }
 
     bool operator==(const UTXO& another) const {
-        return output_ == another.output_;
+        return value_ == another.value_ && listing_ == another.listing_;
     }
 
     bool operator!=(const UTXO& another) const {
         return !(*this == another);
     }
 
-    const TxOutput& GetOutput() const {
-        return output_;
+    const Coin& GetValue() const {
+        return value_;
+    }
+
+    tasm::Listing GetListing() const {
+        return listing_.Expand();
+    }
+
+    /** Decodes the key ID of a pay-to-address output */
+    std::optional<CKeyID> GetKeyID() const {
+        return listing_.GetKeyID();
     }
 
     std::pair<uint32_t, uint32_t> GetIndices() const {
@@ -70,12 +171,13 @@ public:
     friend std::string std::to_string(const UTXO&);
 
 private:
-    TxOutput output_;
+    Coin value_;
+    CompactListing listing_;
+    const Transaction* parentTx_ = nullptr;
     uint32_t txIndex_;
     uint32_t outIndex_;
 };
 
-
 template <>
 struct std::hash<UTXO> {
     size_t operator()(const UTXO& u) const {
@@ -85,6 +187,9 @@ struct std::hash<UTXO> {
 
 typedef std::shared_ptr<const UTXO> UTXOPtr;
 
+/** Creates a UTXO in the pool shared by all UTXOs instead of a heap allocation of its own */
+UTXOPtr CreateUTXO(const TxOutput&, uint32_t txIdx, uint32_t outIdx);
+
 /**
  * TXOC stands for a delta of transaction output changes,
  * containing vectors representing keys of created and spent
@@ -73,17 +73,17 @@ size_t Vertex::GetNumOfValidTxns() const {
                            [](const size_t& sum, const uint8_t& v) { return sum + (v == Vertex::Validity::VALID); });
 }
 
-size_t Vertex::GetOptimalStorageSize() {
+size_t Vertex::GetOptimalStorageSize(bool withHeight) {
+    const size_t heightSize = withHeight ? GetSizeOfVarInt(height) : 0;
     if (optimalStorageSize_ > 0) {
-        return optimalStorageSize_;
+        return optimalStorageSize_ + heightSize;
     }
 
-    optimalStorageSize_ += (1                                                               // RedemptionStatus
-                            + GetSizeOfVarInt(height)                                       // block height
-                            + GetSizeOfVarInt(cumulativeReward.GetValue())                  // reward
-                            + GetSizeOfVarInt(minerChainHeight)                             // miner chain height
-                            + ::GetSizeOfCompactSize(validity.size()) + validity.size() * 1 // validity
-                            + 1                                                             // MilestoneStatus
+    optimalStorageSize_ += (1                                              // header
+                            + GetSizeOfVarInt(cumulativeReward.GetValue()) // reward
+                            + GetSizeOfVarInt(minerChainHeight)            // miner chain height
+                            + ::GetSizeOfCompactSize(validity.size())      // number of txns
+                            + (validity.size() + 3) / 4                    // 2-bit validity
     );
 
     // Milestone
@@ -94,7 +94,7 @@ size_t Vertex::GetOptimalStorageSize() {
         );
     }
 
-    return optimalStorageSize_;
+    return optimalStorageSize_ + heightSize;
 }
 
 std::string std::to_string(const Vertex& vtx, bool showtx) {
@@ -56,48 +56,119 @@ public:
     explicit Vertex(VStream&);
 
     void LinkMilestone(const std::shared_ptr<Milestone>&);
-    size_t GetOptimalStorageSize();
+
+    // returns the size of the record in the compact format, with or without the height
+    size_t GetOptimalStorageSize(bool withHeight = true);
     void UpdateReward(const Coin&);
     void UpdateMilestoneReward();
 
     // returns the number of valid transactions
     size_t GetNumOfValidTxns() const;
 
-    ADD_SERIALIZE_METHODS
-    template <typename Stream, typename Operation>
-    inline void SerializationOp(Stream& s, Operation ser_action) {
-        READWRITE(isRedeemed);
-        READWRITE(VARINT(height));
-        READWRITE(cumulativeReward);
-        READWRITE(VARINT(minerChainHeight));
-        READWRITE(validity);
-
-        if (ser_action.ForRead()) {
-            auto msFlag = static_cast<MilestoneStatus>(ser_readdata8(s));
-            isMilestone = (msFlag == IS_TRUE_MILESTONE);
-            if (msFlag > 0) {
-                Milestone ms{};
-                ::Deserialize(s, ms);
-                snapshot         = std::make_shared<Milestone>(std::move(ms));
-                snapshot->height = height;
-                if (snapshot->IsDiffTransition() && cblock) {
-                    snapshot->lastUpdateTime = cblock->GetTime();
+    /**
+     * The first byte of a record keeps the redemption status in the lowest
+     * bits in both formats, so that it can be updated in place. The legacy
+     * format has nothing else in it, and the compact format adds the
+     * milestone status, whether the height is present and the version.
+     */
+    static constexpr uint8_t REDEMPTION_MASK = 0x03;
+    static constexpr uint8_t MS_STATUS_SHIFT = 2;
+    static constexpr uint8_t HAS_HEIGHT      = 0x10;
+    static constexpr uint8_t FORMAT_MASK     = 0xC0;
+    static constexpr uint8_t FORMAT_COMPACT  = 0x40;
+
+    /**
+     * Serializes in the compact format with validity packed in 2 bits per
+     * transaction. The height may be left out for the vertices of a level
+     * set following their milestone, which has the same height.
+     */
+    template <typename Stream>
+    void Serialize(Stream& s, bool withHeight = true) const {
+        uint8_t header = FORMAT_COMPACT | (isRedeemed & REDEMPTION_MASK) | (GetMilestoneStatus() << MS_STATUS_SHIFT);
+        if (withHeight) {
+            header |= HAS_HEIGHT;
+        }
+        ::Serialize(s, header);
+        if (withHeight) {
+            ::Serialize(s, VARINT(height));
+        }
+        ::Serialize(s, cumulativeReward);
+        ::Serialize(s, VARINT(minerChainHeight));
+
+        WriteCompactSize(s, validity.size());
+        for (size_t i = 0; i < validity.size(); i += 4) {
+            uint8_t packed = 0;
+            for (size_t j = 0; j < 4 && i + j < validity.size(); ++j) {
+                packed |= (validity[i + j] & 0x03) << (2 * j);
+            }
+            ::Serialize(s, packed);
+        }
+
+        if (snapshot != nullptr) {
+            ::Serialize(s, *snapshot);
+        }
+    }
+
+    /**
+     * Deserializes a record in either format. The height stays 0 if
+     * the record leaves it out
+     */
+    template <typename Stream>
+    void Deserialize(Stream& s) {
+        const uint8_t header = ser_readdata8(s);
+        isRedeemed           = header & REDEMPTION_MASK;
+
+        MilestoneStatus msFlag;
+        if ((header & FORMAT_MASK) == FORMAT_COMPACT) {
+            msFlag = static_cast<MilestoneStatus>((header >> MS_STATUS_SHIFT) & 0x03);
+            if (header & HAS_HEIGHT) {
+                ::Deserialize(s, VARINT(height));
+            }
+            ::Deserialize(s, cumulativeReward);
+            ::Deserialize(s, VARINT(minerChainHeight));
+
+            validity.resize(ReadCompactSize(s));
+            for (size_t i = 0; i < validity.size(); i += 4) {
+                const uint8_t packed = ser_readdata8(s);
+                for (size_t j = 0; j < 4 && i + j < validity.size(); ++j) {
+                    validity[i + j] = (packed >> (2 * j)) & 0x03;
                 }
             }
         } else {
-            if (isMilestone) {
-                ::Serialize(s, static_cast<uint8_t>(IS_TRUE_MILESTONE));
-            } else if (snapshot != nullptr) {
-                ::Serialize(s, static_cast<uint8_t>(IS_FAKE_MILESTONE));
-            } else {
-                ::Serialize(s, static_cast<uint8_t>(IS_NOT_REDEMPTION));
-            }
-            if (snapshot != nullptr) {
-                ::Serialize(s, *snapshot);
+            ::Deserialize(s, VARINT(height));
+            ::Deserialize(s, cumulativeReward);
+            ::Deserialize(s, VARINT(minerChainHeight));
+            ::Deserialize(s, validity);
+            msFlag = static_cast<MilestoneStatus>(ser_readdata8(s));
+        }
+
+        isMilestone = (msFlag == IS_TRUE_MILESTONE);
+        if (msFlag > 0) {
+            Milestone ms{};
+            ::Deserialize(s, ms);
+            snapshot         = std::make_shared<Milestone>(std::move(ms));
+            snapshot->height = height;
+            if (snapshot->IsDiffTransition() && cblock) {
+                snapshot->lastUpdateTime = cblock->GetTime();
             }
         }
     }
 
+    MilestoneStatus GetMilestoneStatus() const {
+        if (isMilestone) {
+            return IS_TRUE_MILESTONE;
+        }
+        return snapshot != nullptr ? IS_FAKE_MILESTONE : IS_NOT_MILESTONE;
+    }
+
+    /** Sets the height of the vertex and its snapshot if any, e.g., when read without the height */
+    void SetHeight(uint64_t h) {
+        height = h;
+        if (snapshot != nullptr) {
+            snapshot->height = h;
+        }
+    }
+
     bool operator==(const Vertex& another) const {
         // clang-format off
         return height           == another.height &&
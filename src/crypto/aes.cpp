@@ -7,35 +7,172 @@
 #include <cassert>
 #include <cstring>
 
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define ENABLE_AESNI
+#include <cpuid.h>
+#include <wmmintrin.h>
+#endif
+
 extern "C" {
 #include "crypto/ctaes/ctaes.c"
 }
 
-AES256Encrypt::AES256Encrypt(const unsigned char key[32]) {
+#ifdef ENABLE_AESNI
+namespace aesni {
+/**
+ * AES-NI runs every round in hardware without any table lookup,
+ * so that it is constant-time as well as ctaes while a lot faster.
+ */
+#define AESNI_TARGET __attribute__((target("aes,sse2")))
+
+AESNI_TARGET static inline __m128i ExpandEven(__m128i a, __m128i assist) {
+    assist = _mm_shuffle_epi32(assist, 0xff);
+    a      = _mm_xor_si128(a, _mm_slli_si128(a, 4));
+    a      = _mm_xor_si128(a, _mm_slli_si128(a, 4));
+    a      = _mm_xor_si128(a, _mm_slli_si128(a, 4));
+    return _mm_xor_si128(a, assist);
+}
+
+AESNI_TARGET static inline __m128i ExpandOdd(__m128i a, __m128i b) {
+    __m128i assist = _mm_shuffle_epi32(_mm_aeskeygenassist_si128(b, 0x00), 0xaa);
+    a              = _mm_xor_si128(a, _mm_slli_si128(a, 4));
+    a              = _mm_xor_si128(a, _mm_slli_si128(a, 4));
+    a              = _mm_xor_si128(a, _mm_slli_si128(a, 4));
+    return _mm_xor_si128(a, assist);
+}
+
+#define AESNI_EXPAND(i, rcon)                                                          \
+    do {                                                                               \
+        rk[i] = ExpandEven(rk[(i) - 2], _mm_aeskeygenassist_si128(rk[(i) - 1], rcon)); \
+        if ((i) + 1 < 15) {                                                            \
+            rk[(i) + 1] = ExpandOdd(rk[(i) - 1], rk[i]);                               \
+        }                                                                              \
+    } while (false)
+
+AESNI_TARGET static void Init(unsigned char out[15 * AES_BLOCKSIZE], const unsigned char key[32]) {
+    __m128i rk[15];
+    rk[0] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(key));
+    rk[1] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(key + 16));
+    AESNI_EXPAND(2, 0x01);
+    AESNI_EXPAND(4, 0x02);
+    AESNI_EXPAND(6, 0x04);
+    AESNI_EXPAND(8, 0x08);
+    AESNI_EXPAND(10, 0x10);
+    AESNI_EXPAND(12, 0x20);
+    AESNI_EXPAND(14, 0x40);
+
+    for (int i = 0; i < 15; ++i) {
+        _mm_store_si128(reinterpret_cast<__m128i*>(out) + i, rk[i]);
+    }
+    memset(rk, 0, sizeof(rk));
+}
+
+/**
+ * turns the encryption round keys into the ones of the equivalent inverse cipher
+ */
+AESNI_TARGET static void InitDecrypt(unsigned char out[15 * AES_BLOCKSIZE], const unsigned char key[32]) {
+    alignas(16) unsigned char enc[15 * AES_BLOCKSIZE];
+    Init(enc, key);
+
+    auto rk = reinterpret_cast<const __m128i*>(enc);
+    auto dk = reinterpret_cast<__m128i*>(out);
+    _mm_store_si128(dk, _mm_load_si128(rk + 14));
+    for (int i = 1; i < 14; ++i) {
+        _mm_store_si128(dk + i, _mm_aesimc_si128(_mm_load_si128(rk + 14 - i)));
+    }
+    _mm_store_si128(dk + 14, _mm_load_si128(rk));
+    memset(enc, 0, sizeof(enc));
+}
+
+AESNI_TARGET static void Encrypt(const unsigned char rk[15 * AES_BLOCKSIZE],
+                                 unsigned char ciphertext[16],
+                                 const unsigned char plaintext[16]) {
+    auto k    = reinterpret_cast<const __m128i*>(rk);
+    __m128i b = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(plaintext)), _mm_load_si128(k));
+    for (int i = 1; i < 14; ++i) {
+        b = _mm_aesenc_si128(b, _mm_load_si128(k + i));
+    }
+    b = _mm_aesenclast_si128(b, _mm_load_si128(k + 14));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(ciphertext), b);
+}
+
+AESNI_TARGET static void Decrypt(const unsigned char dk[15 * AES_BLOCKSIZE],
+                                 unsigned char plaintext[16],
+                                 const unsigned char ciphertext[16]) {
+    auto k    = reinterpret_cast<const __m128i*>(dk);
+    __m128i b = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ciphertext)), _mm_load_si128(k));
+    for (int i = 1; i < 14; ++i) {
+        b = _mm_aesdec_si128(b, _mm_load_si128(k + i));
+    }
+    b = _mm_aesdeclast_si128(b, _mm_load_si128(k + 14));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(plaintext), b);
+}
+
+#undef AESNI_EXPAND
+#undef AESNI_TARGET
+} // namespace aesni
+#endif
+
+bool AES256HardwareEnabled() {
+#ifdef ENABLE_AESNI
+    static const bool enabled = [] {
+        unsigned int eax, ebx, ecx, edx;
+        return __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_AES) && (edx & bit_SSE2);
+    }();
+    return enabled;
+#else
+    return false;
+#endif
+}
+
+AES256Encrypt::AES256Encrypt(const unsigned char key[32]) : hw(AES256HardwareEnabled()) {
+#ifdef ENABLE_AESNI
+    if (hw) {
+        aesni::Init(rk, key);
+        return;
+    }
+#endif
     AES256_init(&ctx, key);
 }
 
 AES256Encrypt::~AES256Encrypt() {
-    memset(&ctx, 0, sizeof(ctx));
+    memset(rk, 0, sizeof(rk));
 }
 
 void AES256Encrypt::Encrypt(unsigned char ciphertext[16], const unsigned char plaintext[16]) const {
+#ifdef ENABLE_AESNI
+    if (hw) {
+        aesni::Encrypt(rk, ciphertext, plaintext);
+        return;
+    }
+#endif
     AES256_encrypt(&ctx, 1, ciphertext, plaintext);
 }
 
-AES256Decrypt::AES256Decrypt(const unsigned char key[32]) {
+AES256Decrypt::AES256Decrypt(const unsigned char key[32]) : hw(AES256HardwareEnabled()) {
+#ifdef ENABLE_AESNI
+    if (hw) {
+        aesni::InitDecrypt(rk, key);
+        return;
+    }
+#endif
     AES256_init(&ctx, key);
 }
 
 AES256Decrypt::~AES256Decrypt() {
-    memset(&ctx, 0, sizeof(ctx));
+    memset(rk, 0, sizeof(rk));
 }
 
 void AES256Decrypt::Decrypt(unsigned char plaintext[16], const unsigned char ciphertext[16]) const {
+#ifdef ENABLE_AESNI
+    if (hw) {
+        aesni::Decrypt(rk, plaintext, ciphertext);
+        return;
+    }
+#endif
     AES256_decrypt(&ctx, 1, plaintext, ciphertext);
 }
 
-
 template <typename T>
 static int CBCEncrypt(const T& enc,
                       const unsigned char iv[AES_BLOCKSIZE],
@@ -14,10 +14,18 @@ extern "C" {
 static constexpr int AES_BLOCKSIZE  = 16;
 static constexpr int AES256_KEYSIZE = 32;
 
+/** Whether AES-256 runs on the AES-NI instructions of the CPU rather than ctaes. */
+bool AES256HardwareEnabled();
+
 /** An encryption class for AES-256. */
 class AES256Encrypt {
 private:
-    AES256_ctx ctx;
+    // the round keys of either ctaes or AES-NI, both constant-time
+    union {
+        AES256_ctx ctx;
+        alignas(16) unsigned char rk[15 * AES_BLOCKSIZE];
+    };
+    bool hw;
 
 public:
     explicit AES256Encrypt(const unsigned char key[32]);
@@ -28,7 +36,11 @@ public:
 /** A decryption class for AES-256. */
 class AES256Decrypt {
 private:
-    AES256_ctx ctx;
+    union {
+        AES256_ctx ctx;
+        alignas(16) unsigned char rk[15 * AES_BLOCKSIZE];
+    };
+    bool hw;
 
 public:
     explicit AES256Decrypt(const unsigned char key[32]);
@@ -3,8 +3,10 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "epic-cli.h"
+#include "cxxopts.h"
 
 #include <ctime>
+#include <fstream>
 #include <iomanip>
 #include <termios.h>
 
@@ -88,7 +90,115 @@ std::vector<uint8_t> get_op_vector(std::string ops_str) {
     return ops;
 }
 
+/**
+ * runs the commands in the file, one per line, instead of the interactive shell;
+ * consecutive get-block, get-vertex and create-tx commands are grouped
+ * into batch requests which are pipelined to the rpc server
+ */
+int RunBatch(const std::string& host, const std::string& path, size_t batchSize, size_t pipelineDepth) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Failed to open the batch file " << path << std::endl;
+        return 1;
+    }
+
+    RPCClient rpc(RPCClient::CreateChannel(host));
+    rpc.SetPipeline(batchSize, pipelineDepth);
+
+    std::string command;
+    std::vector<std::string> hashes;
+    std::vector<std::pair<RPCClient::TxOutputs, uint64_t>> txs;
+    bool success = true;
+    // prints the results of the requests which have succeeded even if others have failed
+    auto flush = [&]() {
+        std::optional<std::string> r;
+        std::vector<size_t> failed;
+        if (command == "get-block") {
+            r = rpc.GetBlocks(hashes, &failed);
+        } else if (command == "get-vertex") {
+            r = rpc.GetVertices(hashes, &failed);
+        } else if (command == "create-tx") {
+            r = rpc.CreateTxBatch(txs, &failed);
+        } else {
+            return;
+        }
+
+        if (r) {
+            std::cout << *r << std::endl;
+        }
+        if (!hashes.empty()) {
+            for (auto i : failed) {
+                std::cerr << "No result of " << command << " " << hashes[i] << std::endl;
+            }
+        }
+        if (!failed.empty()) {
+            std::cerr << failed.size() << " of " << hashes.size() + txs.size() << " " << command
+                      << " commands failed" << std::endl;
+        }
+        success = success && r && failed.empty();
+
+        hashes.clear();
+        txs.clear();
+    };
+
+    std::string line;
+    for (size_t lineNum = 1; std::getline(file, line); ++lineNum) {
+        auto args = split(line, ' ');
+        if (args.empty() || args[0].empty() || args[0][0] == '#') {
+            continue;
+        }
+        if (args[0] != command) {
+            flush();
+        }
+        command = args[0];
+
+        try {
+            if ((command == "get-block" || command == "get-vertex") && args.size() == 2) {
+                hashes.emplace_back(args[1]);
+                continue;
+            }
+            if (command == "create-tx" && args.size() == 3) {
+                txs.emplace_back(parse_pair<uint64_t, std::string>(args[2]), lexical_cast<uint64_t>(args[1]));
+                continue;
+            }
+        } catch (std::exception&) {
+        }
+        std::cerr << path << ":" << lineNum << ": invalid command \"" << line << "\"" << std::endl;
+        return 1;
+    }
+    flush();
+    return success ? 0 : 1;
+}
+
 int main(int argc, char** argv) {
+    cxxopts::Options options("epic-cli", "command line client of epic");
+    // clang-format off
+    options.add_options()
+    ("h,help", "print this message", cxxopts::value<bool>())
+    ("batch", "run the commands in the file (get-block <hash>, get-vertex <hash> or create-tx <fee> <outputs>, "
+              "one per line) and exit", cxxopts::value<std::string>())
+    ("host", "rpc server of the batch mode", cxxopts::value<std::string>()->default_value("127.0.0.1:3777"))
+    ("batch-size", "the max number of commands in a batch request", cxxopts::value<size_t>()->default_value("1000"))
+    ("pipeline", "the max number of batch requests in flight", cxxopts::value<size_t>()->default_value("8"))
+    ;
+    // clang-format on
+
+    try {
+        auto result = options.parse(argc, argv);
+        if (result["help"].as<bool>()) {
+            std::cout << options.help() << std::endl;
+            return 0;
+        }
+        if (result.count("batch")) {
+            return RunBatch(result["host"].as<std::string>(), result["batch"].as<std::string>(),
+                            result["batch-size"].as<size_t>(), result["pipeline"].as<size_t>());
+        }
+    } catch (const cxxopts::OptionException& e) {
+        std::cout << options.help() << std::endl;
+        std::cerr << "error parsing options: " << e.what() << std::endl;
+        return 1;
+    }
+
     PrintBanner();
     EpicCli cli("epic");
     cli.Start();
@@ -196,12 +306,16 @@ std::unique_ptr<Menu> EpicCli::CreateSubMenu(const std::string& title) {
                 },
                 "verify whether the signed message matches with the signature ",
                 {"content of input listing, content of output listing, vector of operation code"});
+    sub->Insert("tracing", [this](std::ostream& out, std::string state) { SetTracing(out, state); },
+                "Enable or disable tracing the lifecycle of blocks", {"on or off"});
+    sub->Insert("export-trace", [this](std::ostream& out, std::string path) { ExportTrace(out, path); },
+                "Export the recent trace for chrome://tracing or Perfetto", {"path of the JSON file"});
 
     return sub;
 }
 
 void EpicCli::Open(std::ostream& out, const std::string& host) {
-    auto rpc = std::make_unique<RPCClient>(grpc::CreateChannel(host, grpc::InsecureChannelCredentials()));
+    auto rpc = std::make_unique<RPCClient>(RPCClient::CreateChannel(host));
     auto rsp = rpc->Status();
     if (rsp) {
         rpc_       = std::move(rpc);
@@ -503,3 +617,38 @@ void EpicCli::VerifyMessage(std::ostream& out, std::string input, std::string ou
         Close(out);
     }
 }
+
+void EpicCli::SetTracing(std::ostream& out, std::string& state) {
+    std::transform(state.begin(), state.end(), state.begin(), [](unsigned char c) { return std::tolower(c); });
+    if (state != "on" && state != "off") {
+        out << "The argument should be on or off" << std::endl;
+        return;
+    }
+
+    auto r = rpc_->SetTracing(state == "on");
+    if (r) {
+        out << "Tracing " << (state == "on" ? "enabled" : "disabled") << std::endl;
+    } else {
+        Close(out);
+    }
+}
+
+void EpicCli::ExportTrace(std::ostream& out, std::string& path) {
+    std::ofstream file(path);
+    if (!file) {
+        out << "Failed to open " << path << std::endl;
+        return;
+    }
+
+    auto r = rpc_->ExportTrace(file);
+    if (!r) {
+        Close(out);
+        return;
+    }
+
+    if (!file.flush()) {
+        out << "Failed to write the trace to " << path << std::endl;
+        return;
+    }
+    out << "Trace of " << *r << " bytes written to " << path << std::endl;
+}
@@ -3,6 +3,7 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "init.h"
+#include "binary_trace.h"
 #include "block_store.h"
 #include "config.h"
 #include "dag_manager.h"
@@ -11,8 +12,10 @@
 #include "miner.h"
 #include "peer_manager.h"
 #include "rpc_server.h"
+#include "spdlog/async.h"
 #include "spdlog/sinks/daily_file_sink.h"
 #include "subscription.h"
+#include "tracing.h"
 #include "wallet.h"
 
 #include <csignal>
@@ -142,9 +145,15 @@ int Init(int argc, char* argv[]) {
         DeleteDir(CONFIG->GetWalletPath());
     }
 
-    STORE = std::make_unique<BlockStore>(CONFIG->GetDBPath());
+    try {
+        STORE = std::make_unique<BlockStore>(CONFIG->GetDBPath());
+    } catch (const std::string& err) {
+        // the database failed to open or to migrate to the current format
+        spdlog::error("{}, quit", err);
+        return STORAGE_INIT_FAILURE;
+    }
 
-    if (!STORE->DBExists(GENESIS->GetHash())) {
+    if (STORE->GetLowestHeight() == 0 && !STORE->DBExists(GENESIS->GetHash())) {
         // put genesis block into cat
         std::vector<VertexPtr> genesisLvs = {GENESIS_VERTEX};
         STORE->StoreLevelSet(genesisLvs);
@@ -153,6 +162,8 @@ int Init(int argc, char* argv[]) {
         spdlog::error("Failed to pass the file sanity check, quit");
         return STORAGE_INIT_FAILURE;
     }
+    STORE->SetPruneWindow(CONFIG->GetPruneWindow());
+    STORE->ConvertLegacyVtxFiles();
     DAG = std::make_unique<DAGManager>();
     if (!DAG->Init()) {
         return DAG_INIT_FAILURE;
@@ -161,7 +172,8 @@ int Init(int argc, char* argv[]) {
     /*
      * Load wallet
      */
-    WALLET = std::make_unique<Wallet>(CONFIG->GetWalletPath(), CONFIG->GetWalletBackup(), CONFIG->GetWalletLogin());
+    WALLET = std::make_unique<Wallet>(CONFIG->GetWalletPath(), CONFIG->GetWalletBackup(), CONFIG->GetWalletLogin(),
+                                      CONFIG->GetWalletKeyPool());
     DAG->RegisterOnLvsConfirmedCallback(
         [&](auto vec, auto map1, auto map2) { WALLET->OnLvsConfirmed(vec, map1, map2); });
 
@@ -205,6 +217,7 @@ void SetupCommandline(cxxopts::Options& options) {
     ("N,newdb", "start with the new db", cxxopts::value<bool>())
     ("S,seed", "start as a seed",cxxopts::value<bool>())
     ("P,prune","delete invalid files",cxxopts::value<bool>())
+    ("prune-window", "keep only the level sets of the latest n heights on disk", cxxopts::value<uint64_t>())
     ("version", "version information", cxxopts::value<bool>())
     ;
     // clang-format on
@@ -246,6 +259,9 @@ void ParseCommandLine(int argc, char** argv, cxxopts::Options& options) {
     if (result.count("prune") > 0) {
         CONFIG->SetPrune(true);
     }
+    if (result.count("prune-window") > 0) {
+        CONFIG->SetPruneWindow(result["prune-window"].as<uint64_t>());
+    }
     CONFIG->SetDisableRPC(result["disable-rpc"].as<bool>());
 }
 
@@ -286,6 +302,12 @@ void LoadConfigFile() {
             CONFIG->SetLoggerFilename(filename);
             CONFIG->SetLoggerPath(path);
         }
+
+        CONFIG->SetAsyncLogger(log_config->get_as<bool>("async").value_or(false));
+        CONFIG->SetLoggerQueueSize(log_config->get_as<uint32_t>("queue_size").value_or(8192));
+        CONFIG->SetLoggerOverrun(log_config->get_as<std::string>("overflow").value_or("block") == "overrun");
+        CONFIG->SetTraceFilename(log_config->get_as<std::string>("trace").value_or(""));
+        CONFIG->SetTracing(log_config->get_as<bool>("spans").value_or(false));
     }
 
     // address manager
@@ -364,6 +386,11 @@ void LoadConfigFile() {
         if (db_path) {
             CONFIG->SetDBPath(*db_path);
         }
+
+        auto prune_window = db_config->get_as<uint64_t>("prune_window");
+        if (prune_window && CONFIG->GetPruneWindow() == 0) {
+            CONFIG->SetPruneWindow(*prune_window);
+        }
     }
 
     // rpc
@@ -391,6 +418,10 @@ void LoadConfigFile() {
         if (wallet_login) {
             CONFIG->SetWalletLogin(*wallet_login);
         }
+        auto wallet_key_pool = wallet_config->get_as<uint32_t>("key_pool");
+        if (wallet_key_pool) {
+            CONFIG->SetWalletKeyPool(*wallet_key_pool);
+        }
     }
 
     // miner
@@ -407,9 +438,34 @@ void InitLogger() {
     if (CONFIG->IsUseFileLogger()) {
         UseFileLogger(CONFIG->GetLoggerPath(), CONFIG->GetLoggerFilename());
     }
+    if (CONFIG->IsAsyncLogger()) {
+        UseAsyncLogger(CONFIG->GetLoggerQueueSize(), CONFIG->IsLoggerOverrun());
+    }
     spdlog::set_pattern("[%Y-%m-%d %H:%M:%S.%e][%t][%l] %v");
     spdlog::set_level(spdlog::level::from_str(CONFIG->GetLoggerLevel()));
     spdlog::flush_on(spdlog::level::from_str(CONFIG->GetLoggerLevel()));
+
+    const auto traceFile = CONFIG->GetTraceFile();
+    if (!traceFile.empty()) {
+        if ((CheckDirExist(CONFIG->GetLoggerPath()) || MkdirRecursive(CONFIG->GetLoggerPath())) &&
+            BinaryTrace::Open(traceFile)) {
+            spdlog::info("Tracing validation events to {}", traceFile);
+        } else {
+            spdlog::warn("Failed to open the trace file {}, tracing is disabled", traceFile);
+        }
+    }
+    Tracer::Enable(CONFIG->IsTracing());
+}
+
+void UseAsyncLogger(size_t queueSize, bool overrun) {
+    // the sinks of the current default logger are moved behind a queue drained by a single thread,
+    // so that the order of the messages is kept
+    spdlog::init_thread_pool(queueSize, 1);
+    auto sinks  = spdlog::default_logger()->sinks();
+    auto policy = overrun ? spdlog::async_overflow_policy::overrun_oldest : spdlog::async_overflow_policy::block;
+    auto logger = std::make_shared<spdlog::async_logger>("async_logger", sinks.begin(), sinks.end(),
+                                                         spdlog::thread_pool(), policy);
+    spdlog::set_default_logger(logger);
 }
 
 void UseFileLogger(const std::string& path, const std::string& filename) {
@@ -477,6 +533,8 @@ void ShutDown() {
     ECC_Stop();
     handle.~ECCVerifyHandle();
 
+    BinaryTrace::Close();
+
     spdlog::info("Shutdown successfully.");
     spdlog::shutdown();
 }
@@ -36,6 +36,7 @@ void SetupCommandline(cxxopts::Options& options);
 void ParseCommandLine(int argc, char* argv[], cxxopts::Options& options);
 
 void UseFileLogger(const std::string& path, const std::string& filename);
+void UseAsyncLogger(size_t queueSize, bool overrun);
 void InitLogger();
 
 void CreateDaemon();
@@ -3,6 +3,7 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "block.h"
+#include "log.h"
 #include "merkle.h"
 
 #include <unordered_set>
@@ -154,8 +155,8 @@ void Block::UnCache() {
 bool Block::Verify() const {
     // check version
     if (header_.version != GetParams().version) {
-        spdlog::info("[Syntax] Wrong version {} v.s. expected {} [{}]", header_.version, GetParams().version,
-                     std::to_string(hash_));
+        LOG_INFO("[Syntax] Wrong version {} v.s. expected {} [{}]", header_.version, GetParams().version,
+                 std::to_string(hash_));
         return false;
     }
 
@@ -168,11 +169,11 @@ bool Block::Verify() const {
     bool mutated;
     auto root = ComputeMerkleRoot(&mutated);
     if (mutated) {
-        spdlog::info("[Syntax] Duplicated transactions in a merkle tree branch [{}]", std::to_string(hash_));
+        LOG_INFO("[Syntax] Duplicated transactions in a merkle tree branch [{}]", std::to_string(hash_));
         return false;
     }
     if (root != header_.merkleRoot) {
-        spdlog::info("[Syntax] Invalid merkle root [{}]", std::to_string(hash_));
+        LOG_INFO("[Syntax] Invalid merkle root [{}]", std::to_string(hash_));
         return false;
     }
 
@@ -180,22 +181,22 @@ bool Block::Verify() const {
     time_t allowedTime = std::time(nullptr) + ALLOWED_TIME_DRIFT;
     if (header_.timestamp > allowedTime) {
         time_t t = header_.timestamp;
-        spdlog::info("[Syntax] Too advanced in the future: {} v.s. allowed {} ({} vs. {}) [{}]",
-                     std::string(ctime(&t)).substr(0, 24), std::string(ctime(&allowedTime)).substr(0, 24),
-                     header_.timestamp, allowedTime, std::to_string(hash_));
+        LOG_INFO("[Syntax] Too advanced in the future: {} v.s. allowed {} ({} vs. {}) [{}]",
+                 std::string(ctime(&t)).substr(0, 24), std::string(ctime(&allowedTime)).substr(0, 24),
+                 header_.timestamp, allowedTime, std::to_string(hash_));
         return false;
     }
 
     // verify content of the block
     if (transactions_.size() > GetParams().blockCapacity) {
-        spdlog::info("[Syntax] The number of transactions ({}) greater than the block capacity ({}) [{}]",
-                     transactions_.size(), GetParams().blockCapacity, std::to_string(hash_));
+        LOG_INFO("[Syntax] The number of transactions ({}) greater than the block capacity ({}) [{}]",
+                 transactions_.size(), GetParams().blockCapacity, std::to_string(hash_));
         return false;
     }
 
     if (GetOptimalEncodingSize() > MAX_BLOCK_SIZE) {
-        spdlog::info("[Syntax] Size {} larger than the maximum allowed size ({} bytes) [{}]", optimalEncodingSize_,
-                     MAX_BLOCK_SIZE, std::to_string(hash_));
+        LOG_INFO("[Syntax] Size {} larger than the maximum allowed size ({} bytes) [{}]", optimalEncodingSize_,
+                 MAX_BLOCK_SIZE, std::to_string(hash_));
         return false;
     }
 
@@ -209,7 +210,7 @@ bool Block::Verify() const {
         }
 
         if (txhashes.size() != transactions_.size()) {
-            spdlog::info("[Syntax] Duplicated transactions [{}]", std::to_string(hash_));
+            LOG_INFO("[Syntax] Duplicated transactions [{}]", std::to_string(hash_));
             return false;
         }
     }
@@ -218,13 +219,13 @@ bool Block::Verify() const {
     if (header_.prevBlockHash == GENESIS->GetHash()) {
         // Must contain a tx
         if (!HasTransaction()) {
-            spdlog::info("[Syntax] Empty first registration [{}]", std::to_string(hash_));
+            LOG_INFO("[Syntax] Empty first registration [{}]", std::to_string(hash_));
             return false;
         }
 
         // ... with input from ZERO hash and index -1 and output value 0
         if (!transactions_[0]->IsFirstRegistration()) {
-            spdlog::info("[Syntax] Invalid first registration [{}]", std::to_string(hash_));
+            LOG_INFO("[Syntax] Invalid first registration [{}]", std::to_string(hash_));
             return false;
         }
     }
@@ -424,8 +425,8 @@ bool Block::CheckPOW() const {
     assert(!proofHash_.IsNull());
 
     if (proof_.size() != GetParams().cycleLen) {
-        spdlog::info("[Syntax] Bad proof size {} vs. expected {} [{}]", proof_.size(), GetParams().cycleLen,
-                     std::to_string(hash_));
+        LOG_INFO("[Syntax] Bad proof size {} vs. expected {} [{}]", proof_.size(), GetParams().cycleLen,
+                 std::to_string(hash_));
         return false;
     }
 
@@ -438,7 +439,7 @@ bool Block::CheckPOW() const {
         // Verify cuckaroo pow
         auto status = VerifyProof(proof_.data(), sipkeys, GetParams().cycleLen);
         if (status != POW_OK) {
-            spdlog::info("[Syntax] Invalid proof of edges: {}", ErrStr[status]);
+            LOG_INFO("[Syntax] Invalid proof of edges: {}", ErrStr[status]);
             return false;
         }
     }
@@ -446,14 +447,14 @@ bool Block::CheckPOW() const {
     // Verify target validity
     arith_uint256 target = GetTargetAsInteger();
     if (target == 0 || target > GetParams().maxTarget) {
-        spdlog::info("[Syntax] Bad difficulty target: {}", target.GetDouble());
+        LOG_INFO("[Syntax] Bad difficulty target: {}", target.GetDouble());
         return false;
     }
 
     // Verify proof target
     if (UintToArith256(proofHash_) > target) {
-        spdlog::info("Proof hash {} is higher than target {} [{}]", std::to_string(proofHash_), std::to_string(target),
-                     std::to_string(hash_));
+        LOG_INFO("Proof hash {} is higher than target {} [{}]", std::to_string(proofHash_), std::to_string(target),
+                 std::to_string(hash_));
         return false;
     }
 
@@ -9,6 +9,14 @@
 #include "net_message.h"
 #include "serialize.h"
 
+/**
+ * Bits of the local service in the version message
+ */
+enum ServiceFlags : uint64_t {
+    // accepts payloads deflated on the wire
+    NODE_COMPRESSION = 1 << 0,
+};
+
 class VersionMessage : public NetMessage {
 public:
     int client_version     = 0;
@@ -19,6 +27,9 @@ public:
     uint64_t current_height;
     uint64_t id;
     std::string version_info;
+    // lowest height of which the level set is kept by the sender,
+    // which is above 0 only if the sender is a pruned node
+    uint64_t lowest_height = 0;
 
     explicit VersionMessage() : NetMessage(VERSION_MSG) {}
 
@@ -51,6 +62,11 @@ public:
         READWRITE(current_height);
         READWRITE(id);
         READWRITE(version_info);
+
+        // peers of older versions do not send the lowest height
+        if (!ser_action.ForRead() || s.rdbuf()->in_avail() > 0) {
+            READWRITE(lowest_height);
+        }
     }
 };
 
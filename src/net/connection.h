@@ -55,6 +55,18 @@ public:
         return connection_;
     }
 
+    /**
+     * Whether the remote accepts compressed payloads,
+     * as advertised in its version message
+     */
+    bool IsCompressionEnabled() const {
+        return compression_;
+    }
+
+    void EnableCompression() {
+        compression_ = true;
+    }
+
     void Release();
 
     void Disconnect();
@@ -69,6 +81,7 @@ private:
     ConnectionManager* cmptr_;
     std::string remote_;
     shared_connection_t connection_;
+    std::atomic_bool compression_ = false;
 };
 
 
@@ -3,10 +3,14 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "connection_manager.h"
+#include "block.h"
+#include "compression.h"
 #include "crc32.h"
 #include "message_header.h"
 #include "params.h"
 #include "spdlog.h"
+#include "tracing.h"
+#include "version_message.h"
 
 #include <arpa/inet.h>
 #include <event2/buffer.h>
@@ -125,7 +129,8 @@ static void AcceptCallback(evconnlistener_t* listener, evutil_socket_t fd, socka
     bufferevent_enable(bev, EV_READ);
 }
 
-ConnectionManager::ConnectionManager() : serialize_pool_(1), deserialize_pool_(1) {
+ConnectionManager::ConnectionManager()
+    : receive_message_queue_(LARGE_CAPACITY), serialize_pool_(1, LARGE_CAPACITY), deserialize_pool_(1, LARGE_CAPACITY) {
     evthread_use_pthreads();
     base_ = event_base_new();
 }
@@ -235,6 +240,19 @@ void ConnectionManager::WriteOneMessage_(shared_connection_t connection, unique_
     serialize_pool_.Execute([connection, message = std::move(message), this]() {
         VStream s;
         message->NetSerialize(s);
+
+        // the version message is never compressed since the remote
+        // learns from it whether we can decompress at all
+        uint16_t flags = 0;
+        if (connection->IsCompressionEnabled() && message->GetType() != NetMessage::VERSION_MSG &&
+            s.size() >= MIN_COMPRESSION_LENGTH) {
+            VStream compressed;
+            if (compression::Compress(s.data(), s.size(), compressed)) {
+                s     = std::move(compressed);
+                flags = MESSAGE_FLAG_COMPRESSED;
+            }
+        }
+
         if (!s.empty()) {
             s << crc32c((uint8_t*) s.data(), s.size());
         }
@@ -243,6 +261,7 @@ void ConnectionManager::WriteOneMessage_(shared_connection_t connection, unique_
         header.magic     = GetParams().magic;
         header.type      = message->GetType();
         header.countDown = message->GetCount();
+        header.reserved  = flags;
         header.length    = s.size();
         header.checksum  = header.magic + header.type + header.countDown + header.length;
 
@@ -354,6 +373,7 @@ bool ConnectionManager::ReadOneMessage_(bufferevent_t* bev, Connection* handle)
         /* if the buffer received enough bytes, construct the message instance and put it into the receive queue,
          * otherwise wait more bytes*/
         if (receive_length >= read_length) {
+            TRACE_SPAN("ReadOneMessage");
             message_header_t header;
             bufferevent_read(bev, &header, sizeof(header));
 
@@ -367,10 +387,31 @@ bool ConnectionManager::ReadOneMessage_(bufferevent_t* bev, Connection* handle)
 
             deserialize_pool_.Execute(
                 [header, payload = std::move(payload), crc32, handle = handle->GetHandlePtr(), this]() {
+                    TraceSpan span("Deserialize");
                     if (header.length == 0 || crc32c((uint8_t*) payload->data(), payload->size()) == crc32) {
                         receive_bytes_ += header.length + MESSAGE_HEADER_LENGTH;
                         receive_packages_ += 1;
+
+                        // peers not supporting compression may leave garbage in the reserved field
+                        if (handle->IsCompressionEnabled() && (header.reserved & MESSAGE_FLAG_COMPRESSED)) {
+                            VStream inflated;
+                            if (!compression::Decompress(payload->data(), payload->size(), inflated,
+                                                         MAX_MESSAGE_LENGTH)) {
+                                spdlog::warn("[net] Failed to decompress message of type {} from {}", header.type,
+                                             handle->GetRemote());
+                                return;
+                            }
+                            *payload = std::move(inflated);
+                        }
+
                         unique_message_t message = NetMessage::MessageFactory(header.type, header.countDown, *payload);
+                        if (message->GetType() == NetMessage::BLOCK) {
+                            span.SetBlock(static_cast<Block*>(message.get())->GetHash());
+                        }
+                        if (message->GetType() == NetMessage::VERSION_MSG &&
+                            (static_cast<VersionMessage*>(message.get())->local_service & NODE_COMPRESSION)) {
+                            handle->EnableCompression();
+                        }
                         if (message->GetType() != NetMessage::NONE) {
                             receive_message_queue_.Put(std::make_pair(handle, std::move(message)));
                         }
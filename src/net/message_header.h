@@ -17,6 +17,12 @@
 
 #define MAX_MESSAGE_LENGTH 100 * 1024 * 1024
 
+/* set in the reserved field if the payload is deflated */
+#define MESSAGE_FLAG_COMPRESSED 0x1
+
+/* payloads shorter than this are not worth compressing */
+#define MIN_COMPRESSION_LENGTH 1024
+
 typedef struct {
     uint32_t magic;
     uint8_t type;
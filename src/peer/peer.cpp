@@ -6,6 +6,11 @@
 #include "block_store.h"
 #include "mempool.h"
 
+static uint64_t GetSteadyTimeMillis() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
 Peer::Peer(NetAddress& netAddress,
            shared_connection_t connection,
            bool isSeedPeer,
@@ -64,9 +69,12 @@ void Peer::ProcessMessage(unique_message_t& msg) {
                 throw ProtocolException("undefined message");
             }
         }
+        quality.AddMessage(true);
     } catch (ProtocolException& exception) {
+        quality.AddMessage(false);
         spdlog::debug(exception.ToString());
     } catch (const std::bad_cast& e) {
+        quality.AddMessage(false);
         spdlog::debug("Failed to cast message type: {}", e.what());
     }
 }
@@ -87,7 +95,15 @@ void Peer::ProcessPing(const Ping& ping) {
 
 void Peer::ProcessPong(const Pong& pong) {
     lastPongTime = time(nullptr);
-    nPingFailed  = pong.nonce == lastNonce ? 0 : nPingFailed + 1;
+
+    std::lock_guard<std::mutex> lock(ping_mutex_);
+    nPingFailed = pong.nonce == lastNonce ? 0 : nPingFailed + 1;
+
+    // a late pong of a superseded ping has been counted as a timeout in SendPing
+    if (pong.nonce == lastNonce && pingSentTime) {
+        quality.AddRtt(GetSteadyTimeMillis() - pingSentTime);
+        pingSentTime = 0;
+    }
     spdlog::trace("Received pong from {} with nonce = {}", address.ToString(), pong.nonce);
 }
 
@@ -110,15 +126,22 @@ void Peer::ProcessVersionMessage(VersionMessage& version) {
 
     char time_buffer[20];
     strftime(time_buffer, 20, "%Y-%m-%d %H:%M:%S", localtime((time_t*) &(versionMessage->nTime)));
-    spdlog::info("{}: got version = {}, address_you = {}, address_me = {}, services = {}, time = {}, height = {}",
+    spdlog::info("{}: got version = {}, address_you = {}, address_me = {}, services = {}, time = {}, height = {}, "
+                 "lowest height = {}",
                  address.ToString(), versionMessage->client_version, versionMessage->address_you.ToString(),
                  versionMessage->address_me.ToString(), versionMessage->local_service, std::string(time_buffer),
-                 versionMessage->current_height);
+                 versionMessage->current_height, versionMessage->lowest_height);
     spdlog::info("Git version info: {}", versionMessage->version_info);
 
     bool compareHeight = !(isSeed || CONFIG->AmISeed());
     if (compareHeight && versionMessage->current_height > DAG->GetBestMilestoneHeight()) {
-        isSyncAvailable = true;
+        // a pruned peer can only serve us if it still keeps the level sets right above our head
+        if (versionMessage->lowest_height <= DAG->GetBestMilestoneHeight() + 1) {
+            isSyncAvailable = true;
+        } else {
+            spdlog::info("{}: peer has pruned the level sets below height {}, not syncing from it",
+                         address.ToString(), versionMessage->lowest_height);
+        }
     }
 
     // send version message if peer is inbound
@@ -162,9 +185,19 @@ size_t Peer::GetNPingFailed() const {
 
 void Peer::SendPing() {
     if (isFullyConnected) {
-        lastNonce = time(nullptr);
-        SendMessage(std::make_unique<Ping>(lastNonce));
-        spdlog::trace("Sent ping to {} with nonce = {}", address.ToString(), lastNonce);
+        uint64_t nonce;
+        {
+            std::lock_guard<std::mutex> lock(ping_mutex_);
+            // the previous ping expires unanswered
+            if (pingSentTime) {
+                quality.AddTimeout();
+            }
+            nonce        = time(nullptr);
+            lastNonce    = nonce;
+            pingSentTime = GetSteadyTimeMillis();
+        }
+        SendMessage(std::make_unique<Ping>(nonce));
+        spdlog::trace("Sent ping to {} with nonce = {}", address.ToString(), nonce);
     }
 }
 
@@ -236,11 +269,18 @@ void Peer::ProcessBundle(const std::shared_ptr<Bundle>& bundle) {
         return;
     }
 
-    if (!getDataTasks.CompleteTask(bundle)) {
+    auto task = getDataTasks.CompleteTask(bundle);
+    if (!task) {
         spdlog::debug("Unknown bundle: nonce = {}, msg from{} ", std::to_string(bundle->nonce), address.ToString());
         return;
     }
 
+    size_t bytes = 0;
+    for (const auto& block : bundle->blocks) {
+        bytes += block->GetOptimalEncodingSize();
+    }
+    quality.AddDelivery(bytes, task->GetElapsed());
+
     spdlog::debug("Received bundle with nonce = {}. First nonce = {}", bundle->nonce, getDataTasks.Front()->nonce);
 
     while (getDataTasks.Front() && getDataTasks.Front()->bundle) {
@@ -270,10 +310,25 @@ void Peer::ProcessNotFound(const uint32_t& nonce) {
 }
 
 void Peer::AddPendingGetInvTask(std::shared_ptr<GetInvTask> task) {
+    SetSyncTimeout(task);
     std::unique_lock<std::shared_mutex> writer(inv_task_mutex_);
     getInvsTasks.insert_or_assign(task->nonce, task);
 }
 
+void Peer::AddPendingGetDataTask(std::shared_ptr<GetDataTask> task) {
+    SetSyncTimeout(task);
+    getDataTasks.Push(task);
+}
+
+void Peer::SetSyncTimeout(const std::shared_ptr<Task>& task) {
+    task->SetTimeoutCallback([weak = weak_peer_, nonce = task->nonce]() {
+        if (auto peer = weak.lock()) {
+            spdlog::debug("[NET] Sync task {} of peer {} timed out", nonce, peer->address.ToString());
+            peer->syncTimeout_ = true;
+        }
+    });
+}
+
 bool Peer::RemovePendingGetInvTask(uint32_t task_id) {
     std::unique_lock<std::shared_mutex> writer(inv_task_mutex_);
     return getInvsTasks.erase(task_id);
@@ -299,8 +354,10 @@ void Peer::SendMessage(unique_message_t&& message) {
 }
 
 void Peer::SendVersion(uint64_t height, std::string versionInfo) {
-    SendMessage(std::make_unique<VersionMessage>(address, addressManager_->GetBestLocalAddress(), height, myID_,
-                                                 versionInfo, GetParams().version, 0));
+    auto version = std::make_unique<VersionMessage>(address, addressManager_->GetBestLocalAddress(), height, myID_,
+                                                    versionInfo, GetParams().version, NODE_COMPRESSION);
+    version->lowest_height = STORE->GetLowestHeight();
+    SendMessage(std::move(version));
     spdlog::info("Sent version message to {}", address.ToString());
 }
 
@@ -325,20 +382,6 @@ void Peer::StartSync() {
     }
 }
 
-bool Peer::IsSyncTimeout() {
-    if (getDataTasks.IsTimeout()) {
-        return true;
-    }
-
-    std::shared_lock<std::shared_mutex> reader(inv_task_mutex_);
-    for (auto& task : getInvsTasks) {
-        if (task.second->IsTimeout()) {
-            return true;
-        }
-    }
-    return false;
-}
-
 void Peer::Disconnect() {
     connection_->Disconnect();
     for (auto& task : getDataTasks.GetTasks()) {
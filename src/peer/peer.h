@@ -12,6 +12,7 @@
 #include "concurrent_container.h"
 #include "connection_manager.h"
 #include "net_address.h"
+#include "peer_quality.h"
 #include "ping.h"
 #include "pong.h"
 #include "protocol_exception.h"
@@ -21,6 +22,7 @@
 #include "version_message.h"
 
 #include <atomic>
+#include <mutex>
 #include <shared_mutex>
 
 class Peer {
@@ -77,9 +79,7 @@ public:
 
     size_t GetInvTaskSize();
 
-    void AddPendingGetDataTask(std::shared_ptr<GetDataTask> task) {
-        getDataTasks.Push(task);
-    }
+    void AddPendingGetDataTask(std::shared_ptr<GetDataTask> task);
 
     bool InvTaskContains(uint32_t task_id);
 
@@ -131,7 +131,9 @@ public:
 
     void StartSync();
 
-    bool IsSyncTimeout();
+    bool IsSyncTimeout() const {
+        return syncTimeout_;
+    }
 
     /*
      * basic information of peer
@@ -160,6 +162,9 @@ public:
 
     std::atomic_uint64_t last_bundle_ms_time = 0;
 
+    // measured quality of the link to the peer
+    PeerQuality quality;
+
 private:
     /*
      * read the nonce and send back pong message
@@ -229,8 +234,11 @@ private:
     std::atomic_uint64_t lastPingTime;
     std::atomic_uint64_t lastPongTime;
 
-    // last sending nonce
-    std::atomic_uint64_t lastNonce;
+    // the nonce of the last ping and the steady time in milliseconds
+    // when it was sent, or 0 if it has been answered or superseded
+    std::mutex ping_mutex_;
+    uint64_t lastNonce    = 0;
+    uint64_t pingSentTime = 0;
 
     // number of ping failures
     size_t nPingFailed;
@@ -261,6 +269,11 @@ private:
     std::unordered_map<uint32_t, std::shared_ptr<GetInvTask>> getInvsTasks;
     GetDataTaskManager getDataTasks;
 
+    // set by the timer of a sync task which is not completed in time
+    std::atomic_bool syncTimeout_ = false;
+
+    void SetSyncTimeout(const std::shared_ptr<Task>& task);
+
     std::weak_ptr<Peer> weak_peer_;
 
     /*
@@ -7,6 +7,8 @@
 #include "mempool.h"
 #include "subscription.h"
 
+#include <numeric>
+
 PeerManager::PeerManager() {
     std::random_device rd;
     gen = std::default_random_engine(rd());
@@ -324,6 +326,13 @@ void PeerManager::CheckTimeout() {
                 spdlog::info("[NET:disconnect]: Fully connected peer {}: sync timeout", peer->address.ToString());
                 peer->Disconnect();
                 peerMap_.erase(it++);
+            } else if (peerMap_.size() > kMinPeersToEvict && peer->quality.IsChronicallySlow()) {
+                spdlog::info("[NET:disconnect]: Fully connected peer {}: chronically slow, rtt = {:.0f}ms, timeout "
+                             "rate = {:.2f}, invalid rate = {:.2f}",
+                             peer->address.ToString(), peer->quality.GetRtt(), peer->quality.GetTimeoutRate(),
+                             peer->quality.GetInvalidRate());
+                peer->Disconnect();
+                peerMap_.erase(it++);
             } else {
                 it++;
             }
@@ -442,7 +451,7 @@ void PeerManager::RelayBlock(const ConstBlockPtr& block, const PeerPtr& msg_from
         block->SetCount(kMaxCountDown);
     }
 
-    auto peersToRelay = RandomlySelect(kMaxPeerToBroadcast, msg_from);
+    auto peersToRelay = SelectRelayPeers(kMaxPeerToBroadcast, msg_from);
 
     if (block->GetCount()) {
         block->SetCount(block->GetCount() - 1);
@@ -517,13 +526,19 @@ void PeerManager::InitScheduleTask() {
 PeerPtr PeerManager::GetSyncPeer() {
     std::shared_lock<std::shared_mutex> lk(peerLock_);
 
+    PeerPtr best     = nullptr;
+    double bestScore = -1;
     for (auto& peer : peerMap_) {
         if (peer.second->IsVaild() && peer.second->isFullyConnected && peer.second->isSyncAvailable) {
-            return peer.second;
+            double score = peer.second->quality.GetScore();
+            if (score > bestScore) {
+                best      = peer.second;
+                bestScore = score;
+            }
         }
     }
 
-    return nullptr;
+    return best;
 }
 
 uint64_t PeerManager::GetMyPeerID() const {
@@ -608,3 +623,39 @@ std::vector<PeerPtr> PeerManager::RandomlySelect(size_t size, const PeerPtr& exc
 
     return result;
 }
+
+std::vector<PeerPtr> PeerManager::SelectRelayPeers(size_t size, const PeerPtr& excluded) {
+    std::vector<std::pair<double, PeerPtr>> candidates;
+    {
+        std::shared_lock<std::shared_mutex> lk(peerLock_);
+        candidates.reserve(peerMap_.size());
+        for (auto& peer : peerMap_) {
+            if (peer.second != excluded) {
+                candidates.emplace_back(peer.second->quality.GetScore(), peer.second);
+            }
+        }
+    }
+
+    size = std::min(size, candidates.size());
+    std::sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+
+    std::vector<PeerPtr> result;
+    result.reserve(size);
+
+    size_t nBest = (size + 1) / 2;
+    for (size_t i = 0; i < nBest; ++i) {
+        result.emplace_back(candidates[i].second);
+    }
+
+    // pick the rest randomly from the remaining peers, keeping the score order
+    std::vector<size_t> rest(candidates.size() - nBest);
+    std::iota(rest.begin(), rest.end(), nBest);
+    std::shuffle(rest.begin(), rest.end(), gen);
+    rest.resize(size - nBest);
+    std::sort(rest.begin(), rest.end());
+    for (auto i : rest) {
+        result.emplace_back(candidates[i].second);
+    }
+
+    return result;
+}
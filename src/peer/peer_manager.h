@@ -129,6 +129,13 @@ public:
 
     std::vector<PeerPtr> RandomlySelect(size_t, const PeerPtr& excluded = nullptr);
 
+    /**
+     * selects peers to relay blocks to, ordered from the best quality.
+     * Half of them are the best peers and the rest are chosen randomly
+     * so that new and recovering peers keep being measured
+     */
+    std::vector<PeerPtr> SelectRelayPeers(size_t, const PeerPtr& excluded = nullptr);
+
 private:
     /*
      * create a peer after a new connection is setup
@@ -234,6 +241,9 @@ private:
 
     constexpr static uint32_t kCheckSyncInterval = 1800;
 
+    // chronically slow peers are only evicted if we have more peers than this
+    const static size_t kMinPeersToEvict = 4;
+
     /**
      * my own peer id, a random number used to identify peer
      */
@@ -0,0 +1,82 @@
+// Copyright (c) 2019 EPI-ONE Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "peer_quality.h"
+
+#include <algorithm>
+
+static void UpdateAverage(double& average, double sample, size_t& nSamples) {
+    // the first sample initializes the average instead of being damped by zero
+    average = nSamples == 0 ? sample : average + PeerQuality::kWeight * (sample - average);
+    nSamples++;
+}
+
+void PeerQuality::AddRtt(uint64_t ms) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    UpdateAverage(rtt_, ms, nRtt_);
+}
+
+void PeerQuality::AddDelivery(size_t bytes, uint64_t ms) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    UpdateAverage(bandwidth_, bytes * 1000.0 / std::max<uint64_t>(ms, 1), nDeliveries_);
+    UpdateAverage(timeoutRate_, 0, nRequests_);
+}
+
+void PeerQuality::AddTimeout() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    UpdateAverage(timeoutRate_, 1, nRequests_);
+}
+
+void PeerQuality::AddMessage(bool valid) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    UpdateAverage(invalidRate_, valid ? 0 : 1, nMessages_);
+}
+
+double PeerQuality::GetRtt() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return rtt_;
+}
+
+double PeerQuality::GetBandwidth() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return bandwidth_;
+}
+
+double PeerQuality::GetTimeoutRate() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return timeoutRate_;
+}
+
+double PeerQuality::GetInvalidRate() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return invalidRate_;
+}
+
+double PeerQuality::GetScore() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    double rtt     = nRtt_ >= kMinSamples ? rtt_ : kDefaultRtt;
+    double latency = 1000 / (1000 + rtt);
+
+    double bandwidth = 0.5;
+    if (nDeliveries_ >= kMinSamples) {
+        bandwidth = bandwidth_ / (bandwidth_ + kReferenceBandwidth);
+    }
+
+    double reliability = 1;
+    if (nRequests_ >= kMinSamples) {
+        reliability *= 1 - timeoutRate_;
+    }
+    if (nMessages_ >= kMinSamples) {
+        reliability *= 1 - invalidRate_;
+    }
+
+    return (latency + bandwidth) / 2 * reliability;
+}
+
+bool PeerQuality::IsChronicallySlow() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return (nRtt_ >= kMinSamples && rtt_ > kMaxRtt) || (nRequests_ >= kMinSamples && timeoutRate_ > kMaxFailureRate) ||
+           (nMessages_ >= kMinSamples && invalidRate_ > kMaxFailureRate);
+}
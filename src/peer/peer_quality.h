@@ -0,0 +1,93 @@
+// Copyright (c) 2019 EPI-ONE Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef EPIC_PEER_QUALITY_H
+#define EPIC_PEER_QUALITY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+/**
+ * Quality of the link to a peer, measured from ping round trips,
+ * bundle deliveries and the messages it sends. All of the metrics
+ * are exponentially weighted moving averages.
+ */
+class PeerQuality {
+public:
+    /**
+     * adds the round trip time of a ping or a request in milliseconds
+     */
+    void AddRtt(uint64_t ms);
+
+    /**
+     * adds a request that was answered with the given bytes
+     * after the given milliseconds
+     */
+    void AddDelivery(size_t bytes, uint64_t ms);
+
+    /**
+     * adds a request that was never answered
+     */
+    void AddTimeout();
+
+    /**
+     * adds a message received from the peer, or a block it sent that
+     * turns out to be invalid after the message is processed
+     */
+    void AddMessage(bool valid);
+
+    double GetRtt() const;
+
+    double GetBandwidth() const;
+
+    double GetTimeoutRate() const;
+
+    double GetInvalidRate() const;
+
+    /**
+     * A score in [0, 1], higher for faster and more reliable peers.
+     * Peers with too few samples get a neutral score so that they
+     * still get a chance to be measured
+     */
+    double GetScore() const;
+
+    /**
+     * whether the peer has been measured enough to tell
+     * that it is too slow or unreliable to be kept
+     */
+    bool IsChronicallySlow() const;
+
+    // weight of the newest sample in the moving averages
+    constexpr static double kWeight = 0.2;
+
+    // number of samples needed before a metric is trusted
+    constexpr static size_t kMinSamples = 4;
+
+    // rtt assumed for peers that have not been measured
+    constexpr static double kDefaultRtt = 500; // ms
+
+    // bandwidth at which the bandwidth part of the score is 0.5
+    constexpr static double kReferenceBandwidth = 1 << 20; // bytes per second
+
+    // peers slower than this on average are evicted
+    constexpr static double kMaxRtt = 10000; // ms
+
+    // peers failing more requests or sending more invalid messages than this are evicted
+    constexpr static double kMaxFailureRate = 0.5;
+
+private:
+    mutable std::mutex mutex_;
+
+    double rtt_         = 0;
+    double bandwidth_   = 0;
+    double timeoutRate_ = 0;
+    double invalidRate_ = 0;
+    size_t nRtt_        = 0;
+    size_t nDeliveries_ = 0;
+    size_t nRequests_   = 0;
+    size_t nMessages_   = 0;
+};
+
+#endif // EPIC_PEER_QUALITY_H
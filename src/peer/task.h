@@ -6,6 +6,8 @@
 #define EPIC_TASK_H
 
 #include "sync_messages.h"
+#include "timer_wheel.h"
+
 #include <atomic>
 #include <chrono>
 #include <memory>
@@ -19,26 +21,56 @@ static uint32_t GetNewNonce() {
 
 class Task {
 public:
-    Task(uint32_t timeout) : nonce(GetNewNonce()) {
-        timeout_ = std::chrono::steady_clock::now() + std::chrono::seconds(timeout);
+    Task(uint32_t timeout) : nonce(GetNewNonce()), start_(std::chrono::steady_clock::now()) {
+        timeout_ = start_ + std::chrono::seconds(timeout);
     }
 
-    bool IsTimeout() {
-        if (completed_) {
-            return false;
-        }
-        return std::chrono::steady_clock::now() > timeout_;
+    ~Task() {
+        CancelTimeout();
+    }
+
+    /**
+     * registers a timer on the shared TimerWheel executing
+     * the callback if the task is not completed in time
+     */
+    void SetTimeoutCallback(std::function<void()>&& callback) {
+        auto remaining = std::max(timeout_ - std::chrono::steady_clock::now(), std::chrono::steady_clock::duration{});
+        auto onTimeout = [this, callback = std::move(callback)]() {
+            if (!completed_) {
+                callback();
+            }
+        };
+        timer_ = TimerWheel::Get().AddTimer(std::chrono::duration_cast<TimerWheel::Duration>(remaining),
+                                            std::move(onTimeout));
+    }
+
+    /**
+     * milliseconds since the task was created
+     */
+    uint64_t GetElapsed() const {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start_)
+            .count();
     }
 
     void Complete() {
         completed_ = true;
+        CancelTimeout();
     }
 
     uint32_t nonce;
 
 private:
+    std::chrono::time_point<std::chrono::steady_clock> start_;
     std::chrono::time_point<std::chrono::steady_clock> timeout_; // in seconds
-    std::atomic_bool completed_ = false;
+    std::atomic_bool completed_             = false;
+    std::atomic<TimerWheel::TimerId> timer_ = 0;
+
+    void CancelTimeout() {
+        auto timer = timer_.exchange(0);
+        if (timer) {
+            TimerWheel::Get().Cancel(timer);
+        }
+    }
 };
 
 class GetInvTask : public Task {
@@ -100,26 +132,18 @@ public:
         return tasks_.size();
     }
 
-    bool IsTimeout() {
-        std::shared_lock<std::shared_mutex> reader(mutex_);
-        for (auto& t : tasks_) {
-            if (t.second->IsTimeout()) {
-                return true;
-            }
-        }
-
-        return false;
-    }
-
-    bool CompleteTask(std::shared_ptr<Bundle> bundle) {
+    /**
+     * returns the task completed by the bundle, or nullptr if there is none
+     */
+    std::shared_ptr<GetDataTask> CompleteTask(std::shared_ptr<Bundle> bundle) {
         std::shared_lock<std::shared_mutex> reader(mutex_);
         auto task = tasks_.find(bundle->nonce);
         if (task != tasks_.end()) {
             task->second->bundle = bundle;
             task->second->Complete();
-            return true;
+            return task->second;
         }
-        return false;
+        return nullptr;
     }
 
     std::vector<std::shared_ptr<GetDataTask>> GetTasks() {
@@ -65,11 +65,16 @@ void Miner::Run() {
 
     // Restore distanceCal_
     if (selfChainHead_ && distanceCal_.Empty()) {
+        std::vector<ConstBlockPtr> window;
         auto cursor = selfChainHead_;
         do {
-            distanceCal_.Add(cursor, false);
+            window.push_back(cursor);
             cursor = STORE->FindBlock(cursor->GetPrevHash());
-        } while (*cursor != *GENESIS && !distanceCal_.Full());
+        } while (*cursor != *GENESIS && window.size() < GetParams().sortitionThreshold);
+
+        for (auto it = window.rbegin(); it != window.rend(); ++it) {
+            distanceCal_.Add(*it);
+        }
     }
 
     runner_ = std::thread([&]() {
@@ -157,7 +162,7 @@ void Miner::Run() {
                     PEERMAN->RelayBlock(bPtr, nullptr);
                 }
 
-                distanceCal_.Add(bPtr, true);
+                distanceCal_.Add(bPtr);
                 selfChainHead_ = bPtr;
                 selfChainHeads_.push(bPtr->GetHash());
                 dag_updated_ = false;
@@ -185,19 +190,9 @@ void Miner::Run() {
 }
 
 uint256 Miner::SelectTip() {
-    ConstBlockPtr selected;
-    auto bestchain = DAG->GetBestChain();
-
-    for (size_t i = 0; i < bestchain->GetPendingBlockCount(); ++i) {
-        selected = bestchain->GetRandomTip();
-
-        if (!selected) {
-            break;
-        }
-
-        if (selected->source != Block::MINER) {
-            return selected->GetHash();
-        }
+    auto selected = DAG->GetBestChain()->GetRandomForeignTip();
+    if (selected) {
+        return selected->GetHash();
     }
 
     return GENESIS->GetHash();
@@ -6,7 +6,9 @@
 #include "return_code.h"
 #include "rpc.pb.h"
 
+#include <algorithm>
 #include <google/protobuf/util/json_util.h>
+#include <memory>
 
 
 using namespace rpc;
@@ -48,9 +50,117 @@ op_string ProcessResponse(const OP& op, const Request& request, Response* respon
     }
 }
 
+/**
+ * issues the requests asynchronously with at most depth of them in flight
+ * @return the status of every request, the response of which is valid only if it is ok
+ */
+template <typename OP, typename Request, typename Response>
+std::vector<grpc::Status> PipelinedCallback(const OP& op,
+                                            const std::vector<Request>& requests,
+                                            size_t depth,
+                                            std::vector<Response>* responses) {
+    struct Call {
+        grpc::ClientContext context;
+        grpc::Status status;
+        Response response;
+        std::unique_ptr<grpc::ClientAsyncResponseReader<Response>> reader;
+    };
+
+    grpc::CompletionQueue cq;
+    auto calls = std::make_unique<Call[]>(requests.size());
+    size_t next = 0;
+    auto issue  = [&]() {
+        auto& call  = calls[next];
+        call.reader = op(&call.context, requests[next], &cq);
+        call.reader->Finish(&call.response, &call.status, reinterpret_cast<void*>(next));
+        ++next;
+    };
+
+    while (next < std::min(std::max<size_t>(depth, 1), requests.size())) {
+        issue();
+    }
+
+    void* tag;
+    bool ok;
+    for (size_t done = 0; done < requests.size() && cq.Next(&tag, &ok); ++done) {
+        auto& status = calls[reinterpret_cast<size_t>(tag)].status;
+        if (!ok) {
+            status = grpc::Status(grpc::StatusCode::CANCELLED, "request interrupted");
+        }
+        if (!status.ok()) {
+            std::cout << "No response from RPC server: " << status.error_message() << std::endl;
+        }
+
+        if (next < requests.size()) {
+            issue();
+        }
+    }
+    cq.Shutdown();
+    while (cq.Next(&tag, &ok)) {
+    }
+
+    std::vector<grpc::Status> statuses;
+    statuses.reserve(requests.size());
+    responses->resize(requests.size());
+    for (size_t i = 0; i < requests.size(); ++i) {
+        statuses.push_back(calls[i].status);
+        (*responses)[i] = std::move(calls[i].response);
+    }
+    return statuses;
+}
+
+/**
+ * merges the responses of the successful requests in order, and adds the indices
+ * of the items of the failed ones to failed, each request having batchSize items
+ * @return false if every request has failed
+ */
+template <typename Response>
+bool MergeResponses(const std::vector<grpc::Status>& statuses,
+                    const std::vector<Response>& responses,
+                    size_t batchSize,
+                    size_t nItems,
+                    Response* merged,
+                    std::vector<size_t>* failed) {
+    bool succeeded = statuses.empty();
+    for (size_t i = 0; i < statuses.size(); ++i) {
+        if (statuses[i].ok()) {
+            merged->MergeFrom(responses[i]);
+            succeeded = true;
+        } else if (failed) {
+            for (size_t item = i * batchSize; item < std::min((i + 1) * batchSize, nItems); ++item) {
+                failed->push_back(item);
+            }
+        }
+    }
+    return succeeded;
+}
+
+/**
+ * splits the items into requests of at most batchSize items each
+ */
+template <typename Request, typename Item, typename Add>
+std::vector<Request> SplitBatch(const std::vector<Item>& items, size_t batchSize, const Add& add) {
+    std::vector<Request> requests((items.size() + batchSize - 1) / batchSize);
+    for (size_t i = 0; i < items.size(); ++i) {
+        add(requests[i / batchSize], items[i]);
+    }
+    return requests;
+}
+
 RPCClient::RPCClient(std::shared_ptr<grpc::Channel> channel)
     : be_stub_(BasicBlockExplorerRPC::NewStub(channel)), commander_stub_(CommanderRPC::NewStub(channel)) {}
 
+std::shared_ptr<grpc::Channel> RPCClient::CreateChannel(const std::string& host) {
+    grpc::ChannelArguments args;
+    args.SetMaxReceiveMessageSize(-1);
+    return grpc::CreateCustomChannel(host, grpc::InsecureChannelCredentials(), args);
+}
+
+void RPCClient::SetPipeline(size_t batchSize, size_t pipelineDepth) {
+    batchSize_     = std::max<size_t>(batchSize, 1);
+    pipelineDepth_ = std::max<size_t>(pipelineDepth, 1);
+}
+
 op_string RPCClient::GetBlock(std::string block_hash) {
     GetBlockRequest request;
     request.set_hash(block_hash);
@@ -174,6 +284,48 @@ op_string RPCClient::Statistic() {
         request, &response);
 }
 
+op_string RPCClient::GetBlocks(const std::vector<std::string>& hashes, std::vector<size_t>* failed) {
+    auto requests = SplitBatch<GetBlocksRequest>(
+        hashes, batchSize_, [](GetBlocksRequest& request, const std::string& hash) { request.add_hashes(hash); });
+
+    std::vector<GetBlocksResponse> responses;
+    auto statuses = PipelinedCallback(
+        [&](auto* context, const auto& request, auto* cq) { return be_stub_->AsyncGetBlocks(context, request, cq); },
+        requests, pipelineDepth_, &responses);
+
+    GetBlocksResponse response;
+    if (!MergeResponses(statuses, responses, batchSize_, hashes.size(), &response, failed)) {
+        return {};
+    }
+
+    std::string result;
+    if (MessageToJsonString(response, &result, GetOption()).ok()) {
+        return result;
+    }
+    return {};
+}
+
+op_string RPCClient::GetVertices(const std::vector<std::string>& hashes, std::vector<size_t>* failed) {
+    auto requests = SplitBatch<GetBlocksRequest>(
+        hashes, batchSize_, [](GetBlocksRequest& request, const std::string& hash) { request.add_hashes(hash); });
+
+    std::vector<GetVerticesResponse> responses;
+    auto statuses = PipelinedCallback(
+        [&](auto* context, const auto& request, auto* cq) { return be_stub_->AsyncGetVertices(context, request, cq); },
+        requests, pipelineDepth_, &responses);
+
+    GetVerticesResponse response;
+    if (!MergeResponses(statuses, responses, batchSize_, hashes.size(), &response, failed)) {
+        return {};
+    }
+
+    std::string result;
+    if (MessageToJsonString(response, &result, GetOption()).ok()) {
+        return result;
+    }
+    return {};
+}
+
 op_string RPCClient::Status() {
     EmptyMessage request;
     StatusResponse response;
@@ -282,6 +434,57 @@ op_string RPCClient::CreateTx(const std::vector<std::pair<uint64_t, std::string>
     }
 }
 
+op_string RPCClient::CreateTxBatch(const std::vector<std::pair<TxOutputs, uint64_t>>& txs,
+                                   std::vector<size_t>* failed) {
+    auto requests = SplitBatch<CreateTxBatchRequest>(
+        txs, batchSize_, [](CreateTxBatchRequest& request, const std::pair<TxOutputs, uint64_t>& tx) {
+            auto rpc_tx = request.add_txs();
+            rpc_tx->set_fee(tx.second);
+            for (auto& output : tx.first) {
+                auto rpc_output = rpc_tx->add_outputs();
+                rpc_output->set_listing(output.second);
+                rpc_output->set_money(output.first);
+            }
+        });
+
+    std::vector<CreateTxBatchResponse> responses;
+    auto statuses = PipelinedCallback(
+        [&](auto* context, const auto& request, auto* cq) {
+            return commander_stub_->AsyncCreateTxBatch(context, request, cq);
+        },
+        requests, pipelineDepth_, &responses);
+
+    // the transactions of a failed request are marked by its error, so that the lines stay in order
+    std::string lines;
+    bool succeeded = requests.empty();
+    for (size_t i = 0; i < requests.size(); ++i) {
+        if (!statuses[i].ok()) {
+            for (int j = 0; j < requests[i].txs_size(); ++j) {
+                lines += "No response from RPC server: " + statuses[i].error_message() + '\n';
+                if (failed) {
+                    failed->push_back(i * batchSize_ + j);
+                }
+            }
+            continue;
+        }
+
+        succeeded = true;
+        for (const auto& r : responses[i].results()) {
+            auto result = r.result();
+            lines += GetReturnStr(result);
+            if (result == RPCReturn::kTxWrongAddr || result == RPCReturn::kTxCreatedSuc) {
+                lines += ": " + r.txinfo();
+            }
+            lines += '\n';
+        }
+    }
+
+    if (!succeeded) {
+        return {};
+    }
+    return lines;
+}
+
 op_string RPCClient::GetBalance() {
     EmptyMessage request;
     GetBalanceResponse response;
@@ -558,3 +761,38 @@ void RPCClient::DeleteSubscriber(const std::string &address){
         },
         request, &response);
 }
+
+std::optional<bool> RPCClient::SetTracing(bool enabled) {
+    SetTracingRequest request;
+    request.set_enabled(enabled);
+    BooleanResponse response;
+
+    if (!ClientCallback([&](auto* context, const auto& request, auto* response)
+                            -> grpc::Status { return commander_stub_->SetTracing(context, request, response); },
+                        request, &response)) {
+        return {};
+    }
+
+    return response.success();
+}
+
+std::optional<size_t> RPCClient::ExportTrace(std::ostream& out) {
+    EmptyMessage request;
+    ExportTraceResponse response;
+    grpc::ClientContext context;
+
+    size_t size = 0;
+    auto reader = commander_stub_->ExportTrace(&context, request);
+    while (reader->Read(&response)) {
+        out << response.trace();
+        size += response.trace().size();
+    }
+
+    grpc::Status status = reader->Finish();
+    if (!status.ok()) {
+        std::cout << "No response from RPC server: " << status.error_message() << std::endl;
+        return {};
+    }
+
+    return size;
+}
@@ -12,8 +12,23 @@
 
 class RPCClient {
 public:
+    using TxOutputs = std::vector<std::pair<uint64_t, std::string>>;
+
     explicit RPCClient(std::shared_ptr<grpc::Channel> channel);
 
+    /**
+     * a channel to the host without the default limit of 4MB on the size
+     * of a response, which a batch of large blocks may exceed
+     */
+    static std::shared_ptr<grpc::Channel> CreateChannel(const std::string& host);
+
+    /**
+     * splits every batch into requests of at most batchSize entries, and keeps
+     * up to pipelineDepth of them in flight at the same time on a completion queue,
+     * so that a large batch costs a few round trips instead of one per entry
+     */
+    void SetPipeline(size_t batchSize, size_t pipelineDepth);
+
     std::optional<std::string> GetBlock(std::string);
     std::optional<std::string> GetLevelSet(std::string);
     std::optional<std::string> GetLevelSetSize(std::string);
@@ -26,6 +41,14 @@ public:
     std::optional<std::string> GetRecentStat();
     std::optional<std::string> Statistic();
 
+    /**
+     * the merged results of the batch requests which have succeeded, or nullopt if all have failed;
+     * the indices of the hashes whose requests have failed are added to failed
+     */
+    std::optional<std::string> GetBlocks(const std::vector<std::string>& hashes, std::vector<size_t>* failed = nullptr);
+    std::optional<std::string> GetVertices(const std::vector<std::string>& hashes,
+                                           std::vector<size_t>* failed = nullptr);
+
     std::optional<std::string> Status();
 
     bool Stop();
@@ -37,6 +60,9 @@ public:
     std::optional<std::string> Redeem(const std::string& addr, uint64_t coins);
     std::optional<std::string> CreateRandomTx(size_t size);
     std::optional<std::string> CreateTx(const std::vector<std::pair<uint64_t, std::string>>& outputs, uint64_t fee);
+    // the result of every transaction on its own line, which is the error for those whose request has failed
+    std::optional<std::string> CreateTxBatch(const std::vector<std::pair<TxOutputs, uint64_t>>& txs,
+                                             std::vector<size_t>* failed = nullptr);
     std::optional<std::string> GenerateNewKey();
 
     std::optional<std::string> SetPassphrase(const std::string& passphrase);
@@ -58,9 +84,19 @@ public:
     std::optional<std::string> Subscribe(const std::string& address, uint8_t sub_type);
     void DeleteSubscriber(const std::string& address);
 
+    std::optional<bool> SetTracing(bool enabled);
+    /**
+     * writes the streamed trace to out
+     * @return the size of the trace in bytes
+     */
+    std::optional<size_t> ExportTrace(std::ostream& out);
+
 private:
     std::unique_ptr<rpc::BasicBlockExplorerRPC::Stub> be_stub_;
     std::unique_ptr<rpc::CommanderRPC::Stub> commander_stub_;
+
+    size_t batchSize_     = 1000;
+    size_t pipelineDepth_ = 8;
 };
 
 #endif // EPIC_RPC_CLIENT_H
@@ -8,8 +8,6 @@
 #include "mempool.h"
 #include "rpc_tools.h"
 
-#include <numeric>
-
 using namespace rpc;
 
 grpc::Status BasicBlockExplorerRPCServiceImpl::GetBlock(grpc::ServerContext* context,
@@ -133,16 +131,30 @@ grpc::Status BasicBlockExplorerRPCServiceImpl::GetPeerChains(grpc::ServerContext
 grpc::Status BasicBlockExplorerRPCServiceImpl::GetRecentStat(grpc::ServerContext* context,
                                                              const EmptyMessage* request,
                                                              GetRecentStatResponse* response) {
-    const auto chain = DAG->GetBestChain()->GetMilestones();
+    const auto windows = DAG->GetRecentStat();
+    for (const auto& window : windows) {
+        auto rpcWindow = response->add_windows();
+        rpcWindow->set_seconds(window.seconds);
+        rpcWindow->set_timefrom(window.timeFrom);
+        rpcWindow->set_timeto(window.timeTo);
+        rpcWindow->set_nblks(window.counters.nBlks);
+        rpcWindow->set_ntxs(window.counters.nTxs);
+        rpcWindow->set_tps(window.GetTPS());
+        rpcWindow->set_lvssize(window.GetAvgLvsSize());
+        rpcWindow->set_nforks(window.counters.nForks);
+        rpcWindow->set_orphanrate(window.GetOrphanRate());
+    }
 
+    // the legacy fields cover the milestones cached in the best chain
+    const auto bestChain = DAG->GetBestChain();
+    const auto& chain    = bestChain->GetMilestones();
+    if (chain.empty()) {
+        return grpc::Status::OK;
+    }
     response->set_timefrom(chain.front()->GetLevelSet().front().lock()->cblock->GetTime());
     response->set_timeto(chain.back()->GetMilestone()->cblock->GetTime());
 
-    const auto [totalblk, totaltx] = std::accumulate(
-        chain.begin(), chain.end(), std::pair{0, 0},
-        [](std::pair<uint32_t, uint32_t> sum, auto chain_elem) -> std::pair<uint32_t, uint32_t> {
-            return {sum.first + chain_elem->GetLevelSet().size(), sum.second + chain_elem->GetNumOfValidTxns()};
-        });
+    const auto [totalblk, totaltx] = bestChain->GetCachedCount();
     response->set_nblks(totalblk);
     response->set_ntxs(totaltx);
 
@@ -161,9 +173,9 @@ grpc::Status BasicBlockExplorerRPCServiceImpl::Statistic(grpc::ServerContext* co
         response->set_nblks(stat.nBlkCnt);
         response->set_ntxs(stat.nTxCnt);
 
-        const auto tEnd = STORE->GetLevelSetBlksAt(bestchain->GetMilestones().front()->height - 1).front()->GetTime();
-        auto tps        = response->ntxs() / static_cast<double>(tEnd - stat.tStart);
-        response->set_tps(tps);
+        if (stat.tEnd > stat.tStart) {
+            response->set_tps(response->ntxs() / static_cast<double>(stat.tEnd - stat.tStart));
+        }
 
         if (MEMPOOL) {
             response->set_mempool(MEMPOOL->Size());
@@ -171,3 +183,35 @@ grpc::Status BasicBlockExplorerRPCServiceImpl::Statistic(grpc::ServerContext* co
     }
     return grpc::Status::OK;
 }
+
+grpc::Status BasicBlockExplorerRPCServiceImpl::GetBlocks(grpc::ServerContext* context,
+                                                         const GetBlocksRequest* request,
+                                                         GetBlocksResponse* response) {
+    auto blocks = response->mutable_blocks();
+    blocks->Reserve(request->hashes_size());
+    for (const auto& hash : request->hashes()) {
+        auto vertex = DAG->GetMainChainVertex(uintS<256>(hash));
+        if (vertex) {
+            blocks->AddAllocated(ToRPCBlock(*(vertex->cblock)));
+        } else {
+            blocks->Add();
+        }
+    }
+    return grpc::Status::OK;
+}
+
+grpc::Status BasicBlockExplorerRPCServiceImpl::GetVertices(grpc::ServerContext* context,
+                                                           const GetBlocksRequest* request,
+                                                           GetVerticesResponse* response) {
+    auto vertices = response->mutable_vertices();
+    vertices->Reserve(request->hashes_size());
+    for (const auto& hash : request->hashes()) {
+        auto vertex = DAG->GetMsVertex(uintS<256>(hash));
+        if (vertex) {
+            vertices->AddAllocated(ToRPCVertex(*vertex));
+        } else {
+            vertices->Add();
+        }
+    }
+    return grpc::Status::OK;
+}
@@ -55,6 +55,14 @@ public:
                            const rpc::EmptyMessage* request,
                            rpc::StatisticResponse* response) override;
 
+    grpc::Status GetBlocks(grpc::ServerContext* context,
+                           const rpc::GetBlocksRequest* request,
+                           rpc::GetBlocksResponse* response) override;
+
+    grpc::Status GetVertices(grpc::ServerContext* context,
+                             const rpc::GetBlocksRequest* request,
+                             rpc::GetVerticesResponse* response) override;
+
     ~BasicBlockExplorerRPCServiceImpl() = default;
 };
 
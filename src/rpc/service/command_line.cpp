@@ -10,6 +10,7 @@
 #include "rpc.pb.h"
 #include "rpc_tools.h"
 #include "subscription.h"
+#include "tracing.h"
 #include "wallet.h"
 
 using namespace rpc;
@@ -177,6 +178,17 @@ grpc::Status CommanderRPCServiceImpl::CreateTx(grpc::ServerContext* context,
     return grpc::Status::OK;
 }
 
+grpc::Status CommanderRPCServiceImpl::CreateTxBatch(grpc::ServerContext* context,
+                                                    const CreateTxBatchRequest* request,
+                                                    CreateTxBatchResponse* reply) {
+    auto results = reply->mutable_results();
+    results->Reserve(request->txs_size());
+    for (const auto& tx : request->txs()) {
+        CreateTx(context, &tx, results->Add());
+    }
+    return grpc::Status::OK;
+}
+
 grpc::Status CommanderRPCServiceImpl::GenerateNewKey(grpc::ServerContext* context,
                                                      const EmptyMessage* request,
                                                      GenerateNewKeyResponse* reply) {
@@ -460,3 +472,26 @@ grpc::Status CommanderRPCServiceImpl::DelSubscriber(grpc::ServerContext* context
 
     return grpc::Status::OK;
 }
+
+grpc::Status CommanderRPCServiceImpl::SetTracing(grpc::ServerContext* context,
+                                                 const rpc::SetTracingRequest* request,
+                                                 rpc::BooleanResponse* response) {
+    Tracer::Enable(request->enabled());
+    response->set_success(true);
+    return grpc::Status::OK;
+}
+
+grpc::Status CommanderRPCServiceImpl::ExportTrace(grpc::ServerContext* context,
+                                                  const rpc::EmptyMessage* request,
+                                                  grpc::ServerWriter<rpc::ExportTraceResponse>* writer) {
+    // streamed in chunks, as the buffers of all threads are larger than the default limit of a message
+    rpc::ExportTraceResponse response;
+    bool completed = Tracer::ExportJson([&](std::string&& chunk) {
+        response.set_trace(std::move(chunk));
+        return writer->Write(response);
+    });
+    if (!completed) {
+        return grpc::Status(grpc::StatusCode::CANCELLED, "Trace export interrupted");
+    }
+    return grpc::Status::OK;
+}
@@ -45,6 +45,10 @@ class CommanderRPCServiceImpl final : public rpc::CommanderRPC::Service {
                           const rpc::CreateTxRequest* request,
                           rpc::CreateTxResponse* reply) override;
 
+    grpc::Status CreateTxBatch(grpc::ServerContext* context,
+                               const rpc::CreateTxBatchRequest* request,
+                               rpc::CreateTxBatchResponse* reply) override;
+
     grpc::Status GenerateNewKey(grpc::ServerContext* context,
                                 const rpc::EmptyMessage* request,
                                 rpc::GenerateNewKeyResponse* reply) override;
@@ -108,6 +112,15 @@ class CommanderRPCServiceImpl final : public rpc::CommanderRPC::Service {
     grpc::Status DelSubscriber(grpc::ServerContext* context,
                                const rpc::DelSubscriberRequest* request,
                                rpc::EmptyMessage* response) override;
+
+    grpc::Status SetTracing(grpc::ServerContext* context,
+                            const rpc::SetTracingRequest* request,
+                            rpc::BooleanResponse* response) override;
+
+    grpc::Status ExportTrace(grpc::ServerContext* context,
+                             const rpc::EmptyMessage* request,
+                             grpc::ServerWriter<rpc::ExportTraceResponse>* writer) override;
+
 private:
     void AddPeer(rpc::ShowPeerResponse* response, std::shared_ptr<Peer> peer);
 };
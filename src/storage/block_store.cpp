@@ -4,7 +4,10 @@
 
 #include "block_store.h"
 #include "crc32.h"
+#include "log.h"
+#include "tracing.h"
 
+#include <array>
 #include <filesystem>
 
 template <typename P>
@@ -33,7 +36,15 @@ template std::vector<ConstBlockPtr> DeserializeRawLvs(VStream&&);
 template std::vector<VertexPtr> DeserializeRawLvs(VStream&&);
 
 BlockStore::BlockStore(const std::string& dbPath)
-    : obcThread_(1), obcEnabled_(false), checksumCalThread_(1), lastUpdateTaskTime_(time(nullptr)), dbStore_(dbPath) {
+    : obcThread_(1, LARGE_CAPACITY),
+      obcEnabled_(false),
+      checksumCalThread_(1),
+      lastUpdateTaskTime_(time(nullptr)),
+      pruneThread_(1),
+      dbStore_(dbPath),
+      io_(CreateIOBackend()) {
+    spdlog::info("[STORE] Using {} for block files", io_->GetName());
+    RecoverVtxRewrite();
     obcThread_.Start();
     obcTimeout_.AddPeriodTask(300, [this]() {
         obcThread_.Execute([this]() {
@@ -43,16 +54,23 @@ BlockStore::BlockStore(const std::string& dbPath)
             }
         });
     });
+    obcTimeout_.AddPeriodTask(600, [this]() {
+        if (pruneWindow_.load() > 0 && pruneThread_.IsIdle()) {
+            pruneThread_.Execute([this]() { Prune(); });
+        }
+    });
     obcTimeout_.Start();
     checksumCalThread_.Start();
+    pruneThread_.Start();
 }
 
 void BlockStore::AddBlockToOBC(ConstBlockPtr&& blk, const uint8_t& mask) {
     obcThread_.Execute([blk = std::move(blk), mask, this]() mutable {
-        spdlog::trace("[OBC] AddBlockToOBC {}", blk->GetHash().to_substr());
+        LOG_TRACE("[OBC] AddBlockToOBC {}", blk->GetHash().to_substr());
         if (!obcEnabled_.load()) {
             return;
         }
+        TRACE_ASYNC_BEGIN("OBC", blk->GetHash());
         obc_.AddBlock(std::move(blk), mask);
     });
 }
@@ -61,6 +79,7 @@ void BlockStore::ReleaseBlocks(const uint256& blkHash) {
     obcThread_.Execute([blkHash, this]() {
         auto releasedBlocks = obc_.SubmitHash(blkHash);
         for (auto& blk : releasedBlocks) {
+            TRACE_ASYNC_END("OBC", blk->GetHash());
             DAG->AddNewBlock(std::move(blk), nullptr);
         }
     });
@@ -106,13 +125,29 @@ ConstBlockPtr BlockStore::FindBlock(const uint256& blkHash) const {
 }
 
 VertexPtr BlockStore::GetMilestoneAt(size_t height) const {
-    VertexPtr vtx = ConstructNRFromFile(dbStore_.GetMsPos(height));
+    VertexPtr vtx;
+    {
+        std::shared_lock<std::shared_mutex> lock(vtxFileMutex_);
+        vtx = ConstructNRFromFile(dbStore_.GetMsPos(height));
+    }
     vtx->snapshot->PushBlkToLvs(vtx);
     return vtx;
 }
 
+uint256 BlockStore::GetMilestoneHashAt(size_t height) const {
+    return dbStore_.GetMsHashAt(height);
+}
+
 VertexPtr BlockStore::GetVertex(const uint256& blkHash, bool withBlock) const {
-    VertexPtr vtx = ConstructNRFromFile(dbStore_.GetVertexPos(blkHash), withBlock);
+    VertexPtr vtx;
+    {
+        std::shared_lock<std::shared_mutex> lock(vtxFileMutex_);
+        vtx = ConstructNRFromFile(dbStore_.GetVertexPos(blkHash), withBlock);
+    }
+    if (vtx && vtx->height == 0) {
+        // only the milestone record of a level set keeps the height
+        vtx->SetHeight(dbStore_.GetHeight(blkHash));
+    }
     if (vtx && vtx->isMilestone) {
         vtx->snapshot->PushBlkToLvs(vtx);
     }
@@ -126,6 +161,7 @@ std::vector<VertexPtr> BlockStore::GetLevelSetVtcsAt(size_t height, bool withBlo
 
     const auto& ms = result.back();
     for (const auto& b : result) {
+        b->SetHeight(ms->height);
         ms->snapshot->PushBlkToLvs(b);
     }
 
@@ -173,6 +209,51 @@ VStream BlockStore::GetRawLevelSetAt(size_t height, file::FileType fType) const
 }
 
 VStream BlockStore::GetRawLevelSetBetween(size_t height1, size_t height2, file::FileType fType) const {
+    std::shared_lock<std::shared_mutex> lock(vtxFileMutex_, std::defer_lock);
+    if (fType == file::FileType::VTX) {
+        lock.lock();
+    }
+
+    auto ranges = GetLevelSetRanges(height1, height2, fType);
+    if (ranges.empty()) {
+        return {};
+    }
+
+    auto result = io_->Read(ranges);
+    if (!result) {
+        return {};
+    }
+    return std::move(*result);
+}
+
+void BlockStore::GetRawLevelSetAtAsync(size_t height,
+                                       ThreadPool& pool,
+                                       std::function<void(VStream)> callback,
+                                       file::FileType fType) const {
+    std::vector<ReadRange> ranges;
+    uint32_t nRewrites;
+    {
+        std::shared_lock<std::shared_mutex> lock(vtxFileMutex_);
+        ranges    = GetLevelSetRanges(height, height, fType);
+        nRewrites = nVtxRewrites_.load();
+    }
+    if (ranges.empty()) {
+        pool.Execute([callback = std::move(callback)]() { callback({}); });
+        return;
+    }
+
+    io_->AsyncRead(std::move(ranges), pool,
+                   [this, height, fType, nRewrites, callback = std::move(callback)](std::optional<VStream> result) {
+                       // the ranges are stale if the VTX file is rewritten before being opened
+                       if (fType == file::FileType::VTX && nVtxRewrites_.load() != nRewrites) {
+                           callback(GetRawLevelSetAt(height, fType));
+                           return;
+                       }
+                       callback(result ? std::move(*result) : VStream{});
+                   });
+}
+
+std::vector<ReadRange> BlockStore::GetLevelSetRanges(size_t height1, size_t height2, file::FileType fType) const {
     assert(height1 <= height2);
 
     auto left  = dbStore_.GetMsPos(height1);
@@ -200,58 +281,51 @@ VStream BlockStore::GetRawLevelSetBetween(size_t height1, size_t height2, file::
         return {};
     }
 
-    VStream result;
+    std::vector<ReadRange> ranges;
     if (!leftPos) {
-        return result;
+        return ranges;
     }
 
-    FileReader reader(fType, *leftPos);
     auto leftOffset  = leftPos->nOffset;
     auto rightOffset = rightPos ? rightPos->nOffset : 0;
 
     if (rightPos && leftPos->SameFileAs(*rightPos)) {
-        reader.read(rightOffset - leftOffset, result);
-        return result;
+        ranges.push_back({file::GetFilePath(fType, *leftPos), leftOffset, rightOffset - leftOffset});
+        return ranges;
     }
 
-    // Read all of the first file
-    auto size = reader.Size();
-    reader.read(size - leftOffset, result);
-    reader.Close();
+    // All of the first file
+    auto size = file::GetFileSize(fType, *leftPos);
+    ranges.push_back({file::GetFilePath(fType, *leftPos), leftOffset, uint32_t(size - leftOffset)});
 
     if (rightPos) {
-        // Read files between leftPos and rightPos (exclusive)
+        // Files between leftPos and rightPos (exclusive)
         auto file = NextFile(*leftPos);
         while (file < *rightPos && !file.SameFileAs(*rightPos)) {
-            FileReader cursor(fType, file);
-            size = cursor.Size();
-            cursor.read(size - file::checksum_size, result);
-            cursor.Close();
+            size = file::GetFileSize(fType, file);
+            ranges.push_back({file::GetFilePath(fType, file), file::checksum_size, uint32_t(size - file::checksum_size)});
             NextFile(file);
         }
 
-        // Read the last file
-        if (file.nOffset > file::checksum_size) {
-            FileReader cursor(fType, file);
-            cursor.read(rightOffset - file::checksum_size, result);
-            cursor.Close();
+        // The last file up to rightPos
+        if (rightOffset > file::checksum_size) {
+            ranges.push_back({file::GetFilePath(fType, file), file::checksum_size, rightOffset - file::checksum_size});
         }
-        return result;
+        return ranges;
     }
 
-    // Read at most 20 of the rest files
+    // At most 20 of the rest files
     static const size_t nFilesMax = 20;
 
     auto file     = NextFile(*leftPos);
     size_t nFiles = 0;
     while (CheckFileExist(file::GetFilePath(fType, file)) && nFiles < nFilesMax) {
-        FileReader cursor(fType, file);
-        size = cursor.Size();
-        cursor.read(size - file::checksum_size, result);
+        size = file::GetFileSize(fType, file);
+        ranges.push_back({file::GetFilePath(fType, file), file::checksum_size, uint32_t(size - file::checksum_size)});
         NextFile(file);
         nFiles++;
     }
-    return result;
+    return ranges;
 }
 
 size_t BlockStore::GetHeight(const uint256& blkHash) const {
@@ -266,6 +340,10 @@ bool BlockStore::SaveHeadHeight(uint64_t height) const {
     return dbStore_.WriteInfo("headHeight", height);
 }
 
+uint64_t BlockStore::GetLowestHeight() const {
+    return dbStore_.GetInfo<uint64_t>("lowestHeight");
+}
+
 uint256 BlockStore::GetBestChainWork() const {
     return dbStore_.GetInfo<uint256>("chainwork");
 }
@@ -315,12 +393,20 @@ bool BlockStore::RollBackPrevRedemHashes(const RegChange& change) const {
 }
 
 bool BlockStore::UpdateRedemptionStatus(const uint256& key) const {
+    std::shared_lock<std::shared_mutex> lock(vtxFileMutex_);
     auto pos = dbStore_.GetVertexPos(key);
     if (!pos) {
         return false;
     }
+
+    // keep the rest of the record header
+    uint8_t header;
+    FileReader vtxReader{file::VTX, pos->second};
+    vtxReader >> header;
+    vtxReader.Close();
+
     FileModifier vtxmod{file::VTX, pos->second};
-    vtxmod << static_cast<uint8_t>(Vertex::RedemptionStatus::IS_REDEEMED);
+    vtxmod << static_cast<uint8_t>((header & ~Vertex::REDEMPTION_MASK) | Vertex::RedemptionStatus::IS_REDEEMED);
     vtxmod.Flush();
     vtxmod.Close();
 
@@ -333,86 +419,100 @@ std::unordered_map<uint256, uint256> BlockStore::GetAllReg() const {
 }
 
 bool BlockStore::StoreLevelSet(const std::vector<VertexWPtr>& lvs) {
-    try {
-        // Function to sum up storage sizes for blk and vtx in this lvs
-        auto sumSize = [](const std::pair<uint32_t, uint32_t>& prevSum,
-                          const VertexWPtr& vtx) -> std::pair<uint32_t, uint32_t> {
-            return std::make_pair(prevSum.first + (*vtx.lock()).cblock->GetOptimalEncodingSize(),
-                                  prevSum.second + (*vtx.lock()).GetOptimalStorageSize());
-        };
+    std::vector<VertexPtr> sLvs;
+    sLvs.reserve(lvs.size());
+    std::transform(lvs.begin(), lvs.end(), std::back_inserter(sLvs), [](const VertexWPtr& p) { return p.lock(); });
+    return StoreLevelSet(sLvs);
+}
+
+bool BlockStore::StoreLevelSet(const std::vector<VertexPtr>& lvs) {
+    return StoreLevelSet(SerializeLevelSet(lvs));
+}
+
+SerializedLevelSet BlockStore::SerializeLevelSet(const std::vector<VertexPtr>& lvs) {
+    SerializedLevelSet result;
+
+    const auto& ms   = *lvs.back();
+    result.height    = ms.height;
+    result.msHash    = ms.cblock->GetHash();
+    result.chainwork = ArithToUint256(ms.snapshot->chainwork);
+
+    result.hashes.reserve(lvs.size());
+    result.blkOffsets.reserve(lvs.size());
+    result.vtxOffsets.reserve(lvs.size());
+
+    // Store ms first, which is the only one keeping the height
+    result.blks << *ms.cblock;
+    result.vtcs << ms;
+    result.hashes.push_back(result.msHash);
+    result.blkOffsets.push_back(0);
+    result.vtxOffsets.push_back(0);
+
+    for (size_t i = 0; i < lvs.size() - 1; ++i) {
+        const auto& vtx = *lvs[i];
+        result.hashes.push_back(vtx.cblock->GetHash());
+        result.blkOffsets.push_back(result.blks.size());
+        result.vtxOffsets.push_back(result.vtcs.size());
+        result.blks << *(vtx.cblock);
+        vtx.Serialize(result.vtcs, false);
+    }
 
+    return result;
+}
+
+bool BlockStore::StoreLevelSet(const SerializedLevelSet& lvs) {
+    try {
         // pair of (total block size, total vertex size)
-        std::pair<uint32_t, uint32_t> totalSize =
-            std::accumulate(lvs.begin(), lvs.end(), std::make_pair(0, 0), sumSize);
+        std::pair<uint32_t, uint32_t> totalSize(lvs.blks.size(), lvs.vtcs.size());
 
         CarryOverFileName(totalSize);
 
         FilePos msBlkPos{loadCurrentBlkEpoch(), loadCurrentBlkName(), loadCurrentBlkSize()};
         FilePos msVtxPos{loadCurrentVtxEpoch(), loadCurrentVtxName(), loadCurrentVtxSize()};
-        FileWriter blkFs{file::BLK, msBlkPos};
-        FileWriter vtxFs{file::VTX, msVtxPos};
 
-        // reserve space for checksum
-        uint32_t init_checksum = 0;
-        if (blkFs.Size() == 0) {
-            currentBlkSize_.store(file::checksum_size);
-            msBlkPos.nOffset = file::checksum_size;
-            blkFs << init_checksum;
-        }
-        if (vtxFs.Size() == 0) {
-            currentVtxSize_.store(file::checksum_size);
-            msVtxPos.nOffset = file::checksum_size;
-            vtxFs << init_checksum;
-        }
-
-        const auto& ms  = (*lvs.back().lock());
-        uint64_t height = ms.height;
-
-        // Store ms to file
-        blkFs << *ms.cblock;
-        vtxFs << ms;
-        dbStore_.WriteVtxPos(ms.cblock->GetHash(), height, 0, 0);
-        uint32_t blkOffset;
-        uint32_t vtxOffset;
-
-        for (size_t i = 0; i < lvs.size() - 1; ++i) {
-            // Write to file
-            const auto& vtx = (*lvs[i].lock());
-            blkOffset       = blkFs.GetOffsetP() - msBlkPos.nOffset;
-            vtxOffset       = vtxFs.GetOffsetP() - msVtxPos.nOffset;
-            blkFs << *(vtx.cblock);
-            vtxFs << vtx;
-
-            // Write positions to db
-            dbStore_.WriteVtxPos(vtx.cblock->GetHash(), height, blkOffset, vtxOffset);
+        // Append the whole lvs to files at once
+        if (!AppendToFile(file::BLK, msBlkPos, lvs.blks) || !AppendToFile(file::VTX, msVtxPos, lvs.vtcs)) {
+            return false;
         }
 
-        blkFs.Flush();
-        blkFs.Close();
-        vtxFs.Flush();
-        vtxFs.Close();
+        // Write positions to db in one batch
+        dbStore_.WriteVtxPoses(lvs.hashes, std::vector<uint64_t>(lvs.hashes.size(), lvs.height), lvs.blkOffsets,
+                               lvs.vtxOffsets);
 
         // Write ms position at last to enable search for all blocks in the lvs
-        dbStore_.WriteMsPos(height, ms.cblock->GetHash(), msBlkPos, msVtxPos);
-        STORE->SaveBestChainWork(ArithToUint256(ms.snapshot->chainwork));
+        dbStore_.WriteMsPos(lvs.height, lvs.msHash, msBlkPos, msVtxPos);
+        STORE->SaveBestChainWork(lvs.chainwork);
 
         AddCurrentSize(totalSize);
 
-        spdlog::trace("[STORE] Storing LVS with MS hash {} of height {} with current file pos {}", ms.height, height,
-                      std::to_string(*dbStore_.GetMsBlockPos(height)));
+        spdlog::trace("[STORE] Storing LVS with MS hash {} of height {} with current file pos {}",
+                      lvs.msHash.to_substr(), lvs.height, std::to_string(*dbStore_.GetMsBlockPos(lvs.height)));
     } catch (const std::exception&) {
         return false;
     }
     return true;
 }
 
-bool BlockStore::StoreLevelSet(const std::vector<VertexPtr>& lvs) {
-    std::vector<VertexWPtr> wLvs;
-    std::transform(lvs.begin(), lvs.end(), std::back_inserter(wLvs), [](VertexPtr p) {
-        VertexWPtr wptr = p;
-        return wptr;
-    });
-    return StoreLevelSet(wLvs);
+bool BlockStore::AppendToFile(file::FileType type, FilePos& pos, const VStream& data) {
+    const std::string dir = file::GetEpochPath(type, pos.nEpoch);
+    if (!CheckDirExist(dir) && !MkdirRecursive(dir)) {
+        spdlog::error("[STORE] Failed to create directory {}", dir);
+        return false;
+    }
+
+    const std::string path = file::GetFilePath(type, pos);
+
+    // reserve space for checksum
+    if (file::GetFileSize(type, pos) == 0) {
+        static const std::array<char, file::checksum_size> init_checksum{};
+        if (!io_->Write(path, 0, init_checksum.data(), init_checksum.size())) {
+            return false;
+        }
+        (type == file::BLK ? currentBlkSize_ : currentVtxSize_).store(file::checksum_size);
+        pos.nOffset = file::checksum_size;
+    }
+
+    return io_->Write(path, pos.nOffset, data.data(), data.size());
 }
 
 void BlockStore::UnCache(const uint256& blkHash) {
@@ -453,7 +553,7 @@ void BlockStore::Cache(const ConstBlockPtr& blk) {
 }
 
 void BlockStore::Wait() {
-    while (obc_.Size() > 0 || !obcThread_.IsIdle()) {
+    while (obc_.Size() > 0 || !obcThread_.IsIdle() || !pruneThread_.IsIdle()) {
         std::this_thread::yield();
     }
 }
@@ -463,6 +563,8 @@ void BlockStore::Stop() {
     obcThread_.Abort();
     obcThread_.Stop();
     obcTimeout_.Stop();
+    pruneThread_.Abort();
+    pruneThread_.Stop();
     while (!checksumTasks_.empty()) {
         spdlog::info("{} checksum tasks left, executing...", checksumTasks_.size());
         ExecuteChecksumTask();
@@ -564,19 +666,28 @@ FileCheckInfo BlockStore::CheckOneType(file::FileType type) {
         spdlog::error("File {} doesn't exit", file::GetFilePath(type, FilePos(0, 0, 0)));
         return result;
     }
-    for (size_t epoch = 0; epoch < all_epoches.size(); epoch++) {
+    // files in front of the first one may have been pruned
+    size_t firstEpoch = *std::min_element(all_epoches.begin(), all_epoches.end());
+    size_t lastEpoch  = firstEpoch + all_epoches.size() - 1;
+    for (size_t epoch = firstEpoch; epoch <= lastEpoch; epoch++) {
+        size_t begin = 0;
         size_t end   = epochCapacity_;
         result.epoch = epoch;
-        if (epoch == all_epoches.size() - 1) {
+        if (epoch == firstEpoch || epoch == lastEpoch) {
             auto all_names = file::GetAllName(epoch, type);
             if (all_names.empty()) {
                 spdlog::error("File {} doesn't exit", file::GetFilePath(type, FilePos(epoch, 0, 0)));
                 result.name = 0;
                 return result;
             }
-            end = all_names.size();
+            if (epoch == firstEpoch) {
+                begin = *std::min_element(all_names.begin(), all_names.end());
+            }
+            if (epoch == lastEpoch) {
+                end = begin + all_names.size();
+            }
         }
-        for (size_t name = 0; name < end; name++) {
+        for (size_t name = begin; name < end; name++) {
             result.name = name;
             if (!CheckOneFile(type, epoch, name)) {
                 return result;
@@ -745,6 +856,11 @@ size_t BlockStore::GetHeightFromInvalidFile(FilePos pos, file::FileType type) {
         search_pos.nName  = pos.nName - 1;
         search_pos.nEpoch = pos.nEpoch;
     }
+
+    // the invalid file is the first one kept by a pruned node
+    if (!CheckFileExist(file::GetFilePath(type, search_pos))) {
+        return GetLowestHeight();
+    }
     return GetlatestHeightFromFile(search_pos, type) + 1;
 }
 
@@ -790,6 +906,12 @@ bool BlockStore::DeleteDBBlks(uint64_t height) {
 }
 
 bool BlockStore::RebuildConsensus(uint64_t height) {
+    // UTXOs and registrations are rebuilt from the genesis
+    if (GetLowestHeight() > 0) {
+        spdlog::error("Level sets below height {} have been pruned, please restart with a new DB", GetLowestHeight());
+        return false;
+    }
+
     // delete two columns in db  UTXO, Reg
     std::string column1 = "utxo";
     std::string column2 = "reg";
@@ -925,11 +1047,283 @@ void BlockStore::AddChecksumTask(FilePos pos) {
 }
 
 void BlockStore::ExecuteChecksumTask() {
-    auto it = checksumTasks_.begin();
-    if (it == checksumTasks_.end()) {
+    // the storage thread and the prune thread may both drain the tasks
+    auto task = checksumTasks_.TryPop();
+    if (!task) {
+        return;
+    }
+    checksumCalThread_.Execute([task = *task]() { file::CalculateChecksum(file::VTX, task); });
+}
+
+void BlockStore::SetPruneWindow(uint64_t window) {
+    pruneWindow_ = window;
+    if (window > 0) {
+        spdlog::info("[STORE] Pruning enabled, keeping level sets of the latest {} heights", window);
+    }
+}
+
+bool BlockStore::Prune() {
+    auto window     = pruneWindow_.load();
+    auto headHeight = GetHeadHeight();
+    auto lowest     = GetLowestHeight();
+    if (window == 0 || headHeight < window || headHeight - window <= lowest) {
+        return true;
+    }
+
+    // all files lying in front of the ones holding this height are sealed and below the window
+    auto threshold = dbStore_.GetMsPos(headHeight - window);
+    if (!threshold) {
+        spdlog::error("[STORE] Failed to get the ms pos at height {} for pruning", headHeight - window);
+        return false;
+    }
+    auto [blkThreshold, vtxThreshold] = *threshold;
+
+    auto isPruned = [](const FilePos& pos, const FilePos& threshold) {
+        return pos.nEpoch < threshold.nEpoch || (pos.nEpoch == threshold.nEpoch && pos.nName < threshold.nName);
+    };
+
+    // find the first level set of which both files are kept
+    uint64_t newLowest = lowest;
+    while (newLowest < headHeight - window) {
+        auto pos = dbStore_.GetMsPos(newLowest);
+        if (pos && !isPruned(pos->first, blkThreshold) && !isPruned(pos->second, vtxThreshold)) {
+            break;
+        }
+        ++newLowest;
+    }
+
+    if (newLowest == lowest) {
+        return true;
+    }
+
+    // raise the lowest height first so that no reader is directed to the files being removed
+    if (!dbStore_.WriteInfo("lowestHeight", newLowest)) {
+        spdlog::error("[STORE] Failed to update the lowest height to {}", newLowest);
+        return false;
+    }
+
+    if (!dbStore_.DeleteMsPosBetween(lowest, newLowest) || !dbStore_.DeleteVtxPosBetween(lowest, newLowest)) {
+        spdlog::error("[STORE] Failed to delete DB records between height {} and {}", lowest, newLowest);
+        return false;
+    }
+
+    // pending checksum tasks may still refer to the files to be removed
+    while (!checksumTasks_.empty()) {
+        ExecuteChecksumTask();
+    }
+    while (!checksumCalThread_.IsIdle()) {
+        std::this_thread::yield();
+    }
+
+    auto nBlk = file::DeletePrunedFiles(blkThreshold, file::BLK);
+    auto nVtx = file::DeletePrunedFiles(vtxThreshold, file::VTX);
+    spdlog::info("[STORE] Pruned level sets from height {} to {}, deleted {} BLK and {} VTX files", lowest,
+                 newLowest - 1, nBlk, nVtx);
+    return true;
+}
+
+void BlockStore::ConvertLegacyVtxFiles() {
+    pruneThread_.Execute([this]() { ConvertLegacyVtxFrom(dbStore_.GetInfo<uint64_t>("vtxConverted")); });
+}
+
+void BlockStore::ConvertLegacyVtxFrom(uint64_t height) {
+    // level sets may have been pruned in between
+    height   = std::max(height, GetLowestHeight());
+    auto pos = dbStore_.GetMsPos(height);
+    if (!pos) {
+        return;
+    }
+
+    FilePos vtxFile = pos->second;
+    vtxFile.nOffset = 0;
+    if (vtxFile.nEpoch == loadCurrentVtxEpoch() && vtxFile.nName == loadCurrentVtxName()) {
+        dbStore_.WriteInfo("vtxConverted", height);
+        spdlog::info("[STORE] Finished converting VTX files before {}", std::to_string(vtxFile));
+        return;
+    }
+
+    // a level set never spans two files
+    uint64_t end = height + 1;
+    for (auto next = dbStore_.GetMsPos(end); next && vtxFile.SameFileAs(next->second); next = dbStore_.GetMsPos(end)) {
+        ++end;
+    }
+
+    if (!ConvertVtxFile(vtxFile, height, end)) {
+        spdlog::error("[STORE] Failed to convert VTX file {}, leaving the rest in the legacy format",
+                      std::to_string(vtxFile));
+        return;
+    }
+
+    // the files before the level set at this height are never read again by the next conversions
+    dbStore_.WriteInfo("vtxConverted", end);
+
+    // one file per task, so that Stop interrupts the conversion between files
+    pruneThread_.Execute([this, end]() { ConvertLegacyVtxFrom(end); });
+}
+
+bool BlockStore::ConvertVtxFile(const FilePos& vtxFile, uint64_t height1, uint64_t height2) {
+    const std::string path    = file::GetFilePath(file::VTX, vtxFile);
+    const std::string tmpPath = path + ".compact";
+
+    // the file is sealed and only rewritten on this thread, so it is read and converted without holding
+    // vtxFileMutex_, which is taken exclusively only to change the positions in DB and replace the file.
+    // The redemption status may still be updated in place meanwhile, which is carried over under the lock
+    auto size = file::GetFileSize(file::VTX, vtxFile);
+    if (size <= file::checksum_size) {
+        return true;
+    }
+
+    // the file starts with a milestone record in the format it was written at that time
+    auto head = io_->Read({{path, file::checksum_size, 1}});
+    if (!head) {
+        return false;
+    }
+    if ((static_cast<uint8_t>(head->data()[0]) & Vertex::FORMAT_MASK) == Vertex::FORMAT_COMPACT) {
+        return true;
+    }
+
+    auto raw = io_->Read({{path, 0, static_cast<uint32_t>(size)}});
+    if (!raw) {
+        return false;
+    }
+
+    const char* data = raw->data();
+    VStream records(data + file::checksum_size, data + size);
+    VStream converted;
+    converted.reserve(size);
+    std::vector<LevelSetVtxPoses> levelSets;
+    levelSets.reserve(height2 - height1);
+    // the positions of the first byte of each record in the file and in the converted data
+    std::vector<ReadRange> headers;
+    std::vector<size_t> newHeaders;
+
+    try {
+        for (uint64_t height = height1; height < height2; ++height) {
+            auto msPos   = dbStore_.GetMsPos(height);
+            auto offsets = dbStore_.GetLevelSetOffsets(height);
+            if (!msPos || offsets.empty() || std::get<2>(offsets.front()) != 0) {
+                spdlog::error("[STORE] Inconsistent DB records of the level set at height {}", height);
+                return false;
+            }
+
+            LevelSetVtxPoses lvs{height, std::get<0>(offsets.front()), msPos->first, msPos->second, {}, {}, {}};
+            lvs.msVtxPos.nOffset = file::checksum_size + converted.size();
+            lvs.hashes.reserve(offsets.size());
+            lvs.blkOffsets.reserve(offsets.size());
+            lvs.vtxOffsets.reserve(offsets.size());
+
+            for (const auto& [hash, blkOffset, vtxOffset] : offsets) {
+                if (size - records.in_avail() != msPos->second.nOffset + vtxOffset) {
+                    spdlog::error("[STORE] Unexpected offset of block {} in {}", hash.to_substr(), path);
+                    return false;
+                }
+
+                Vertex vtx{};
+                records >> vtx;
+
+                lvs.hashes.push_back(hash);
+                lvs.blkOffsets.push_back(blkOffset);
+                lvs.vtxOffsets.push_back(file::checksum_size + converted.size() - lvs.msVtxPos.nOffset);
+                headers.push_back({path, msPos->second.nOffset + vtxOffset, 1});
+                newHeaders.push_back(converted.size());
+                vtx.Serialize(converted, vtxOffset == 0);
+            }
+
+            levelSets.push_back(std::move(lvs));
+        }
+    } catch (const std::exception& e) {
+        spdlog::error("[STORE] Error occurs deserializing {}: {}", path, e.what());
+        return false;
+    }
+
+    if (records.in_avail()) {
+        spdlog::error("[STORE] {} bytes in {} don't belong to any level set", records.in_avail(), path);
+        return false;
+    }
+
+    VStream output;
+    // the temporary file reaches the disk before DB refers to it, so that a power loss
+    // never leaves RecoverVtxRewrite with a truncated file to rename
+    auto writeTmp = [&]() {
+        output.clear();
+        output.reserve(file::checksum_size + converted.size());
+        output << crc32c((uint8_t*) converted.data(), converted.size());
+        output.write(converted.data(), converted.size());
+
+        // the temporary file may be left by an interrupted conversion before DB is updated
+        std::filesystem::remove(tmpPath);
+        return io_->Write(tmpPath, 0, output.data(), output.size()) && SyncPath(tmpPath);
+    };
+    if (!writeTmp()) {
+        return false;
+    }
+
+    {
+        std::unique_lock<std::shared_mutex> lock(vtxFileMutex_);
+
+        auto redemptions = io_->Read(headers);
+        if (!redemptions) {
+            std::filesystem::remove(tmpPath);
+            return false;
+        }
+        bool redeemed = false;
+        for (size_t i = 0; i < newHeaders.size(); ++i) {
+            auto oldHeader = static_cast<uint8_t>(redemptions->data()[i]);
+            auto& header   = reinterpret_cast<uint8_t&>(converted.data()[newHeaders[i]]);
+            if ((oldHeader & Vertex::REDEMPTION_MASK) != (header & Vertex::REDEMPTION_MASK)) {
+                header   = (header & ~Vertex::REDEMPTION_MASK) | (oldHeader & Vertex::REDEMPTION_MASK);
+                redeemed = true;
+            }
+        }
+        if (redeemed && !writeTmp()) {
+            std::filesystem::remove(tmpPath);
+            return false;
+        }
+
+        if (!dbStore_.RewriteVtxPoses(levelSets, vtxFile)) {
+            std::filesystem::remove(tmpPath);
+            return false;
+        }
+
+        nVtxRewrites_.fetch_add(1);
+        std::error_code ec;
+        std::filesystem::rename(tmpPath, path, ec);
+        if (ec) {
+            spdlog::error("[STORE] Failed to replace {}: {}", path, ec.message());
+            return false;
+        }
+    }
+    // the marker is kept until the rename is on the disk
+    if (!SyncPath(file::GetEpochPath(file::VTX, vtxFile.nEpoch))) {
+        return false;
+    }
+    dbStore_.ClearVtxRewrite();
+
+    spdlog::info("[STORE] Converted VTX file {} holding level sets from height {} to {}, {} -> {} bytes", path,
+                 height1, height2 - 1, size, output.size());
+    return true;
+}
+
+void BlockStore::RecoverVtxRewrite() {
+    auto vtxFile = dbStore_.GetVtxRewrite();
+    if (vtxFile == FilePos{}) {
+        return;
+    }
+
+    // DB already refers to the rewritten file
+    const std::string path    = file::GetFilePath(file::VTX, vtxFile);
+    const std::string tmpPath = path + ".compact";
+    if (CheckFileExist(tmpPath)) {
+        std::error_code ec;
+        std::filesystem::rename(tmpPath, path, ec);
+        if (ec) {
+            spdlog::error("[STORE] Failed to replace {}: {}", path, ec.message());
+            return;
+        }
+        spdlog::info("[STORE] Completed the interrupted rewrite of {}", path);
+    }
+    if (!SyncPath(file::GetEpochPath(file::VTX, vtxFile.nEpoch))) {
         return;
     }
-    FilePos task = *it;
-    checksumCalThread_.Execute([task]() { file::CalculateChecksum(file::VTX, task); });
-    checksumTasks_.erase(it);
+    dbStore_.ClearVtxRewrite();
 }
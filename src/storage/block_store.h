@@ -9,6 +9,7 @@
 #include "dag_manager.h"
 #include "db.h"
 #include "file_utils.h"
+#include "io_backend.h"
 #include "obc.h"
 #include "scheduler.h"
 #include "threadpool.h"
@@ -16,8 +17,28 @@
 #include <atomic>
 #include <memory>
 #include <numeric>
+#include <shared_mutex>
 #include <vector>
 
+/**
+ * A level set serialized in the file layout, with the offsets
+ * to be written to DB once it is appended to the files
+ */
+struct SerializedLevelSet {
+    uint64_t height;
+    uint256 msHash;
+    uint256 chainwork;
+
+    // milestone first, then the other blocks in the lvs
+    VStream blks;
+    VStream vtcs;
+
+    // relative to the position of the milestone
+    std::vector<uint256> hashes;
+    std::vector<uint32_t> blkOffsets;
+    std::vector<uint32_t> vtxOffsets;
+};
+
 struct FileCheckInfo {
     bool valid;
     uint32_t epoch;
@@ -34,17 +55,34 @@ public:
      * DB API for other modules
      */
     VertexPtr GetMilestoneAt(size_t height) const;
+    uint256 GetMilestoneHashAt(size_t height) const;
     VertexPtr GetVertex(const uint256&, bool withBlock = true) const;
     ConstBlockPtr GetBlockCache(const uint256&) const;
     ConstBlockPtr FindBlock(const uint256&) const;
     VStream GetRawLevelSetAt(size_t height, file::FileType = file::FileType::BLK) const;
     VStream GetRawLevelSetBetween(size_t height1, size_t height2, file::FileType = file::FileType::BLK) const;
+
+    /**
+     * Reads the raw level set without blocking the calling thread.
+     * The callback is executed on the given pool, with an empty
+     * stream if the level set can't be read
+     */
+    void GetRawLevelSetAtAsync(size_t height,
+                               ThreadPool& pool,
+                               std::function<void(VStream)> callback,
+                               file::FileType = file::FileType::BLK) const;
     std::vector<ConstBlockPtr> GetLevelSetBlksAt(size_t height) const;
     std::vector<VertexPtr> GetLevelSetVtcsAt(size_t height, bool withBlock = true) const;
 
     size_t GetHeight(const uint256&) const;
     uint64_t GetHeadHeight() const;
     bool SaveHeadHeight(uint64_t height) const;
+
+    /**
+     * Returns the lowest height of which the level set is
+     * still on disk, which is 0 unless the node is pruned
+     */
+    uint64_t GetLowestHeight() const;
     uint256 GetBestChainWork() const;
     bool SaveBestChainWork(const uint256&) const;
     CircularQueue<uint256> GetMinerChainHeads() const;
@@ -71,6 +109,14 @@ public:
     bool StoreLevelSet(const std::vector<VertexWPtr>& lvs);
     bool StoreLevelSet(const std::vector<VertexPtr>& lvs);
 
+    /**
+     * The two stages of StoreLevelSet. Serialization does not touch
+     * the files nor the DB and thus may run ahead on another thread,
+     * while appending has to follow the order of heights
+     */
+    static SerializedLevelSet SerializeLevelSet(const std::vector<VertexPtr>& lvs);
+    bool StoreLevelSet(const SerializedLevelSet& lvs);
+
     /**
      * Removes block cache when flushing
      */
@@ -127,6 +173,25 @@ public:
 
     void ExecuteChecksumTask();
 
+    /**
+     * Sets the number of latest heights to keep on disk,
+     * and 0 disables pruning
+     */
+    void SetPruneWindow(uint64_t window);
+
+    /**
+     * Removes the sealed BLK/VTX files that only hold level sets
+     * below the prune window, together with their DB records
+     */
+    bool Prune();
+
+    /**
+     * Rewrites the sealed VTX files written before the compact vertex
+     * format in the background, one file at a time on the prune thread,
+     * starting from the file where the last conversion stopped
+     */
+    void ConvertLegacyVtxFiles();
+
 private:
     ThreadPool obcThread_;
     std::atomic<bool> obcEnabled_;
@@ -137,9 +202,20 @@ private:
     ConcurrentHashSet<FilePos> checksumTasks_;
     uint64_t lastUpdateTaskTime_;
 
+    ThreadPool pruneThread_;
+    std::atomic_uint64_t pruneWindow_ = 0;
+
     DBStore dbStore_;
     ConcurrentHashMap<uint256, ConstBlockPtr> blockPool_;
 
+    // for reading and appending level sets in BLK/VTX files
+    std::unique_ptr<IOBackend> io_;
+
+    // held exclusively while a VTX file is being rewritten, as the
+    // positions in DB and the file are changed together
+    mutable std::shared_mutex vtxFileMutex_;
+    std::atomic_uint32_t nVtxRewrites_ = 0;
+
     /**
      * params for file storage
      */
@@ -163,6 +239,18 @@ private:
     void CarryOverFileName(std::pair<uint32_t, uint32_t>);
     void AddCurrentSize(std::pair<uint32_t, uint32_t>);
 
+    /**
+     * Returns the ranges of files holding the level sets between
+     * the two heights, or an empty vector if there is none
+     */
+    std::vector<ReadRange> GetLevelSetRanges(size_t height1, size_t height2, file::FileType) const;
+
+    /**
+     * Writes data to the file at pos, reserving the space
+     * for checksum first if the file is new
+     */
+    bool AppendToFile(file::FileType, FilePos& pos, const VStream& data);
+
     VertexPtr ConstructNRFromFile(std::optional<std::pair<FilePos, FilePos>>&&, bool withBlock = true) const;
     FilePos& NextFile(FilePos&) const;
 
@@ -183,6 +271,24 @@ private:
     bool ConstructUTXOAndRegFromLvs(std::vector<VertexPtr>& levelset);
 
     bool ConstructUTXOAndRegFromVtx(const VertexPtr& vtx);
+
+    /**
+     * Converts the VTX file holding the level set at height and schedules
+     * the next file, until reaching the one currently being appended to
+     */
+    void ConvertLegacyVtxFrom(uint64_t height);
+
+    /**
+     * Rewrites the level sets in [height1, height2) of a VTX file in the
+     * compact format. Returns false if the file can't be rewritten
+     */
+    bool ConvertVtxFile(const FilePos& file, uint64_t height1, uint64_t height2);
+
+    /**
+     * Completes the rewrite of a VTX file interrupted after its
+     * positions are written to DB
+     */
+    void RecoverVtxRewrite();
 };
 
 extern std::unique_ptr<BlockStore> STORE;
@@ -4,8 +4,11 @@
 
 #include "db.h"
 #include "circular_queue.h"
+#include "common.h"
 #include "file_utils.h"
 
+#include <algorithm>
+
 using std::optional;
 using std::pair;
 using std::string;
@@ -39,11 +42,44 @@ static const std::vector<std::string> COLUMN_NAMES = {
     "reg", // (key) hash of peer chain head
            // (value) hash of the last registration block on this peer chain
 
-    "info" // Stores necessary info to recover the system,
-           // e.g., lastest ms head in db
+    "info", // Stores necessary info to recover the system,
+            // e.g., lastest ms head in db
+
+    "height" // (key) {big-endian height, block hash}
+             // (value) empty
+             // Note: secondary index of the default column, so that all
+             // blocks at or above a height form a single key range
 };
 
-DBStore::DBStore(string dbPath) : RocksDB(std::move(dbPath), COLUMN_NAMES) {}
+static constexpr size_t HEIGHT_PREFIX_SIZE = sizeof(uint64_t);
+static constexpr size_t HEIGHT_KEY_SIZE    = HEIGHT_PREFIX_SIZE + Hash::SIZE;
+
+// Version of the "height" column layout recorded in the "info" column
+static constexpr uint16_t HEIGHT_INDEX_VERSION = 1;
+
+// Version of the "utxo" column encoding recorded in the "info" column
+static constexpr uint16_t UTXO_FORMAT_VERSION = 1;
+
+static std::string MakeHeightKey(uint64_t height) {
+    std::string key(HEIGHT_PREFIX_SIZE, '\0');
+    WriteBE64(key.data(), height);
+    return key;
+}
+
+static std::string MakeHeightKey(uint64_t height, const uint256& blkHash) {
+    auto key = MakeHeightKey(height);
+    key.append((const char*) blkHash.begin(), Hash::SIZE);
+    return key;
+}
+
+DBStore::DBStore(string dbPath) : RocksDB(std::move(dbPath), COLUMN_NAMES) {
+    if (GetInfo<uint16_t>("heightIndex") < HEIGHT_INDEX_VERSION && !BuildHeightIndex()) {
+        throw std::string("Failed to build the height index");
+    }
+    if (GetInfo<uint16_t>("utxoFormat") < UTXO_FORMAT_VERSION && !CompactUTXOs()) {
+        throw std::string("Failed to re-encode the utxo records");
+    }
+}
 
 bool DBStore::Exists(const uint256& blockHash) const {
     MAKE_KEY_SLICE((uint64_t) GetHeight(blockHash))
@@ -126,7 +162,7 @@ bool DBStore::WriteVtxPos(const uint256& key,
                           const uint64_t& height,
                           const uint32_t& blkOffset,
                           const uint32_t& vtxOffset) const {
-    return WritePosImpl(kDefaultColumnFamilyName, key, VARINT(height), blkOffset, vtxOffset);
+    return WriteVtxPoses({key}, {height}, {blkOffset}, {vtxOffset});
 }
 
 
@@ -152,6 +188,7 @@ bool DBStore::WriteVtxPoses(const std::vector<uint256>& keys,
         Slice valueSlice(valueStream.data(), valueStream.size());
 
         wb.Put(db_->DefaultColumnFamily(), keySlice, valueSlice);
+        wb.Put(handleMap_.at("height"), MakeHeightKey(heights[i], keys[i]), Slice());
 
         keyStream.clear();
         valueStream.clear();
@@ -167,6 +204,74 @@ bool DBStore::WriteMsPos(const uint64_t& key,
     return WritePosImpl("ms", key, msHash, blkPos, vtxPos);
 }
 
+std::vector<tuple<uint256, uint32_t, uint32_t>> DBStore::GetLevelSetOffsets(uint64_t height) const {
+    std::vector<tuple<uint256, uint32_t, uint32_t>> result;
+
+    auto lower = MakeHeightKey(height);
+    auto upper = MakeHeightKey(height + 1);
+    Slice upperSlice(upper);
+
+    ReadOptions options;
+    options.iterate_upper_bound = &upperSlice;
+    Iterator* iter              = db_->NewIterator(options, handleMap_.at("height"));
+    for (iter->Seek(lower); iter->Valid(); iter->Next()) {
+        auto key = iter->key();
+        if (key.size() != HEIGHT_KEY_SIZE) {
+            spdlog::error("Invalid key in the height index, DB is not consistent");
+            result.clear();
+            break;
+        }
+
+        uint256 blkHash;
+        std::copy(key.data() + HEIGHT_PREFIX_SIZE, key.data() + HEIGHT_KEY_SIZE, (char*) blkHash.begin());
+        auto offsets = GetVertexOffsets(blkHash);
+        if (!offsets) {
+            spdlog::error("Missing the record of block {} in the height index", blkHash.to_substr());
+            result.clear();
+            break;
+        }
+        result.emplace_back(blkHash, std::get<1>(*offsets), std::get<2>(*offsets));
+    }
+    delete iter;
+
+    std::sort(result.begin(), result.end(),
+              [](const auto& a, const auto& b) { return std::get<2>(a) < std::get<2>(b); });
+    return result;
+}
+
+bool DBStore::RewriteVtxPoses(const std::vector<LevelSetVtxPoses>& levelSets, const FilePos& file) const {
+    class WriteBatch wb;
+
+    for (const auto& lvs : levelSets) {
+        assert(lvs.hashes.size() == lvs.blkOffsets.size() && lvs.hashes.size() == lvs.vtxOffsets.size());
+
+        for (size_t i = 0; i < lvs.hashes.size(); ++i) {
+            VStream key(lvs.hashes[i]);
+            VStream value;
+            value << VARINT(lvs.height) << lvs.blkOffsets[i] << lvs.vtxOffsets[i];
+            wb.Put(db_->DefaultColumnFamily(), Slice(key.data(), key.size()), Slice(value.data(), value.size()));
+        }
+
+        VStream key(lvs.height);
+        VStream value;
+        value << lvs.msHash << lvs.msBlkPos << lvs.msVtxPos;
+        wb.Put(handleMap_.at("ms"), Slice(key.data(), key.size()), Slice(value.data(), value.size()));
+    }
+
+    VStream marker(file);
+    wb.Put(handleMap_.at("info"), "vtxRewrite", Slice(marker.data(), marker.size()));
+
+    return db_->Write(WriteOptions(), &wb).ok();
+}
+
+FilePos DBStore::GetVtxRewrite() const {
+    return GetInfo<FilePos>("vtxRewrite");
+}
+
+bool DBStore::ClearVtxRewrite() const {
+    return RocksDB::Delete("info", "vtxRewrite");
+}
+
 
 bool DBStore::ExistsUTXO(const uint256& key) const {
     MAKE_KEY_SLICE(key)
@@ -225,33 +330,65 @@ bool DBStore::RemoveUTXO(const uint256& key) const {
 }
 
 bool DBStore::DeleteVtxPos(const uint256& h) const {
-    return db_->Delete(WriteOptions(), db_->DefaultColumnFamily(), VStream(h).str()).ok();
+    class WriteBatch wb;
+    auto height = GetHeight(h);
+    if (height != UINT_FAST64_MAX) {
+        wb.Delete(handleMap_.at("height"), MakeHeightKey(height, h));
+    }
+    wb.Delete(db_->DefaultColumnFamily(), VStream(h).str());
+
+    return db_->Write(WriteOptions(), &wb).ok();
 }
 
 bool DBStore::DeleteBatchVtxPos(uint64_t heightThreshold) {
-    std::vector<uint256> delBlocks;
-    Iterator* iter = db_->NewIterator(ReadOptions(), handleMap_.at("default"));
-    for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
-        uint64_t height = 0;
-        try {
-            VStream value{iter->value().data(), iter->value().data() + iter->value().size()};
-            value >> VARINT(height);
-            if (height >= heightThreshold) {
-                if (!db_->Delete(WriteOptions(), db_->DefaultColumnFamily(), iter->key()).ok()) {
-                    spdlog::error("Failed to delete block, DB is not consistent");
-                    return false;
-                }
-            }
-        } catch (std::exception& e) {
-            spdlog::error("Exception happened when deleting batch blocks, {}", e.what());
+    return DeleteVtxPosBetween(heightThreshold, UINT64_MAX);
+}
+
+bool DBStore::DeleteVtxPosBetween(uint64_t from, uint64_t to) {
+    auto heightHandle = handleMap_.at("height");
+    auto lower        = MakeHeightKey(from);
+    auto upper        = MakeHeightKey(to);
+    Slice upperSlice(upper);
+
+    class WriteBatch wb;
+    ReadOptions options;
+    options.iterate_upper_bound = &upperSlice;
+    Iterator* iter              = db_->NewIterator(options, heightHandle);
+    for (iter->Seek(lower); iter->Valid(); iter->Next()) {
+        auto key = iter->key();
+        if (key.size() != HEIGHT_KEY_SIZE) {
+            spdlog::error("Invalid key in the height index, DB is not consistent");
+            delete iter;
             return false;
         }
+        wb.Delete(db_->DefaultColumnFamily(), Slice(key.data() + HEIGHT_PREFIX_SIZE, Hash::SIZE));
     }
-    assert(iter->status().ok());
+    bool status = iter->status().ok();
     delete iter;
+
+    if (!status) {
+        spdlog::error("Failed to scan the height index between {} and {}", from, to);
+        return false;
+    }
+
+    // All keys of blocks with height in [from, to) form the range [lower, upper)
+    wb.DeleteRange(heightHandle, lower, upper);
+    if (!db_->Write(WriteOptions(), &wb).ok()) {
+        spdlog::error("Failed to delete blocks, DB is not consistent");
+        return false;
+    }
     return true;
 }
 
+bool DBStore::DeleteMsPosBetween(uint64_t from, uint64_t to) const {
+    class WriteBatch wb;
+    for (uint64_t height = from; height < to; ++height) {
+        MAKE_KEY_SLICE(height)
+        wb.Delete(handleMap_.at("ms"), keySlice);
+    }
+    return db_->Write(WriteOptions(), &wb).ok();
+}
+
 bool DBStore::DeleteMsPos(const uint256& h) const {
     bool status = DeleteMsPos(GetHeight(h));
     if (status && IsMilestone(h)) {
@@ -327,6 +464,7 @@ template uint256 DBStore::GetInfo(const std::string&) const;
 template uint64_t DBStore::GetInfo(const std::string&) const;
 template uint32_t DBStore::GetInfo(const std::string&) const;
 template uint16_t DBStore::GetInfo(const std::string&) const;
+template FilePos DBStore::GetInfo(const std::string&) const;
 template CircularQueue<uint256> DBStore::GetInfo(const std::string&) const;
 
 uint256 DBStore::GetMsHashAt(const uint64_t& height) const {
@@ -424,6 +562,108 @@ template bool DBStore::WritePosImpl(
 template bool DBStore::WritePosImpl(
     const string& column, const uint64_t&, const uint256&, const FilePos&, const FilePos&) const;
 
+bool DBStore::BuildHeightIndex() {
+    static const size_t batchSize = 10000;
+
+    spdlog::info("Building the height index of block records...");
+    class WriteBatch wb;
+    size_t nRecords = 0;
+    uint256 blkHash;
+
+    Iterator* iter = db_->NewIterator(ReadOptions(), db_->DefaultColumnFamily());
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+        try {
+            VStream key{iter->key().data(), iter->key().data() + iter->key().size()};
+            key >> blkHash;
+            VStream value{iter->value().data(), iter->value().data() + iter->value().size()};
+            uint64_t height;
+            value >> VARINT(height);
+            wb.Put(handleMap_.at("height"), MakeHeightKey(height, blkHash), Slice());
+        } catch (std::exception& e) {
+            spdlog::error("Exception happened when building the height index, {}", e.what());
+            delete iter;
+            return false;
+        }
+
+        if (++nRecords % batchSize == 0) {
+            if (!db_->Write(WriteOptions(), &wb).ok()) {
+                delete iter;
+                return false;
+            }
+            wb.Clear();
+        }
+    }
+    assert(iter->status().ok());
+    delete iter;
+
+    if (!db_->Write(WriteOptions(), &wb).ok()) {
+        return false;
+    }
+    spdlog::info("Indexed {} block records by height", nRecords);
+    return WriteInfo("heightIndex", HEIGHT_INDEX_VERSION);
+}
+
+bool DBStore::CompactUTXOs() {
+    static const size_t batchSize = 10000;
+
+    // the key of the last record converted is written with every batch, so that an interrupted
+    // conversion resumes after it rather than decoding the converted records as legacy ones
+    auto last = RocksDB::Get("info", std::string("utxoCompacted"));
+
+    class WriteBatch wb;
+    size_t nRecords = 0;
+    auto commit     = [&](const Slice& lastKey) {
+        wb.Put(handleMap_.at("info"), "utxoCompacted", lastKey);
+        bool written = db_->Write(WriteOptions(), &wb).ok();
+        wb.Clear();
+        return written;
+    };
+
+    std::unique_ptr<Iterator> iter(db_->NewIterator(ReadOptions(), handleMap_.at("utxo")));
+    if (last.empty()) {
+        iter->SeekToFirst();
+    } else {
+        iter->Seek(last);
+        if (iter->Valid() && iter->key().compare(last) == 0) {
+            iter->Next();
+        }
+    }
+
+    for (; iter->Valid(); iter->Next()) {
+        try {
+            // the legacy encoding is a serialized TxOutput
+            VStream value{iter->value().data(), iter->value().data() + iter->value().size()};
+            TxOutput output;
+            value >> output;
+
+            VStream compact(UTXO(output, 0, 0));
+            wb.Put(handleMap_.at("utxo"), iter->key(), Slice(compact.data(), compact.size()));
+        } catch (std::exception& e) {
+            spdlog::error("Exception happened when compacting utxo, {}", e.what());
+            return false;
+        }
+
+        if (++nRecords % batchSize == 0 && !commit(iter->key())) {
+            return false;
+        }
+    }
+    if (!iter->status().ok()) {
+        return false;
+    }
+
+    VStream version(UTXO_FORMAT_VERSION);
+    wb.Put(handleMap_.at("info"), "utxoFormat", Slice(version.data(), version.size()));
+    wb.Delete(handleMap_.at("info"), "utxoCompacted");
+    if (!db_->Write(WriteOptions(), &wb).ok()) {
+        return false;
+    }
+
+    if (nRecords > 0) {
+        spdlog::info("Re-encoded {} utxo records compactly", nRecords);
+    }
+    return true;
+}
+
 bool DBStore::ClearColumn(std::string columnName) {
     return DeleteColumn(columnName) && CreateColumn(columnName);
 }
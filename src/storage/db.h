@@ -5,16 +5,34 @@
 #ifndef EPIC_DB_H
 #define EPIC_DB_H
 
+#include "file_utils.h"
 #include "rocksdb.h"
 #include "vertex.h"
 
 #include <string>
 #include <vector>
 
-struct FilePos;
+/**
+ * Positions of a level set in its VTX file, of which the
+ * offsets are relative to the position of the milestone
+ */
+struct LevelSetVtxPoses {
+    uint64_t height;
+    uint256 msHash;
+    FilePos msBlkPos;
+    FilePos msVtxPos;
+
+    std::vector<uint256> hashes;
+    std::vector<uint32_t> blkOffsets;
+    std::vector<uint32_t> vtxOffsets;
+};
 
 class DBStore : public RocksDB {
 public:
+    /**
+     * Opens the database and migrates the indices and encodings written by
+     * older versions; throws a std::string if a migration fails
+     */
     explicit DBStore(std::string dbPath);
 
     bool Exists(const uint256&) const;
@@ -28,6 +46,12 @@ public:
     std::optional<std::pair<FilePos, FilePos>> GetMsPos(const uint64_t& height) const;
     std::optional<FilePos> GetMsBlockPos(const uint64_t& height) const;
 
+    /**
+     * Gets the hash of the milestone at height without touching
+     * the block files. Returns a null hash if there is none
+     */
+    uint256 GetMsHashAt(const uint64_t& height) const;
+
     /**
      * Gets the milesonte file posisionts at height of blk
      * Returns {blk FilePos, vtx FilePos}
@@ -56,8 +80,40 @@ public:
                        const std::vector<uint32_t>&,
                        const std::vector<uint32_t>&) const;
 
+    /**
+     * Gets the offsets of all blocks at height as {hash, blk offset, vtx offset},
+     * ordered by the vtx offset, i.e., in the order they are stored in VTX file
+     */
+    std::vector<std::tuple<uint256, uint32_t, uint32_t>> GetLevelSetOffsets(uint64_t height) const;
+
+    /**
+     * Overwrites the positions of the level sets in a rewritten VTX file
+     * in one batch, and marks the file in "vtxRewrite" of the info column
+     * until ClearVtxRewrite, so that an interrupted rewrite can be resumed
+     */
+    bool RewriteVtxPoses(const std::vector<LevelSetVtxPoses>&, const FilePos& file) const;
+    FilePos GetVtxRewrite() const;
+    bool ClearVtxRewrite() const;
+
     bool DeleteVtxPos(const uint256&) const;
+
+    /**
+     * Deletes the position records of all blocks whose height
+     * is no less than the threshold by a range scan on the
+     * height index
+     */
     bool DeleteBatchVtxPos(uint64_t heightThreshold);
+
+    /**
+     * Deletes the position records of all blocks with
+     * height in [from, to)
+     */
+    bool DeleteVtxPosBetween(uint64_t from, uint64_t to);
+
+    /**
+     * Deletes the milestone records with height in [from, to)
+     */
+    bool DeleteMsPosBetween(uint64_t from, uint64_t to) const;
     bool DeleteMsPos(const uint256&) const;
     bool DeleteMsPos(uint64_t height) const;
 
@@ -80,7 +136,18 @@ public:
     bool ClearColumn(std::string columnName);
 
 private:
-    uint256 GetMsHashAt(const uint64_t& height) const;
+    /**
+     * Builds the "height" column from the default column
+     * for databases created before the height index existed
+     */
+    bool BuildHeightIndex();
+
+    /**
+     * Re-encodes the "utxo" column from serialized outputs to compact
+     * UTXOs for databases created before the compact encoding
+     */
+    bool CompactUTXOs();
+
     std::optional<std::tuple<uint64_t, uint32_t, uint32_t>> GetVertexOffsets(const uint256&) const;
 
     bool WriteRegSet(const std::unordered_set<std::pair<uint256, uint256>>&) const;
@@ -0,0 +1,86 @@
+// Copyright (c) 2019 EPI-ONE Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "lvs_cache.h"
+
+LevelSetCache::LevelSetCache(size_t capacity) : capacity_(capacity) {}
+
+LevelSetCache::Payload LevelSetCache::Get(const uint256& msHash) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(msHash);
+    if (it == entries_.end()) {
+        return nullptr;
+    }
+
+    lru_.splice(lru_.begin(), lru_, it->second.lruPos);
+    return it->second.payload;
+}
+
+void LevelSetCache::Put(const uint256& msHash, uint64_t height, VStream payload) {
+    const size_t bytes = payload.size();
+    auto shared        = std::make_shared<const VStream>(std::move(payload));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    readingAhead_.erase(msHash);
+    if (bytes > capacity_ || entries_.count(msHash)) {
+        return;
+    }
+
+    while (size_ + bytes > capacity_) {
+        Evict(entries_.find(lru_.back()));
+    }
+
+    lru_.push_front(msHash);
+    entries_.emplace(msHash, Entry{height, std::move(shared), lru_.begin()});
+    heights_.insert(height);
+    size_ += bytes;
+}
+
+bool LevelSetCache::Contains(const uint256& msHash) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.count(msHash);
+}
+
+bool LevelSetCache::ContainsHeight(uint64_t height) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return heights_.count(height);
+}
+
+bool LevelSetCache::MarkReadAhead(const uint256& msHash) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (entries_.count(msHash)) {
+        return false;
+    }
+    return readingAhead_.insert(msHash).second;
+}
+
+void LevelSetCache::UnmarkReadAhead(const uint256& msHash) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    readingAhead_.erase(msHash);
+}
+
+void LevelSetCache::Clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+    heights_.clear();
+    lru_.clear();
+    size_ = 0;
+}
+
+size_t LevelSetCache::Count() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+size_t LevelSetCache::Size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return size_;
+}
+
+void LevelSetCache::Evict(std::unordered_map<uint256, Entry>::iterator it) {
+    size_ -= it->second.payload->size();
+    heights_.erase(heights_.find(it->second.height));
+    lru_.erase(it->second.lruPos);
+    entries_.erase(it);
+}
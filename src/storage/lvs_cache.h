@@ -0,0 +1,84 @@
+// Copyright (c) 2019 EPI-ONE Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef EPIC_LVS_CACHE_H
+#define EPIC_LVS_CACHE_H
+
+#include "stream.h"
+#include "big_uint.h"
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+
+/**
+ * A thread-safe LRU cache of raw level sets ready to be sent in
+ * bundles, keyed by milestone hash and bounded by the total bytes
+ * of the payloads
+ */
+class LevelSetCache {
+public:
+    using Payload = std::shared_ptr<const VStream>;
+
+    explicit LevelSetCache(size_t capacity);
+
+    /**
+     * Returns the payload and marks it as the most recently used,
+     * or nullptr if it's not cached
+     */
+    Payload Get(const uint256& msHash);
+
+    /**
+     * Inserts the payload, evicting the least recently used ones
+     * beyond the capacity. A payload larger than the capacity is ignored
+     */
+    void Put(const uint256& msHash, uint64_t height, VStream payload);
+
+    bool Contains(const uint256& msHash) const;
+
+    /**
+     * Returns true if the level set at the height is cached,
+     * used for detecting sequential requests
+     */
+    bool ContainsHeight(uint64_t height) const;
+
+    /**
+     * Marks the milestone as being read ahead.
+     * Returns false if it's either cached or already marked
+     */
+    bool MarkReadAhead(const uint256& msHash);
+    void UnmarkReadAhead(const uint256& msHash);
+
+    void Clear();
+
+    // Number of payloads cached
+    size_t Count() const;
+
+    // Total bytes of the payloads cached
+    size_t Size() const;
+
+private:
+    struct Entry {
+        uint64_t height;
+        Payload payload;
+        std::list<uint256>::iterator lruPos;
+    };
+
+    const size_t capacity_;
+    size_t size_ = 0;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<uint256, Entry> entries_;
+    std::unordered_multiset<uint64_t> heights_;
+    std::unordered_set<uint256> readingAhead_;
+
+    // the most recently used at front
+    std::list<uint256> lru_;
+
+    void Evict(std::unordered_map<uint256, Entry>::iterator);
+};
+
+#endif // EPIC_LVS_CACHE_H
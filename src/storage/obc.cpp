@@ -3,6 +3,8 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "obc.h"
+#include "log.h"
+
 #include <memory>
 #include <queue>
 
@@ -72,17 +74,17 @@ void OrphanBlocksContainer::AddBlock(ConstBlockPtr&& block, uint8_t missing_mask
     obcBlockSize_++;
 
     if (missing_mask & M_MISSING) {
-        spdlog::trace("[OBC] Block {} is missing milestone link {}", bHash.to_substr(), msHash.to_substr());
+        LOG_TRACE("[OBC] Block {} is missing milestone link {}", bHash.to_substr(), msHash.to_substr());
         common_insert(msHash);
     }
 
     if (missing_mask & T_MISSING) {
-        spdlog::trace("[OBC] Block {} is missing tip link {}", bHash.to_substr(), tipHash.to_substr());
+        LOG_TRACE("[OBC] Block {} is missing tip link {}", bHash.to_substr(), tipHash.to_substr());
         common_insert(tipHash);
     }
 
     if (missing_mask & P_MISSING) {
-        spdlog::trace("[OBC] Block {} is missing prev link {}", bHash.to_substr(), prevHash.to_substr());
+        LOG_TRACE("[OBC] Block {} is missing prev link {}", bHash.to_substr(), prevHash.to_substr());
         common_insert(prevHash);
     }
 
@@ -142,7 +144,7 @@ size_t OrphanBlocksContainer::Prune(uint32_t secs) {
         DeleteBlockTree(blk_hash);
     }
 
-    spdlog::debug("Pruned {} block(s) and {} void block(s) in obc", pruned_block.size(), old_dependency.size());
+    LOG_DEBUG("Pruned {} block(s) and {} void block(s) in obc", pruned_block.size(), old_dependency.size());
 
     return pruned_block.size() + old_dependency.size();
 }
@@ -0,0 +1,430 @@
+// Copyright (c) 2019 EPI-ONE Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "block_store.h"
+#include "cxxopts.h"
+#include "dag_manager.h"
+#include "key.h"
+#include "mempool.h"
+#include "miner.h"
+#include "peer_manager.h"
+#include "wallet.h"
+
+#include <array>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+
+/**
+ * Drives an in-process node with signed transactions from its wallet at a fixed
+ * rate and measures the latency of every transaction through the stages of the
+ * node: submission to the memory pool, arrival of the block containing it,
+ * confirmation of that block by a main chain milestone, and the storage flush.
+ *
+ * Without --connect the node mines its own blocks. With --connect the
+ * transactions are also relayed to the given peers, and the stages are observed
+ * as the blocks of the network arrive at the local node.
+ */
+
+struct LoadOptions {
+    std::string root     = "loadgen/";
+    std::string type     = "Unittest";
+    std::string connect  = "";
+    std::string out      = "";
+    double rate          = 10;
+    uint32_t duration    = 60;
+    uint32_t warmup      = 600;
+    uint32_t drain       = 120;
+    uint64_t seed        = 1;
+    uint32_t threads     = 1;
+    uint32_t fanout      = 64;
+    bool mine            = true;
+    bool clean           = false;
+};
+
+int ParseArg(int argc, char** argv, LoadOptions& opts) {
+    cxxopts::Options options("loadGenerator", "synthetic load generator and throughput harness of epic");
+
+    // clang-format off
+    options.add_options()
+    ("h,help", "print this message", cxxopts::value<bool>())
+    ("r,root", "root path of the temporary data, which has to be empty or absent unless --clean", cxxopts::value<std::string>(opts.root))
+    ("clean", "delete the data in the root path before running", cxxopts::value<bool>(opts.clean))
+    ("t,type", "network type, one of Mainnet, Diamond (Testnet), Spade (Testnet), and Unittest", cxxopts::value<std::string>(opts.type))
+    ("c,connect", "address of a peer to feed the transactions to, example: 127.0.0.1:7877", cxxopts::value<std::string>(opts.connect))
+    ("rate", "transactions sent per second", cxxopts::value<double>(opts.rate))
+    ("duration", "seconds to send transactions for", cxxopts::value<uint32_t>(opts.duration))
+    ("warmup", "max seconds to wait for the wallet to be funded", cxxopts::value<uint32_t>(opts.warmup))
+    ("drain", "max seconds to wait for the sent transactions to be stored", cxxopts::value<uint32_t>(opts.drain))
+    ("seed", "seed of the transaction schedule", cxxopts::value<uint64_t>(opts.seed))
+    ("threads", "number of solver threads of the local miner", cxxopts::value<uint32_t>(opts.threads))
+    ("fanout", "number of outputs the funds are split into to sustain the rate", cxxopts::value<uint32_t>(opts.fanout))
+    ("mine", "mine blocks locally, on by default unless connected", cxxopts::value<bool>())
+    ("o,out", "path of the json report", cxxopts::value<std::string>(opts.out));
+    // clang-format on
+
+    try {
+        auto parsed_options = options.parse(argc, argv);
+        if (parsed_options["help"].as<bool>()) {
+            std::cout << options.help() << std::endl;
+            return -1;
+        }
+        opts.mine = parsed_options.count("mine") ? parsed_options["mine"].as<bool>() : opts.connect.empty();
+        if (opts.rate <= 0 || opts.fanout == 0) {
+            throw cxxopts::OptionException("rate and fanout must be positive");
+        }
+    } catch (const cxxopts::OptionException& e) {
+        std::cerr << "error parsing options: " << e.what() << std::endl;
+        std::cout << options.help() << std::endl;
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Records the time at which each transaction reaches each stage
+ */
+class LatencyTracker {
+public:
+    enum Stage { SUBMITTED = 0, INCLUDED, CONFIRMED, STORED, NUM_STAGES };
+
+    using Clock     = std::chrono::steady_clock;
+    using TimePoint = Clock::time_point;
+
+    void Submit(const uint256& txHash) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        records_[txHash][SUBMITTED] = Clock::now();
+    }
+
+    /**
+     * marks the transactions of the blocks as having reached the stage,
+     * unless they have already done so
+     */
+    void Reach(Stage stage, const std::vector<ConstBlockPtr>& blocks) {
+        auto now = Clock::now();
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& block : blocks) {
+            for (const auto& tx : block->GetTransactions()) {
+                auto it = records_.find(tx->GetHash());
+                if (it != records_.end() && it->second[stage] == TimePoint{}) {
+                    it->second[stage] = now;
+                    if (stage == STORED) {
+                        nStored_++;
+                        lastStored_ = now;
+                    }
+                }
+            }
+        }
+    }
+
+    size_t GetStoredCount() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return nStored_;
+    }
+
+    /**
+     * milliseconds spent from the submission to the stage,
+     * for the transactions that have reached it
+     */
+    std::vector<double> GetLatencies(Stage stage) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<double> result;
+        for (const auto& [hash, times] : records_) {
+            if (times[stage] != TimePoint{}) {
+                result.push_back(std::chrono::duration<double, std::milli>(times[stage] - times[SUBMITTED]).count());
+            }
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+    size_t GetSubmittedCount() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return records_.size();
+    }
+
+    TimePoint GetLastStored() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return lastStored_;
+    }
+
+private:
+    mutable std::mutex mutex_;
+    std::unordered_map<uint256, std::array<TimePoint, NUM_STAGES>> records_;
+    size_t nStored_ = 0;
+    TimePoint lastStored_;
+};
+
+static double Percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    size_t rank = std::ceil(p * sorted.size());
+    return sorted[std::max<size_t>(rank, 1) - 1];
+}
+
+static bool Setup(const LoadOptions& opts, LatencyTracker& tracker) {
+    const std::map<std::string, ParamsType> parseType = {{"Mainnet", ParamsType::MAINNET},
+                                                         {"Spade", ParamsType::SPADE},
+                                                         {"Diamond", ParamsType::DIAMOND},
+                                                         {"Unittest", ParamsType::UNITTEST}};
+    try {
+        SelectParams(parseType.at(opts.type));
+    } catch (const std::out_of_range& err) {
+        std::cerr << "wrong format of network type" << std::endl;
+        return false;
+    }
+
+    // every run starts from the genesis so that runs are comparable
+    std::error_code ec;
+    if (std::filesystem::exists(opts.root, ec) && !std::filesystem::is_empty(opts.root, ec)) {
+        if (!opts.clean) {
+            std::cerr << "the root path " << opts.root << " is not empty, pass --clean to delete it" << std::endl;
+            return false;
+        }
+        DeleteDir(opts.root);
+    }
+    file::SetDataDirPrefix(opts.root);
+
+    CONFIG = std::make_unique<Config>();
+    CONFIG->SetAmISeed(opts.connect.empty());
+
+    STORE = std::make_unique<BlockStore>(opts.root + "/db/");
+    std::vector<VertexPtr> genesisLvs = {GENESIS_VERTEX};
+    STORE->StoreLevelSet(genesisLvs);
+
+    DAG = std::make_unique<DAGManager>();
+    if (!DAG->Init()) {
+        std::cerr << "failed to initialize the dag" << std::endl;
+        return false;
+    }
+    MEMPOOL = std::make_unique<MemPool>();
+    MINER   = std::make_unique<Miner>(opts.threads);
+
+    WALLET = std::make_unique<Wallet>(opts.root + "/wallet/", 60, 0);
+    WALLET->GenerateMaster();
+    WALLET->SetPassphrase("");
+    WALLET->Start();
+
+    DAG->RegisterOnBlockAddedCallback([&](const ConstBlockPtr& block) {
+        tracker.Reach(LatencyTracker::INCLUDED, {block});
+    });
+    DAG->RegisterOnLvsConfirmedCallback([&](auto vertices, auto utxos, auto stxos) {
+        std::vector<ConstBlockPtr> blocks;
+        blocks.reserve(vertices.size());
+        for (const auto& vtx : vertices) {
+            blocks.push_back(vtx->cblock);
+        }
+        tracker.Reach(LatencyTracker::STORED, blocks);
+        WALLET->OnLvsConfirmed(std::move(vertices), std::move(utxos), std::move(stxos));
+    });
+
+    if (!opts.connect.empty()) {
+        PEERMAN = std::make_unique<PeerManager>();
+        PEERMAN->Start();
+        if (!PEERMAN->ConnectTo(opts.connect)) {
+            std::cerr << "failed to connect to " << opts.connect << std::endl;
+            return false;
+        }
+    }
+
+    if (opts.mine) {
+        MINER->Run();
+    }
+
+    // the miner registers its own listener on start, so chain updates are forwarded to it
+    DAG->RegisterOnChainUpdatedCallback([&](ConstBlockPtr msBlock, bool isMainchain) {
+        if (MINER) {
+            MINER->OnChainUpdate(msBlock, isMainchain);
+        }
+        if (!isMainchain) {
+            return;
+        }
+
+        auto ms = DAG->GetMsVertex(msBlock->GetHash());
+        if (!ms || !ms->snapshot) {
+            return;
+        }
+        std::vector<ConstBlockPtr> blocks;
+        for (const auto& wvtx : ms->snapshot->GetLevelSet()) {
+            if (auto vtx = wvtx.lock()) {
+                blocks.push_back(vtx->cblock);
+            }
+        }
+        tracker.Reach(LatencyTracker::CONFIRMED, blocks);
+    });
+
+    return true;
+}
+
+/**
+ * Stops whatever Setup has started, also after it fails halfway
+ */
+static void ShutDown() {
+    if (MINER) {
+        MINER->Stop();
+    }
+    if (PEERMAN) {
+        PEERMAN->Stop();
+    }
+    if (WALLET) {
+        WALLET->Stop();
+    }
+    if (DAG) {
+        DAG->Stop();
+    }
+    if (STORE) {
+        STORE->Stop();
+    }
+
+    WALLET.reset();
+    PEERMAN.reset();
+    MINER.reset();
+    DAG.reset();
+    STORE.reset();
+    MEMPOOL.reset();
+    CONFIG.reset();
+}
+
+/**
+ * Waits until the first redemption funds the wallet
+ */
+static bool Fund(const LoadOptions& opts) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(opts.warmup);
+    WALLET->CreateFirstRegistration(WALLET->CreateNewKey(true));
+
+    const Coin minFunds = MIN_FEE + opts.fanout;
+    while (WALLET->GetBalance() < minFunds) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        if (!WALLET->HasPendingRedemption() && WALLET->CanRedeem(minFunds)) {
+            WALLET->CreateRedemption(WALLET->CreateNewKey(true));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    LoadOptions opts;
+    if (ParseArg(argc, argv, opts)) {
+        return -1;
+    }
+
+    ECC_Start();
+    ECCVerifyHandle handle;
+    spdlog::set_level(spdlog::level::warn);
+
+    LatencyTracker tracker;
+    if (!Setup(opts, tracker)) {
+        ShutDown();
+        ECC_Stop();
+        return -1;
+    }
+
+    std::cout << "Waiting for the wallet to be funded..." << std::endl;
+    if (!Fund(opts)) {
+        std::cerr << "the wallet is not funded in " << opts.warmup << " seconds" << std::endl;
+        ShutDown();
+        ECC_Stop();
+        return -1;
+    }
+
+    // the schedule of amounts and receivers is fully determined by the seed
+    std::mt19937_64 rng(opts.seed);
+    std::vector<CKeyID> addresses;
+    for (uint32_t i = 0; i < opts.fanout; ++i) {
+        addresses.push_back(WALLET->CreateNewKey(true));
+    }
+
+    std::cout << "Sending " << opts.rate << " tx/s for " << opts.duration << "s..." << std::endl;
+    const auto interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(1 / opts.rate));
+    const auto start = std::chrono::steady_clock::now();
+    const auto end   = start + std::chrono::seconds(opts.duration);
+    size_t nStarved  = 0;
+
+    for (auto next = start; next < end; next += interval) {
+        std::this_thread::sleep_until(next);
+
+        const Coin minInputs = MIN_FEE + 2;
+        auto balance         = WALLET->GetBalance();
+        ConstTxPtr tx;
+        if (balance >= MIN_FEE + opts.fanout && WALLET->GetUnspent().size() < opts.fanout / 2) {
+            // split the funds so that enough outputs are spendable while the others are pending
+            Coin each = (balance - MIN_FEE).GetValue() / opts.fanout;
+            std::vector<std::pair<Coin, CKeyID>> outputs;
+            for (uint32_t i = 0; i < opts.fanout; ++i) {
+                outputs.emplace_back(each, addresses[rng() % addresses.size()]);
+            }
+            tx = WALLET->CreateTxAndSend(outputs);
+        } else if (balance >= minInputs) {
+            Coin coin = rng() % ((balance - minInputs).GetValue() + 1) + 1;
+            tx        = WALLET->CreateTxAndSend({{coin, addresses[rng() % addresses.size()]}}, MIN_FEE, 1);
+        } else if (!WALLET->HasPendingRedemption() && WALLET->CanRedeem(minInputs)) {
+            WALLET->CreateRedemption(addresses[rng() % addresses.size()]);
+        }
+
+        if (!tx) {
+            nStarved++;
+            continue;
+        }
+        tracker.Submit(tx->GetHash());
+        if (PEERMAN) {
+            PEERMAN->RelayTransaction(tx, nullptr);
+        }
+    }
+    const auto sendTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "Waiting for the transactions to be stored..." << std::endl;
+    auto drainDeadline = std::chrono::steady_clock::now() + std::chrono::seconds(opts.drain);
+    while (tracker.GetStoredCount() < tracker.GetSubmittedCount() && std::chrono::steady_clock::now() < drainDeadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+
+    const char* stageNames[] = {"", "included", "confirmed", "stored"};
+    size_t nSubmitted        = tracker.GetSubmittedCount();
+    size_t nStored           = tracker.GetStoredCount();
+    double storeTime         = std::chrono::duration<double>(tracker.GetLastStored() - start).count();
+    double storedTps         = nStored && storeTime > 0 ? nStored / storeTime : 0;
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "submitted " << nSubmitted << " txs in " << sendTime << "s (" << nSubmitted / sendTime
+              << " tx/s), starved " << nStarved << " times" << std::endl;
+    std::cout << "stored " << nStored << " txs at " << storedTps << " tx/s" << std::endl;
+
+    std::ostringstream json;
+    json << std::fixed << std::setprecision(3);
+    json << "{\"seed\": " << opts.seed << ", \"rate\": " << opts.rate << ", \"duration\": " << opts.duration
+         << ", \"submitted\": " << nSubmitted << ", \"starved\": " << nStarved << ", \"stored\": " << nStored
+         << ", \"submitted_tps\": " << nSubmitted / sendTime << ", \"stored_tps\": " << storedTps
+         << ", \"latency_ms\": {";
+
+    for (int stage = LatencyTracker::INCLUDED; stage < LatencyTracker::NUM_STAGES; ++stage) {
+        auto latencies = tracker.GetLatencies(static_cast<LatencyTracker::Stage>(stage));
+        double p50 = Percentile(latencies, 0.5), p90 = Percentile(latencies, 0.9), p99 = Percentile(latencies, 0.99),
+               max = latencies.empty() ? 0 : latencies.back();
+
+        std::cout << std::setw(10) << stageNames[stage] << ": " << latencies.size() << " txs, p50 " << p50
+                  << "ms, p90 " << p90 << "ms, p99 " << p99 << "ms, max " << max << "ms" << std::endl;
+        json << (stage == LatencyTracker::INCLUDED ? "" : ", ") << "\"" << stageNames[stage]
+             << "\": {\"count\": " << latencies.size() << ", \"p50\": " << p50 << ", \"p90\": " << p90
+             << ", \"p99\": " << p99 << ", \"max\": " << max << "}";
+    }
+    json << "}}";
+
+    if (!opts.out.empty()) {
+        std::ofstream file(opts.out, std::ios::out | std::ios::trunc);
+        file << json.str() << std::endl;
+    }
+
+    ShutDown();
+    ECC_Stop();
+    return 0;
+}
@@ -21,52 +21,41 @@ public:
 };
 
 // Template base class for unsigned big integers
+//
+// Limbs are 64 bits wide and stored from the least significant one, so that
+// the memory layout on little-endian machines is the same as the one of
+// 32-bit limbs. Carries and products go through unsigned __int128, which
+// compiles down to add-with-carry and (MULX when BMI2 is enabled) wide
+// multiplications.
 template <unsigned int BITS>
 class base_uint {
 protected:
-    static constexpr int WIDTH = BITS / 32;
-    uint32_t pn[WIDTH];
+    static_assert(BITS / 64 > 0 && BITS % 64 == 0, "Template parameter BITS must be a positive multiple of 64.");
 
-public:
-    base_uint() {
-        static_assert(BITS / 32 > 0 && BITS % 32 == 0, "Template parameter BITS must be a positive multiple of 32.");
-
-        for (int i = 0; i < WIDTH; i++)
-            pn[i] = 0;
-    }
+    static constexpr int WIDTH = BITS / 64;
+    uint64_t pn[WIDTH];
 
-    base_uint(const base_uint& b) {
-        static_assert(BITS / 32 > 0 && BITS % 32 == 0, "Template parameter BITS must be a positive multiple of 32.");
+    using uint128_t = unsigned __int128;
 
-        for (int i = 0; i < WIDTH; i++)
-            pn[i] = b.pn[i];
-    }
+public:
+    constexpr base_uint() : pn{} {}
 
-    base_uint& operator=(const base_uint& b) {
-        for (int i = 0; i < WIDTH; i++)
-            pn[i] = b.pn[i];
-        return *this;
-    }
+    constexpr base_uint(const base_uint& b) = default;
 
-    base_uint(uint64_t b) {
-        static_assert(BITS / 32 > 0 && BITS % 32 == 0, "Template parameter BITS must be a positive multiple of 32.");
+    constexpr base_uint& operator=(const base_uint& b) = default;
 
-        pn[0] = (unsigned int) b;
-        pn[1] = (unsigned int) (b >> 32);
-        for (int i = 2; i < WIDTH; i++)
-            pn[i] = 0;
-    }
+    constexpr base_uint(uint64_t b) : pn{b} {}
 
     explicit base_uint(const std::string& str);
 
-    const base_uint operator~() const {
+    constexpr const base_uint operator~() const {
         base_uint ret;
         for (int i = 0; i < WIDTH; i++)
             ret.pn[i] = ~pn[i];
         return ret;
     }
 
-    const base_uint operator-() const {
+    constexpr const base_uint operator-() const {
         base_uint ret;
         for (int i = 0; i < WIDTH; i++)
             ret.pn[i] = ~pn[i];
@@ -76,83 +65,102 @@ public:
 
     double GetDouble() const;
 
-    base_uint& operator=(uint64_t b) {
-        pn[0] = (unsigned int) b;
-        pn[1] = (unsigned int) (b >> 32);
-        for (int i = 2; i < WIDTH; i++)
+    constexpr base_uint& operator=(uint64_t b) {
+        pn[0] = b;
+        for (int i = 1; i < WIDTH; i++)
             pn[i] = 0;
         return *this;
     }
 
-    base_uint& operator^=(const base_uint& b) {
+    constexpr base_uint& operator^=(const base_uint& b) {
         for (int i = 0; i < WIDTH; i++)
             pn[i] ^= b.pn[i];
         return *this;
     }
 
-    base_uint& operator&=(const base_uint& b) {
+    constexpr base_uint& operator&=(const base_uint& b) {
         for (int i = 0; i < WIDTH; i++)
             pn[i] &= b.pn[i];
         return *this;
     }
 
-    base_uint& operator|=(const base_uint& b) {
+    constexpr base_uint& operator|=(const base_uint& b) {
         for (int i = 0; i < WIDTH; i++)
             pn[i] |= b.pn[i];
         return *this;
     }
 
-    base_uint& operator^=(uint64_t b) {
-        pn[0] ^= (unsigned int) b;
-        pn[1] ^= (unsigned int) (b >> 32);
+    constexpr base_uint& operator^=(uint64_t b) {
+        pn[0] ^= b;
         return *this;
     }
 
-    base_uint& operator|=(uint64_t b) {
-        pn[0] |= (unsigned int) b;
-        pn[1] |= (unsigned int) (b >> 32);
+    constexpr base_uint& operator|=(uint64_t b) {
+        pn[0] |= b;
         return *this;
     }
 
-    base_uint& operator<<=(unsigned int shift);
-    base_uint& operator>>=(unsigned int shift);
+    constexpr base_uint& operator<<=(unsigned int shift) {
+        base_uint a(*this);
+        for (int i = 0; i < WIDTH; i++)
+            pn[i] = 0;
+        int k = shift / 64;
+        shift = shift % 64;
+        for (int i = 0; i + k < WIDTH; i++) {
+            if (i + k + 1 < WIDTH && shift != 0)
+                pn[i + k + 1] |= (a.pn[i] >> (64 - shift));
+            pn[i + k] |= (a.pn[i] << shift);
+        }
+        return *this;
+    }
 
-    base_uint& operator+=(const base_uint& b) {
-        uint64_t carry = 0;
+    constexpr base_uint& operator>>=(unsigned int shift) {
+        base_uint a(*this);
+        for (int i = 0; i < WIDTH; i++)
+            pn[i] = 0;
+        int k = shift / 64;
+        shift = shift % 64;
+        for (int i = k; i < WIDTH; i++) {
+            if (i - k - 1 >= 0 && shift != 0)
+                pn[i - k - 1] |= (a.pn[i] << (64 - shift));
+            pn[i - k] |= (a.pn[i] >> shift);
+        }
+        return *this;
+    }
 
+    constexpr base_uint& operator+=(const base_uint& b) {
+        uint128_t carry = 0;
         for (int i = 0; i < WIDTH; i++) {
-            uint64_t n = carry + pn[i] + b.pn[i];
-            pn[i]      = n & 0xffffffff;
-            carry      = n >> 32;
+            carry += (uint128_t) pn[i] + b.pn[i];
+            pn[i] = (uint64_t) carry;
+            carry >>= 64;
         }
-
         return *this;
     }
 
-    base_uint& operator-=(const base_uint& b) {
-        *this += -b;
+    constexpr base_uint& operator-=(const base_uint& b) {
+        uint64_t borrow = 0;
+        for (int i = 0; i < WIDTH; i++) {
+            uint128_t n = (uint128_t) pn[i] - b.pn[i] - borrow;
+            pn[i]       = (uint64_t) n;
+            borrow      = (uint64_t)(n >> 64) & 1;
+        }
         return *this;
     }
 
-    base_uint& operator+=(uint64_t b64) {
-        base_uint b;
-        b = b64;
-        *this += b;
-        return *this;
+    constexpr base_uint& operator+=(uint64_t b64) {
+        return *this += base_uint(b64);
     }
 
-    base_uint& operator-=(uint64_t b64) {
-        base_uint b;
-        b = b64;
-        *this += -b;
-        return *this;
+    constexpr base_uint& operator-=(uint64_t b64) {
+        return *this -= base_uint(b64);
     }
 
     base_uint& operator*=(uint32_t b32);
     base_uint& operator*=(const base_uint& b);
     base_uint& operator/=(const base_uint& b);
 
-    base_uint& operator++() {
+    constexpr base_uint& operator++() {
         // prefix operator
         int i = 0;
         while (i < WIDTH && ++pn[i] == 0)
@@ -160,35 +168,50 @@ public:
         return *this;
     }
 
-    const base_uint operator++(int) {
+    constexpr const base_uint operator++(int) {
         // postfix operator
         const base_uint ret = *this;
         ++(*this);
         return ret;
     }
 
-    base_uint& operator--() {
+    constexpr base_uint& operator--() {
         // prefix operator
         int i = 0;
-        while (i < WIDTH && --pn[i] == std::numeric_limits<uint32_t>::max())
+        while (i < WIDTH && --pn[i] == std::numeric_limits<uint64_t>::max())
             i++;
         return *this;
     }
 
-    const base_uint operator--(int) {
+    constexpr const base_uint operator--(int) {
         // postfix operator
         const base_uint ret = *this;
         --(*this);
         return ret;
     }
 
-    int CompareTo(const base_uint& b) const;
-    bool EqualTo(uint64_t b) const;
+    constexpr int CompareTo(const base_uint& b) const {
+        for (int i = WIDTH - 1; i >= 0; i--) {
+            if (pn[i] < b.pn[i])
+                return -1;
+            if (pn[i] > b.pn[i])
+                return 1;
+        }
+        return 0;
+    }
+
+    constexpr bool EqualTo(uint64_t b) const {
+        for (int i = WIDTH - 1; i >= 1; i--) {
+            if (pn[i])
+                return false;
+        }
+        return pn[0] == b;
+    }
 
-    friend inline const base_uint operator+(const base_uint& a, const base_uint& b) {
+    friend constexpr inline const base_uint operator+(const base_uint& a, const base_uint& b) {
         return base_uint(a) += b;
     }
-    friend inline const base_uint operator-(const base_uint& a, const base_uint& b) {
+    friend constexpr inline const base_uint operator-(const base_uint& a, const base_uint& b) {
         return base_uint(a) -= b;
     }
     friend inline const base_uint operator*(const base_uint& a, const base_uint& b) {
@@ -197,46 +220,46 @@ public:
     friend inline const base_uint operator/(const base_uint& a, const base_uint& b) {
         return base_uint(a) /= b;
     }
-    friend inline const base_uint operator|(const base_uint& a, const base_uint& b) {
+    friend constexpr inline const base_uint operator|(const base_uint& a, const base_uint& b) {
         return base_uint(a) |= b;
     }
-    friend inline const base_uint operator&(const base_uint& a, const base_uint& b) {
+    friend constexpr inline const base_uint operator&(const base_uint& a, const base_uint& b) {
         return base_uint(a) &= b;
     }
-    friend inline const base_uint operator^(const base_uint& a, const base_uint& b) {
+    friend constexpr inline const base_uint operator^(const base_uint& a, const base_uint& b) {
         return base_uint(a) ^= b;
     }
-    friend inline const base_uint operator>>(const base_uint& a, int shift) {
+    friend constexpr inline const base_uint operator>>(const base_uint& a, int shift) {
         return base_uint(a) >>= shift;
     }
-    friend inline const base_uint operator<<(const base_uint& a, int shift) {
+    friend constexpr inline const base_uint operator<<(const base_uint& a, int shift) {
         return base_uint(a) <<= shift;
     }
     friend inline const base_uint operator*(const base_uint& a, uint32_t b) {
         return base_uint(a) *= b;
     }
-    friend inline bool operator==(const base_uint& a, const base_uint& b) {
-        return memcmp(a.pn, b.pn, sizeof(a.pn)) == 0;
+    friend constexpr inline bool operator==(const base_uint& a, const base_uint& b) {
+        return a.CompareTo(b) == 0;
     }
-    friend inline bool operator!=(const base_uint& a, const base_uint& b) {
-        return memcmp(a.pn, b.pn, sizeof(a.pn)) != 0;
+    friend constexpr inline bool operator!=(const base_uint& a, const base_uint& b) {
+        return a.CompareTo(b) != 0;
     }
-    friend inline bool operator>(const base_uint& a, const base_uint& b) {
+    friend constexpr inline bool operator>(const base_uint& a, const base_uint& b) {
         return a.CompareTo(b) > 0;
     }
-    friend inline bool operator<(const base_uint& a, const base_uint& b) {
+    friend constexpr inline bool operator<(const base_uint& a, const base_uint& b) {
         return a.CompareTo(b) < 0;
     }
-    friend inline bool operator>=(const base_uint& a, const base_uint& b) {
+    friend constexpr inline bool operator>=(const base_uint& a, const base_uint& b) {
         return a.CompareTo(b) >= 0;
     }
-    friend inline bool operator<=(const base_uint& a, const base_uint& b) {
+    friend constexpr inline bool operator<=(const base_uint& a, const base_uint& b) {
         return a.CompareTo(b) <= 0;
     }
-    friend inline bool operator==(const base_uint& a, uint64_t b) {
+    friend constexpr inline bool operator==(const base_uint& a, uint64_t b) {
         return a.EqualTo(b);
     }
-    friend inline bool operator!=(const base_uint& a, uint64_t b) {
+    friend constexpr inline bool operator!=(const base_uint& a, uint64_t b) {
         return !a.EqualTo(b);
     }
 
@@ -244,7 +267,7 @@ public:
     void SetHex(const char* psz);
     void SetHex(const std::string& str);
 
-    unsigned int size() const {
+    constexpr unsigned int size() const {
         return sizeof(pn);
     }
 
@@ -252,11 +275,17 @@ public:
      * Returns the position of the highest bit set plus one, or zero if the
      * value is zero.
      */
-    unsigned int bits() const;
+    constexpr unsigned int bits() const {
+        for (int pos = WIDTH - 1; pos >= 0; pos--) {
+            if (pn[pos]) {
+                return 64 * pos + 64 - __builtin_clzll(pn[pos]);
+            }
+        }
+        return 0;
+    }
 
-    uint64_t GetLow64() const {
-        static_assert(WIDTH >= 2, "Assertion WIDTH >= 2 failed (WIDTH = BITS / 32). BITS is a template parameter.");
-        return pn[0] | (uint64_t) pn[1] << 32;
+    constexpr uint64_t GetLow64() const {
+        return pn[0];
     }
 };
 
@@ -269,7 +298,7 @@ string to_string(const base_uint<BITS>& uint);
 class arith_uint256 : public base_uint<256> {
 public:
     using base_uint::base_uint;
-    arith_uint256(const base_uint<256>& b) : base_uint<256>(b) {}
+    constexpr arith_uint256(const base_uint<256>& b) : base_uint<256>(b) {}
 
     /**
      * The "compact" format is a representation of a whole
@@ -291,8 +320,47 @@ public:
      * complexities of the sign bit and using base 256 are probably an
      * implementation accident.
      */
-    arith_uint256& SetCompact(uint32_t nCompact, bool* pfNegative = nullptr, bool* pfOverflow = nullptr);
-    uint32_t GetCompact(bool fNegative = false) const;
+    // This implementation directly uses shifts instead of going
+    // through an intermediate MPI representation.
+    constexpr arith_uint256& SetCompact(uint32_t nCompact, bool* pfNegative = nullptr, bool* pfOverflow = nullptr) {
+        int nSize      = nCompact >> 24;
+        uint32_t nWord = nCompact & 0x007fffff;
+        if (nSize <= 3) {
+            nWord >>= 8 * (3 - nSize);
+            *this = nWord;
+        } else {
+            *this = nWord;
+            *this <<= 8 * (nSize - 3);
+        }
+        if (pfNegative)
+            *pfNegative = nWord != 0 && (nCompact & 0x00800000) != 0;
+        if (pfOverflow)
+            *pfOverflow =
+                nWord != 0 && ((nSize > 34) || (nWord > 0xff && nSize > 33) || (nWord > 0xffff && nSize > 32));
+        return *this;
+    }
+
+    constexpr uint32_t GetCompact(bool fNegative = false) const {
+        int nSize         = (bits() + 7) / 8;
+        uint32_t nCompact = 0;
+        if (nSize <= 3) {
+            nCompact = GetLow64() << 8 * (3 - nSize);
+        } else {
+            nCompact = (*this >> 8 * (nSize - 3)).GetLow64();
+        }
+        // The 0x00800000 bit denotes the sign.
+        // Thus, if it is already set, divide the mantissa by 256 and increase the
+        // exponent.
+        if (nCompact & 0x00800000) {
+            nCompact >>= 8;
+            nSize++;
+        }
+        assert((nCompact & ~0x007fffff) == 0);
+        assert(nSize < 256);
+        nCompact |= nSize << 24;
+        nCompact |= (fNegative && (nCompact & 0x007fffff) ? 0x00800000 : 0);
+        return nCompact;
+    }
 
     void Round(size_t bytes) {
         if (bytes > 32) {
@@ -301,14 +369,8 @@ public:
         memset(pn, 0, 32 - bytes);
     }
 
-    size_t LeadingZeros() {
-        size_t counter  = 0;
-        arith_uint256 n = arith_uint256(1) << (sizeof(uint32_t) * WIDTH * 8 - 1);
-        while ((*this & n) == 0 && n != 0) {
-            n >>= 1;
-            counter++;
-        }
-        return counter;
+    size_t LeadingZeros() const {
+        return 256 - bits();
     }
 
     friend uint256 ArithToUint256(const arith_uint256&);
@@ -0,0 +1,115 @@
+// Copyright (c) 2019 EPI-ONE Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "binary_trace.h"
+
+#include <chrono>
+#include <cstring>
+#include <functional>
+
+std::atomic<BinaryTrace*> BinaryTrace::instance_ = nullptr;
+std::atomic_size_t BinaryTrace::recording_       = 0;
+std::atomic_size_t BinaryTrace::dropped_         = 0;
+
+BinaryTrace::BinaryTrace(FILE* file, size_t capacity) : file_(file), ring_(capacity) {
+    thread_ = std::thread(&BinaryTrace::Loop, this);
+}
+
+BinaryTrace::~BinaryTrace() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        interrupt_ = true;
+    }
+    cv_.notify_one();
+    thread_.join();
+
+    Flush();
+    fclose(file_);
+}
+
+bool BinaryTrace::Open(const std::string& path, size_t capacity) {
+    Close();
+
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    if (fwrite(kMagic, sizeof(kMagic), 1, file) != 1) {
+        fclose(file);
+        return false;
+    }
+
+    dropped_ = 0;
+    instance_.store(new BinaryTrace(file, capacity));
+    return true;
+}
+
+void BinaryTrace::Close() {
+    auto* instance = instance_.exchange(nullptr);
+    if (!instance) {
+        return;
+    }
+
+    // wait for the threads which have seen the instance before it was unset
+    while (recording_.load()) {
+        std::this_thread::yield();
+    }
+    delete instance;
+}
+
+void BinaryTrace::Record(TraceEvent event, const uint256& hash, uint64_t arg) {
+    recording_.fetch_add(1);
+    auto* instance = instance_.load();
+    if (instance) {
+        using namespace std::chrono;
+        static thread_local uint32_t thread = std::hash<std::thread::id>{}(std::this_thread::get_id());
+        auto now                            = duration_cast<nanoseconds>(system_clock::now().time_since_epoch());
+
+        Entry entry{static_cast<uint64_t>(now.count()), static_cast<uint32_t>(event), thread, arg, hash};
+        if (!instance->ring_.TryPush(std::move(entry))) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    recording_.fetch_sub(1);
+}
+
+size_t BinaryTrace::GetDropped() {
+    return dropped_.load(std::memory_order_relaxed);
+}
+
+std::vector<BinaryTrace::Entry> BinaryTrace::ReadFile(const std::string& path) {
+    std::vector<Entry> entries;
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) {
+        return entries;
+    }
+
+    char magic[sizeof(kMagic)];
+    if (fread(magic, sizeof(magic), 1, file) == 1 && memcmp(magic, kMagic, sizeof(kMagic)) == 0) {
+        Entry entry;
+        while (fread(&entry, sizeof(entry), 1, file) == 1) {
+            entries.push_back(entry);
+        }
+    }
+    fclose(file);
+    return entries;
+}
+
+void BinaryTrace::Flush() {
+    Entry entry;
+    while (ring_.TryPop(entry)) {
+        fwrite(&entry, sizeof(entry), 1, file_);
+    }
+    fflush(file_);
+}
+
+void BinaryTrace::Loop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!interrupt_) {
+        lock.unlock();
+        Flush();
+        lock.lock();
+        cv_.wait_for(lock, std::chrono::milliseconds(10), [this] { return interrupt_; });
+    }
+}
@@ -0,0 +1,110 @@
+// Copyright (c) 2019 EPI-ONE Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef EPIC_BINARY_TRACE_H
+#define EPIC_BINARY_TRACE_H
+
+#include "big_uint.h"
+#include "mpmc_queue.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum class TraceEvent : uint32_t {
+    BLOCK_RECEIVED = 1,
+    BLOCK_ORPHANED,
+    BLOCK_PENDING,
+    BLOCK_VALIDATED,
+    TX_INVALID,
+    MILESTONE,
+};
+
+/**
+ * Records events as fixed size binary entries, which are much cheaper than
+ * formatted log lines when every block and transaction is traced. The records
+ * are put into a lock-free ring and appended to the file in batches by a
+ * background thread. If the ring is full, the entry is dropped and counted
+ * rather than blocking the caller.
+ *
+ * The file starts with kMagic and is followed by the raw entries in the
+ * native byte order, which can be read back with ReadFile.
+ */
+class BinaryTrace {
+public:
+    struct Entry {
+        // nanoseconds since the epoch of the system clock
+        uint64_t time;
+        uint32_t event;
+        uint32_t thread;
+        uint64_t arg;
+        uint256 hash;
+    };
+
+    static constexpr char kMagic[8] = {'E', 'P', 'I', 'C', 'T', 'R', 'C', '1'};
+
+    /**
+     * starts tracing to the file, which is truncated
+     * @param capacity of the ring, rounded up to a power of 2
+     */
+    static bool Open(const std::string& path, size_t capacity = 1 << 16);
+
+    /**
+     * stops tracing and writes out the remaining entries
+     */
+    static void Close();
+
+    static bool IsEnabled() {
+        return instance_.load(std::memory_order_relaxed) != nullptr;
+    }
+
+    static void Record(TraceEvent event, const uint256& hash, uint64_t arg = 0);
+
+    /**
+     * the number of entries dropped because the ring was full since the last Open
+     */
+    static size_t GetDropped();
+
+    static std::vector<Entry> ReadFile(const std::string& path);
+
+private:
+    static std::atomic<BinaryTrace*> instance_;
+    // the number of threads which are recording, so that Close knows when the instance is unused
+    static std::atomic_size_t recording_;
+    static std::atomic_size_t dropped_;
+
+    FILE* file_;
+    MPMCQueue<Entry> ring_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool interrupt_ = false;
+    std::thread thread_;
+
+    BinaryTrace(FILE* file, size_t capacity);
+    ~BinaryTrace();
+
+    /**
+     * writes out the entries in the ring
+     */
+    void Flush();
+
+    void Loop();
+};
+
+/**
+ * records the event if tracing is enabled, without evaluating the arguments otherwise
+ */
+#define TRACE_EVENT(event, ...)                                  \
+    do {                                                         \
+        if (BinaryTrace::IsEnabled()) {                          \
+            BinaryTrace::Record(TraceEvent::event, __VA_ARGS__); \
+        }                                                        \
+    } while (false)
+
+#endif // EPIC_BINARY_TRACE_H
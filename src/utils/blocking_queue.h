@@ -5,101 +5,204 @@
 #ifndef EPIC_BLOCKING_QUEUE_H
 #define EPIC_BLOCKING_QUEUE_H
 
+#include "event_count.h"
+#include "mpmc_queue.h"
+
 #include <atomic>
 #include <cassert>
-#include <condition_variable>
-#include <queue>
+#include <limits>
 #include <vector>
 
-#define DEFAULT_CAPACITY 1 << 16
-
+// the ring of a queue is allocated in full at construction, so only
+// queues taking bursts, e.g., the blocks of a sync bundle, are large
+#define DEFAULT_CAPACITY (1 << 10)
+#define LARGE_CAPACITY (1 << 16)
+
+/**
+ * A bounded queue on which Put blocks while it is full and Take blocks while
+ * it is empty. The elements are kept in a lock-free MPMCQueue, and a blocked
+ * thread sleeps on an EventCount, so that a Put or a Take wakes up at most one
+ * thread and only if some thread sleeps. A thread that had to wait passes the
+ * wake-up on if there is still more for the others to do.
+ * After Quit, Put and Take return at once without effect until Enable.
+ */
 template <typename T>
 class BlockingQueue {
 public:
-    BlockingQueue() : mtx_(), full_(), empty_(), capacity_(DEFAULT_CAPACITY) {}
+    /**
+     * @param capacity rounded up to a power of 2
+     */
+    explicit BlockingQueue(size_t capacity = DEFAULT_CAPACITY) : queue_(std::make_unique<MPMCQueue<T>>(capacity)) {}
 
     ~BlockingQueue() {
         Clear();
     }
 
     void Put(T& element) {
-        std::unique_lock<std::mutex> lock(mtx_);
-        full_.wait(lock, [this] { return (queue_.size() < capacity_ || quit_); });
-        if (quit_) {
-            return;
-        }
-        queue_.emplace(std::move(element));
-        empty_.notify_all();
+        Put(std::move(element));
     }
 
     void Put(T&& element) {
-        std::unique_lock<std::mutex> lock(mtx_);
-        full_.wait(lock, [this] { return (queue_.size() < capacity_ || quit_); });
-        if (quit_) {
-            return;
+        bool waited = false;
+        while (!quit_) {
+            if (queue_->TryPush(std::move(element))) {
+                notEmpty_.Notify();
+                if (waited && !queue_->Full()) {
+                    notFull_.Notify();
+                }
+                return;
+            }
+
+            waited   = true;
+            auto key = notFull_.PrepareWait();
+            if (!quit_ && queue_->Full()) {
+                notFull_.Wait(key);
+            } else {
+                notFull_.CancelWait();
+            }
+        }
+    }
+
+    /**
+     * puts all of the elements in order, blocking while the queue is full
+     * @return the number of elements put, which is less than all only on quit
+     */
+    size_t PutAll(std::vector<T>& elements) {
+        size_t n    = 0;
+        bool waited = false;
+        while (n < elements.size() && !quit_) {
+            size_t batch = n;
+            while (n < elements.size() && queue_->TryPush(std::move(elements[n]))) {
+                n++;
+            }
+            if (n > batch) {
+                notEmpty_.Notify(n - batch);
+                continue;
+            }
+
+            waited   = true;
+            auto key = notFull_.PrepareWait();
+            if (!quit_ && queue_->Full()) {
+                notFull_.Wait(key);
+            } else {
+                notFull_.CancelWait();
+            }
+        }
+        if (waited && !queue_->Full()) {
+            notFull_.Notify();
         }
-        queue_.emplace(std::move(element));
-        empty_.notify_all();
+        return n;
     }
 
     bool Take(T& front) {
-        std::unique_lock<std::mutex> lock(mtx_);
-        empty_.wait(lock, [this] { return !queue_.empty() || quit_; });
-        if (quit_) {
-            return false;
+        bool waited = false;
+        while (!quit_) {
+            if (queue_->TryPop(front)) {
+                notFull_.Notify();
+                if (waited && !queue_->Empty()) {
+                    notEmpty_.Notify();
+                }
+                return true;
+            }
+
+            waited   = true;
+            auto key = notEmpty_.PrepareWait();
+            if (!quit_ && queue_->Empty()) {
+                notEmpty_.Wait(key);
+            } else {
+                notEmpty_.CancelWait();
+            }
         }
-        front = std::move(queue_.front());
-        queue_.pop();
-        full_.notify_all();
-        return true;
+        return false;
+    }
+
+    /**
+     * blocks until the queue is not empty and then moves
+     * up to max of the elements to the back of the vector
+     * @return false if the queue quits
+     */
+    bool TakeAll(std::vector<T>& elements, size_t max = std::numeric_limits<size_t>::max()) {
+        size_t n    = 0;
+        bool waited = false;
+        while (!quit_) {
+            T element;
+            while (n < max && queue_->TryPop(element)) {
+                elements.emplace_back(std::move(element));
+                n++;
+            }
+            if (n > 0) {
+                notFull_.Notify(n);
+                if (waited && !queue_->Empty()) {
+                    notEmpty_.Notify();
+                }
+                return true;
+            }
+
+            waited   = true;
+            auto key = notEmpty_.PrepareWait();
+            if (!quit_ && queue_->Empty()) {
+                notEmpty_.Wait(key);
+            } else {
+                notEmpty_.CancelWait();
+            }
+        }
+        return false;
     }
 
     size_t Size() const {
-        std::lock_guard<std::mutex> lock(mtx_);
-        return queue_.size();
+        return queue_->Size();
     }
 
     bool Empty() const {
-        std::lock_guard<std::mutex> lock(mtx_);
-        return queue_.empty();
+        return queue_->Empty();
     }
 
+    /**
+     * should only be called while no other thread uses the queue
+     */
     void SetCapacity(size_t capacity) {
-        capacity_ = capacity;
+        auto queue = std::make_unique<MPMCQueue<T>>(capacity);
+        T element;
+        while (queue_->TryPop(element)) {
+            queue->TryPush(std::move(element));
+        }
+        queue_ = std::move(queue);
     }
 
     void Quit() {
-        std::lock_guard<std::mutex> lock(mtx_);
         quit_ = true;
-        full_.notify_all();
-        empty_.notify_all();
+        notFull_.NotifyAll();
+        notEmpty_.NotifyAll();
     }
 
     void Enable() {
-        std::lock_guard<std::mutex> lock(mtx_);
         quit_ = false;
-        full_.notify_all();
-        empty_.notify_all();
+        notFull_.NotifyAll();
+        notEmpty_.NotifyAll();
     }
 
     void Clear() {
-        std::lock_guard<std::mutex> lock(mtx_);
-        std::queue<T> empty;
-        std::swap(queue_, empty);
-        full_.notify_all();
+        T element;
+        while (queue_->TryPop(element)) {
+        }
+        notFull_.NotifyAll();
     }
 
+    /**
+     * the queue must not be empty and no other thread
+     * should take the front element meanwhile
+     */
     T& Front() {
-        std::lock_guard<std::mutex> lock(mtx_);
-        return queue_.front();
+        T* front = queue_->Front();
+        assert(front);
+        return *front;
     }
 
 private:
-    mutable std::mutex mtx_;
-    std::condition_variable full_;
-    std::condition_variable empty_;
-    std::queue<T> queue_;
-    size_t capacity_;
+    std::unique_ptr<MPMCQueue<T>> queue_;
+
+    EventCount notFull_;
+    EventCount notEmpty_;
     std::atomic_bool quit_ = false;
 };
 
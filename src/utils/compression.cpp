@@ -0,0 +1,81 @@
+// Copyright (c) 2019 EPI-ONE Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "compression.h"
+
+#include <algorithm>
+#include <climits>
+#include <zlib.h>
+
+namespace compression {
+
+static constexpr size_t inflate_chunk_size = 64 * 1024;
+
+bool Compress(const char* data, size_t size, VStream& out) {
+    if (size == 0 || size > UINT_MAX) {
+        return false;
+    }
+
+    z_stream zs{};
+    if (deflateInit(&zs, Z_BEST_SPEED) != Z_OK) {
+        return false;
+    }
+
+    out.clear();
+    out.resize(deflateBound(&zs, size));
+    zs.next_in   = (Bytef*) data;
+    zs.avail_in  = size;
+    zs.next_out  = (Bytef*) out.data();
+    zs.avail_out = out.size();
+
+    int ret = deflate(&zs, Z_FINISH);
+    deflateEnd(&zs);
+    if (ret != Z_STREAM_END || zs.total_out >= size) {
+        out.clear();
+        return false;
+    }
+
+    out.resize(zs.total_out);
+    return true;
+}
+
+bool Decompress(const char* data, size_t size, VStream& out, size_t maxSize) {
+    if (size > UINT_MAX) {
+        return false;
+    }
+
+    z_stream zs{};
+    if (inflateInit(&zs) != Z_OK) {
+        return false;
+    }
+
+    out.clear();
+    zs.next_in  = (Bytef*) data;
+    zs.avail_in = size;
+
+    // inflate up to one byte more than allowed to tell oversized output
+    // from output that is exactly maxSize
+    const size_t limit = maxSize + 1;
+    int ret            = Z_OK;
+    while (ret == Z_OK && out.size() < limit) {
+        // grow the output only as the data is actually inflated
+        size_t produced = out.size();
+        size_t chunk    = std::min(inflate_chunk_size, limit - produced);
+        out.resize(produced + chunk);
+        zs.next_out  = (Bytef*) out.data() + produced;
+        zs.avail_out = chunk;
+
+        ret = inflate(&zs, Z_NO_FLUSH);
+        out.resize(produced + chunk - zs.avail_out);
+    }
+    inflateEnd(&zs);
+
+    if (ret != Z_STREAM_END || zs.avail_in != 0 || out.size() > maxSize) {
+        out.clear();
+        return false;
+    }
+    return true;
+}
+
+} // namespace compression
@@ -0,0 +1,27 @@
+// Copyright (c) 2019 EPI-ONE Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef EPIC_COMPRESSION_H
+#define EPIC_COMPRESSION_H
+
+#include "stream.h"
+
+namespace compression {
+
+/**
+ * Deflates data at the fastest level into out. Returns false
+ * if it fails or the result is not smaller than the input,
+ * in which case the data should be sent as it is
+ */
+bool Compress(const char* data, size_t size, VStream& out);
+
+/**
+ * Inflates data into out chunk by chunk. Fails on corrupted
+ * input or if the output would exceed maxSize
+ */
+bool Decompress(const char* data, size_t size, VStream& out, size_t maxSize);
+
+} // namespace compression
+
+#endif // EPIC_COMPRESSION_H
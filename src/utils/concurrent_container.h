@@ -6,6 +6,8 @@
 #define EPIC_CONCURRENT_CONTAINER_H
 
 #include <functional>
+#include <mutex>
+#include <optional>
 #include <queue>
 #include <shared_mutex>
 #include <unordered_map>
@@ -280,12 +282,7 @@ public:
             return {};
         }
 
-        const_iterator it = base::c.begin();
-        for (size_t i = 0; i < rand() % base::c.size(); ++i) {
-            ++it;
-        }
-
-        return it->second;
+        return std::next(base::c.begin(), rand() % base::c.size())->second;
     }
 
     std::vector<std::pair<K, V>> dump_to_vector() const {
@@ -317,6 +314,19 @@ public:
         WRITER_LOCK(base::mutex_)
         return base::c.erase(k);
     }
+
+    /**
+     * Removes and returns an arbitrary element, or nullopt if the set is
+     * empty, so that concurrent consumers never take the same element
+     */
+    std::optional<key_type> TryPop() {
+        WRITER_LOCK(base::mutex_)
+        if (base::c.empty()) {
+            return {};
+        }
+        auto node = base::c.extract(base::c.begin());
+        return std::move(node.value());
+    }
 };
 
 template <typename T>
@@ -0,0 +1,104 @@
+// Copyright (c) 2019 EPI-ONE Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef EPIC_EVENT_COUNT_H
+#define EPIC_EVENT_COUNT_H
+
+#include <atomic>
+#include <climits>
+#include <cstdint>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#else
+#include <condition_variable>
+#include <mutex>
+#endif
+
+/**
+ * Lets threads sleep until a condition checked without locks may have changed.
+ * A waiter calls PrepareWait, checks the condition again, and then either calls
+ * Wait with the returned key or CancelWait. A notifier changes the condition
+ * and then calls Notify, which costs only an atomic load if nobody waits.
+ *
+ * Notify skips the wake-up while an earlier one has not reached any waiter yet,
+ * so that a fast notifier doesn't make a system call for every change. Hence a
+ * waiter which finds the condition still true after it is done must notify the
+ * next waiter.
+ */
+class EventCount {
+public:
+    uint32_t PrepareWait() {
+        waiters_.fetch_add(1, std::memory_order_seq_cst);
+        return epoch_.load(std::memory_order_acquire);
+    }
+
+    void CancelWait() {
+        signaled_.store(false, std::memory_order_seq_cst);
+        waiters_.fetch_sub(1, std::memory_order_seq_cst);
+    }
+
+    /**
+     * blocks until a notification after the PrepareWait that returned the key
+     */
+    void Wait(uint32_t key) {
+        while (epoch_.load(std::memory_order_acquire) == key) {
+#ifdef __linux__
+            syscall(SYS_futex, reinterpret_cast<uint32_t*>(&epoch_), FUTEX_WAIT_PRIVATE, key, nullptr, nullptr, 0);
+#else
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [&] { return epoch_.load(std::memory_order_acquire) != key; });
+#endif
+        }
+        signaled_.store(false, std::memory_order_seq_cst);
+        waiters_.fetch_sub(1, std::memory_order_seq_cst);
+    }
+
+    /**
+     * wakes up at most n of the waiters
+     */
+    void Notify(int n = 1) {
+        // pairs with the increment in PrepareWait, so that either the waiter sees
+        // the changed condition or we see the waiter
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiters_.load(std::memory_order_seq_cst) == 0) {
+            return;
+        }
+        if (n == 1 && signaled_.exchange(true, std::memory_order_seq_cst)) {
+            return;
+        }
+
+        epoch_.fetch_add(1, std::memory_order_release);
+#ifdef __linux__
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&epoch_), FUTEX_WAKE_PRIVATE, n, nullptr, nullptr, 0);
+#else
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+        }
+        if (n == 1) {
+            cv_.notify_one();
+        } else {
+            cv_.notify_all();
+        }
+#endif
+    }
+
+    void NotifyAll() {
+        Notify(INT_MAX);
+    }
+
+private:
+    std::atomic_uint32_t epoch_   = 0;
+    std::atomic_uint32_t waiters_ = 0;
+    std::atomic_bool signaled_    = false;
+
+#ifndef __linux__
+    std::mutex mutex_;
+    std::condition_variable cv_;
+#endif
+};
+
+#endif // EPIC_EVENT_COUNT_H
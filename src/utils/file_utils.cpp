@@ -7,8 +7,10 @@
 #include "spdlog/spdlog.h"
 #include "tinyformat.h"
 
+#include <fcntl.h>
 #include <filesystem>
 #include <regex>
+#include <unistd.h>
 
 bool CheckDirExist(const std::string& dirPath) {
     struct stat info;
@@ -61,6 +63,20 @@ void DeleteDir(const std::string& dirpath) {
     }
 }
 
+bool SyncPath(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        spdlog::error("Failed to open {}: {}", path, strerror(errno));
+        return false;
+    }
+    bool synced = fsync(fd) == 0;
+    if (!synced) {
+        spdlog::error("Failed to sync {}: {}", path, strerror(errno));
+    }
+    close(fd);
+    return synced;
+}
+
 void file::SetDataDirPrefix(std::string strprefix) {
     prefix = strprefix + "/";
 }
@@ -180,6 +196,53 @@ bool file::DeleteInvalidFiles(FilePos& pos, file::FileType type) {
     return true;
 }
 
+size_t file::DeletePrunedFiles(const FilePos& pos, file::FileType type) {
+    std::string dir = file::prefix + file::typestr[type];
+    std::regex epoch_reg(file::epoch_regex);
+    auto filename_reg = type == file::BLK ? std::regex(file::blk_name_regex) : std::regex(file::vtx_name_regex);
+    std::vector<std::filesystem::directory_entry> toBeDeleted{};
+
+    // collect all files lying in front of the file of pos
+    std::filesystem::directory_iterator dirList(dir);
+    for (const std::filesystem::directory_entry& epoch_dir : dirList) {
+        std::string epoch_dirname = epoch_dir.path().filename();
+        if (!epoch_dir.is_directory() || !regex_match(epoch_dirname, epoch_reg)) {
+            continue;
+        }
+
+        uint32_t epoch = std::stoi(epoch_dirname.substr(1));
+        if (epoch > pos.nEpoch) {
+            continue;
+        }
+
+        std::filesystem::directory_iterator fileList(epoch_dir.path());
+        for (const std::filesystem::directory_entry& file : fileList) {
+            std::string filename = file.path().filename();
+            if (file.is_directory() || !regex_match(filename, filename_reg)) {
+                continue;
+            }
+            uint32_t name = std::stoi(filename.substr(3));
+            if (epoch < pos.nEpoch || name < pos.nName) {
+                toBeDeleted.push_back(file);
+            }
+        }
+    }
+
+    for (auto& file : toBeDeleted) {
+        spdlog::debug("Delete pruned file {}", file.path().string());
+        std::filesystem::remove(file);
+    }
+
+    std::filesystem::directory_iterator newdirList(dir);
+    for (const std::filesystem::directory_entry& epoch_dir : newdirList) {
+        if (std::filesystem::is_directory(epoch_dir.path()) && std::filesystem::is_empty(epoch_dir.path())) {
+            spdlog::debug("Delete empty directory {}", epoch_dir.path().relative_path().string());
+            std::filesystem::remove(epoch_dir);
+        }
+    }
+    return toBeDeleted.size();
+}
+
 void file::CalculateChecksum(file::FileType type, FilePos pos) {
     pos.nOffset = file::checksum_size;
     FileModifier modifier(type, pos);
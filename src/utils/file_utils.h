@@ -25,6 +25,11 @@ bool CheckFileExist(const std::string& filePath);
 bool MkdirRecursive(const std::string& path);
 void DeleteDir(const std::string& dirpath);
 
+/**
+ * Flushes a file, or the entries of a directory, to the disk
+ */
+bool SyncPath(const std::string& path);
+
 struct FilePos;
 class FileReader;
 class FileWriter;
@@ -54,6 +59,7 @@ void CalculateChecksum(file::FileType type, FilePos pos);
 void UpdateChecksum(file::FileType type, FilePos& pos, size_t last_offset);
 bool ValidateChecksum(file::FileType type, FilePos pos);
 bool DeleteInvalidFiles(FilePos& pos, file::FileType type);
+size_t DeletePrunedFiles(const FilePos& pos, file::FileType type);
 
 uint64_t GetFileSize(file::FileType type, FilePos pos);
 std::unordered_set<uint32_t> GetAllEpoch(FileType type);
@@ -0,0 +1,561 @@
+// Copyright (c) 2019 EPI-ONE Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "io_backend.h"
+#include "spdlog/spdlog.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <numeric>
+#include <unistd.h>
+#include <unordered_map>
+
+#ifdef HAVE_IO_URING
+#include <atomic>
+#include <condition_variable>
+#include <linux/io_uring.h>
+#include <mutex>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <thread>
+#endif
+
+namespace {
+/**
+ * Opens each distinct path only once and closes them all on destruction
+ */
+class FdCache {
+public:
+    FdCache() = default;
+    FdCache(const FdCache&) = delete;
+    FdCache& operator=(const FdCache&) = delete;
+
+    ~FdCache() {
+        for (const auto& [path, fd] : fds_) {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+    }
+
+    int Get(const std::string& path, int flags) {
+        auto it = fds_.find(path);
+        if (it != fds_.end()) {
+            return it->second;
+        }
+
+        int fd = open(path.c_str(), flags | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            spdlog::error("Failed to open {}: {}", path, strerror(errno));
+        }
+        fds_.emplace(path, fd);
+        return fd;
+    }
+
+private:
+    std::unordered_map<std::string, int> fds_;
+};
+
+bool PreadFully(int fd, char* buf, size_t size, uint64_t offset) {
+    while (size > 0) {
+        ssize_t n = pread(fd, buf, size, offset);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        buf += n;
+        size -= n;
+        offset += n;
+    }
+    return true;
+}
+
+bool PwriteFully(int fd, const char* buf, size_t size, uint64_t offset) {
+    while (size > 0) {
+        ssize_t n = pwrite(fd, buf, size, offset);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        buf += n;
+        size -= n;
+        offset += n;
+    }
+    return true;
+}
+
+size_t TotalSize(const std::vector<ReadRange>& ranges) {
+    return std::accumulate(ranges.begin(), ranges.end(), size_t{0},
+                           [](size_t sum, const ReadRange& r) { return sum + r.size; });
+}
+} // namespace
+
+////////////////////
+// PreadBackend
+////////////////////
+
+std::optional<VStream> PreadBackend::Read(const std::vector<ReadRange>& ranges) {
+    VStream result;
+    result.resize(TotalSize(ranges));
+
+    FdCache fds;
+    size_t pos = 0;
+    for (const auto& r : ranges) {
+        int fd = fds.Get(r.path, O_RDONLY);
+        if (fd < 0 || !PreadFully(fd, result.data() + pos, r.size, r.offset)) {
+            spdlog::error("Failed to read {} bytes at {} of {}", r.size, r.offset, r.path);
+            return {};
+        }
+        pos += r.size;
+    }
+
+    return result;
+}
+
+void PreadBackend::AsyncRead(std::vector<ReadRange> ranges, ThreadPool& pool, ReadCallback callback) {
+    pool.Execute(
+        [this, ranges = std::move(ranges), callback = std::move(callback)]() { callback(Read(ranges)); });
+}
+
+bool PreadBackend::Write(const std::string& path, uint64_t offset, const char* data, size_t size) {
+    FdCache fds;
+    int fd = fds.Get(path, O_WRONLY | O_CREAT);
+    if (fd < 0 || !PwriteFully(fd, data, size, offset)) {
+        spdlog::error("Failed to write {} bytes at {} of {}", size, offset, path);
+        return false;
+    }
+    return true;
+}
+
+#ifdef HAVE_IO_URING
+
+////////////////////
+// IoUringBackend
+////////////////////
+
+/**
+ * Submits batches of readv/writev to an io_uring from any thread.
+ * A single reaper thread collects the completions and calls back
+ * once all the operations of a batch are done. Errors and short
+ * transfers are finished with pread/pwrite on the reaper thread,
+ * and the ops the ring fails to take on the submitting one.
+ */
+class IoUringBackend : public IOBackend {
+public:
+    static std::unique_ptr<IoUringBackend> Create(unsigned entries);
+
+    IoUringBackend(const IoUringBackend&) = delete;
+    IoUringBackend& operator=(const IoUringBackend&) = delete;
+    ~IoUringBackend() override;
+
+    std::string GetName() const override {
+        return "io_uring";
+    }
+
+    std::optional<VStream> Read(const std::vector<ReadRange>&) override;
+    void AsyncRead(std::vector<ReadRange>, ThreadPool&, ReadCallback) override;
+    bool Write(const std::string& path, uint64_t offset, const char* data, size_t size) override;
+
+private:
+    struct Batch;
+
+    struct Op {
+        Batch* batch;
+        bool write;
+        int fd;
+        uint64_t offset;
+        iovec iov;
+    };
+
+    struct Batch {
+        FdCache fds;
+        std::vector<Op> ops;
+        // completed on the reaper thread and, if the ring fails, on the submitting one
+        std::atomic_size_t remaining = 0;
+        std::atomic_bool ok          = true;
+        VStream buffer;
+        std::function<void(Batch&)> done;
+    };
+
+    int ringFd_;
+    io_uring_params params_;
+
+    void* sqRing_     = MAP_FAILED;
+    void* cqRing_     = MAP_FAILED;
+    io_uring_sqe* sqes_ = static_cast<io_uring_sqe*>(MAP_FAILED);
+    size_t sqRingSize_;
+    size_t cqRingSize_;
+
+    unsigned* sqTail_;
+    unsigned* sqMask_;
+    unsigned* sqArray_;
+    unsigned* cqHead_;
+    unsigned* cqTail_;
+    unsigned* cqMask_;
+    io_uring_cqe* cqes_;
+
+    std::mutex submitLock_;
+    std::condition_variable spaceCV_;
+    // number of submitted operations not yet reaped
+    size_t inflight_ = 0;
+
+    std::thread reaper_;
+
+    explicit IoUringBackend(int ringFd, const io_uring_params& params);
+
+    bool MapRings();
+
+    /**
+     * Queues the ops of the batch and takes its ownership
+     */
+    void Submit(Batch*);
+
+    /**
+     * Calls back on the target pool, or on the reaper thread if it is null
+     */
+    void SubmitRead(const std::vector<ReadRange>&, ThreadPool* target, ReadCallback);
+
+    /**
+     * Returns the number of queued entries the kernel didn't take
+     */
+    unsigned Enter(unsigned toSubmit);
+
+    /**
+     * Takes the last n entries which failed to be submitted back from
+     * the queue and returns their ops, to be finished with pread/pwrite
+     */
+    std::vector<Op*> Withdraw(unsigned n);
+
+    void Reap();
+    void Complete(Op*, int res);
+};
+
+std::unique_ptr<IoUringBackend> IoUringBackend::Create(unsigned entries) {
+    io_uring_params params{};
+    int ringFd = syscall(__NR_io_uring_setup, entries, &params);
+    if (ringFd < 0) {
+        spdlog::info("io_uring is not available: {}", strerror(errno));
+        return nullptr;
+    }
+
+    std::unique_ptr<IoUringBackend> backend(new IoUringBackend(ringFd, params));
+    if (!backend->MapRings()) {
+        spdlog::info("Failed to map io_uring: {}", strerror(errno));
+        return nullptr;
+    }
+
+    backend->reaper_ = std::thread(&IoUringBackend::Reap, backend.get());
+    return backend;
+}
+
+IoUringBackend::IoUringBackend(int ringFd, const io_uring_params& params) : ringFd_(ringFd), params_(params) {
+    sqRingSize_ = params_.sq_off.array + params_.sq_entries * sizeof(unsigned);
+    cqRingSize_ = params_.cq_off.cqes + params_.cq_entries * sizeof(io_uring_cqe);
+}
+
+bool IoUringBackend::MapRings() {
+    bool singleMmap = false;
+#ifdef IORING_FEAT_SINGLE_MMAP
+    singleMmap = params_.features & IORING_FEAT_SINGLE_MMAP;
+#endif
+    if (singleMmap) {
+        sqRingSize_ = cqRingSize_ = std::max(sqRingSize_, cqRingSize_);
+    }
+
+    sqRing_ = mmap(nullptr, sqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd_,
+                   IORING_OFF_SQ_RING);
+    if (sqRing_ == MAP_FAILED) {
+        return false;
+    }
+
+    if (singleMmap) {
+        cqRing_ = sqRing_;
+    } else {
+        cqRing_ = mmap(nullptr, cqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd_,
+                       IORING_OFF_CQ_RING);
+        if (cqRing_ == MAP_FAILED) {
+            return false;
+        }
+    }
+
+    sqes_ = static_cast<io_uring_sqe*>(mmap(nullptr, params_.sq_entries * sizeof(io_uring_sqe),
+                                            PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd_,
+                                            IORING_OFF_SQES));
+    if (sqes_ == MAP_FAILED) {
+        return false;
+    }
+
+    auto sq  = static_cast<char*>(sqRing_);
+    auto cq  = static_cast<char*>(cqRing_);
+    sqTail_  = reinterpret_cast<unsigned*>(sq + params_.sq_off.tail);
+    sqMask_  = reinterpret_cast<unsigned*>(sq + params_.sq_off.ring_mask);
+    sqArray_ = reinterpret_cast<unsigned*>(sq + params_.sq_off.array);
+    cqHead_  = reinterpret_cast<unsigned*>(cq + params_.cq_off.head);
+    cqTail_  = reinterpret_cast<unsigned*>(cq + params_.cq_off.tail);
+    cqMask_  = reinterpret_cast<unsigned*>(cq + params_.cq_off.ring_mask);
+    cqes_    = reinterpret_cast<io_uring_cqe*>(cq + params_.cq_off.cqes);
+    return true;
+}
+
+IoUringBackend::~IoUringBackend() {
+    if (reaper_.joinable()) {
+        // Wait for the submitted batches, then wake the reaper up with a nop
+        std::unique_lock<std::mutex> lock(submitLock_);
+        spaceCV_.wait(lock, [this]() { return inflight_ == 0; });
+
+        unsigned tail  = *sqTail_;
+        unsigned index = tail & *sqMask_;
+        io_uring_sqe& sqe = sqes_[index];
+        memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode    = IORING_OP_NOP;
+        sqe.user_data = 0;
+        sqArray_[index] = index;
+        __atomic_store_n(sqTail_, tail + 1, __ATOMIC_RELEASE);
+        Enter(1);
+        lock.unlock();
+
+        reaper_.join();
+    }
+
+    if (sqes_ != MAP_FAILED) {
+        munmap(sqes_, params_.sq_entries * sizeof(io_uring_sqe));
+    }
+    if (cqRing_ != MAP_FAILED && cqRing_ != sqRing_) {
+        munmap(cqRing_, cqRingSize_);
+    }
+    if (sqRing_ != MAP_FAILED) {
+        munmap(sqRing_, sqRingSize_);
+    }
+    close(ringFd_);
+}
+
+unsigned IoUringBackend::Enter(unsigned toSubmit) {
+    while (toSubmit > 0) {
+        int n = syscall(__NR_io_uring_enter, ringFd_, toSubmit, 0, 0, nullptr, 0);
+        if (n < 0) {
+            if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+                std::this_thread::yield();
+                continue;
+            }
+            spdlog::error("io_uring_enter failed: {}", strerror(errno));
+            return toSubmit;
+        }
+        toSubmit -= n;
+    }
+    return 0;
+}
+
+std::vector<IoUringBackend::Op*> IoUringBackend::Withdraw(unsigned n) {
+    // The kernel takes the entries in order and none of them when
+    // io_uring_enter fails, so the ones not taken are at the tail
+    unsigned tail = *sqTail_;
+    std::vector<Op*> ops;
+    ops.reserve(n);
+    for (unsigned i = n; i > 0; --i) {
+        ops.push_back(reinterpret_cast<Op*>(sqes_[(tail - i) & *sqMask_].user_data));
+    }
+    __atomic_store_n(sqTail_, tail - n, __ATOMIC_RELEASE);
+    inflight_ -= n;
+    return ops;
+}
+
+void IoUringBackend::Submit(Batch* batch) {
+    batch->remaining = batch->ops.size();
+    if (batch->ops.empty()) {
+        batch->done(*batch);
+        delete batch;
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(submitLock_);
+    std::vector<Op*> failed;
+    auto enter = [&](unsigned n) {
+        if (auto left = Enter(n)) {
+            auto ops = Withdraw(left);
+            failed.insert(failed.end(), ops.begin(), ops.end());
+        }
+    };
+
+    unsigned pending = 0;
+    for (auto& op : batch->ops) {
+        // Never have more operations in flight than the rings can hold
+        if (inflight_ >= params_.sq_entries) {
+            enter(pending);
+            pending = 0;
+            spaceCV_.wait(lock, [this]() { return inflight_ < params_.sq_entries; });
+        }
+
+        unsigned tail     = *sqTail_;
+        unsigned index    = tail & *sqMask_;
+        io_uring_sqe& sqe = sqes_[index];
+        memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode    = op.write ? IORING_OP_WRITEV : IORING_OP_READV;
+        sqe.fd        = op.fd;
+        sqe.off       = op.offset;
+        sqe.addr      = reinterpret_cast<uint64_t>(&op.iov);
+        sqe.len       = 1;
+        sqe.user_data = reinterpret_cast<uint64_t>(&op);
+
+        sqArray_[index] = index;
+        __atomic_store_n(sqTail_, tail + 1, __ATOMIC_RELEASE);
+        ++inflight_;
+        ++pending;
+    }
+    enter(pending);
+    lock.unlock();
+
+    if (!failed.empty()) {
+        spaceCV_.notify_all();
+        // Their completions never arrive, which would block the readers forever
+        for (auto op : failed) {
+            Complete(op, -1);
+        }
+    }
+}
+
+void IoUringBackend::Reap() {
+    for (;;) {
+        unsigned head = *cqHead_;
+        unsigned tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+        if (head == tail) {
+            syscall(__NR_io_uring_enter, ringFd_, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+            continue;
+        }
+
+        // The ops were queued under the lock, which makes them visible here
+        { std::lock_guard<std::mutex> lock(submitLock_); }
+
+        size_t reaped = 0;
+        bool stop     = false;
+        for (; head != tail; ++head) {
+            const io_uring_cqe& cqe = cqes_[head & *cqMask_];
+            if (cqe.user_data == 0) {
+                stop = true;
+                continue;
+            }
+            Complete(reinterpret_cast<Op*>(cqe.user_data), cqe.res);
+            ++reaped;
+        }
+        __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+
+        if (reaped > 0) {
+            std::lock_guard<std::mutex> lock(submitLock_);
+            inflight_ -= reaped;
+        }
+        spaceCV_.notify_all();
+
+        if (stop) {
+            return;
+        }
+    }
+}
+
+void IoUringBackend::Complete(Op* op, int res) {
+    size_t done = res > 0 ? res : 0;
+    if (done < op->iov.iov_len) {
+        // Finish errors and short transfers synchronously
+        char* buf    = static_cast<char*>(op->iov.iov_base) + done;
+        size_t rest  = op->iov.iov_len - done;
+        uint64_t off = op->offset + done;
+        if (!(op->write ? PwriteFully(op->fd, buf, rest, off) : PreadFully(op->fd, buf, rest, off))) {
+            op->batch->ok = false;
+        }
+    }
+
+    Batch* batch = op->batch;
+    if (--batch->remaining == 0) {
+        batch->done(*batch);
+        delete batch;
+    }
+}
+
+std::optional<VStream> IoUringBackend::Read(const std::vector<ReadRange>& ranges) {
+    std::promise<std::optional<VStream>> promise;
+    auto future = promise.get_future();
+    SubmitRead(ranges, nullptr, [&promise](std::optional<VStream> result) { promise.set_value(std::move(result)); });
+    return future.get();
+}
+
+void IoUringBackend::AsyncRead(std::vector<ReadRange> ranges, ThreadPool& pool, ReadCallback callback) {
+    SubmitRead(ranges, &pool, std::move(callback));
+}
+
+void IoUringBackend::SubmitRead(const std::vector<ReadRange>& ranges, ThreadPool* target, ReadCallback callback) {
+    auto batch = new Batch();
+    batch->buffer.resize(TotalSize(ranges));
+    batch->ops.reserve(ranges.size());
+
+    size_t pos = 0;
+    for (const auto& r : ranges) {
+        int fd = batch->fds.Get(r.path, O_RDONLY);
+        if (fd < 0) {
+            batch->ok = false;
+            batch->ops.clear();
+            break;
+        }
+        batch->ops.push_back({batch, false, fd, r.offset, {batch->buffer.data() + pos, r.size}});
+        pos += r.size;
+    }
+
+    batch->done = [target, callback = std::move(callback)](Batch& b) {
+        std::optional<VStream> result;
+        if (b.ok) {
+            result = std::move(b.buffer);
+        } else {
+            spdlog::error("Failed to read a batch of {} ranges", b.ops.size());
+        }
+
+        if (target) {
+            target->Execute([callback, result = std::move(result)]() mutable { callback(std::move(result)); });
+        } else {
+            callback(std::move(result));
+        }
+    };
+
+    Submit(batch);
+}
+
+bool IoUringBackend::Write(const std::string& path, uint64_t offset, const char* data, size_t size) {
+    std::promise<bool> promise;
+    auto future = promise.get_future();
+
+    auto batch = new Batch();
+    int fd     = batch->fds.Get(path, O_WRONLY | O_CREAT);
+    if (fd >= 0) {
+        batch->ops.push_back({batch, true, fd, offset, {const_cast<char*>(data), size}});
+    } else {
+        batch->ok = false;
+    }
+    batch->done = [&promise](Batch& b) { promise.set_value(b.ok); };
+
+    Submit(batch);
+
+    if (!future.get()) {
+        spdlog::error("Failed to write {} bytes at {} of {}", size, offset, path);
+        return false;
+    }
+    return true;
+}
+
+#endif // HAVE_IO_URING
+
+std::unique_ptr<IOBackend> CreateIOBackend(bool preferIoUring) {
+#ifdef HAVE_IO_URING
+    if (preferIoUring) {
+        static constexpr unsigned entries = 256;
+        auto backend                      = IoUringBackend::Create(entries);
+        if (backend) {
+            return backend;
+        }
+        spdlog::info("Falling back to pread for file I/O");
+    }
+#endif
+    return std::make_unique<PreadBackend>();
+}
@@ -0,0 +1,77 @@
+// Copyright (c) 2019 EPI-ONE Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef EPIC_IO_BACKEND_H
+#define EPIC_IO_BACKEND_H
+
+#include "stream.h"
+#include "threadpool.h"
+
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+/**
+ * A contiguous range of a file
+ */
+struct ReadRange {
+    std::string path;
+    uint64_t offset;
+    uint32_t size;
+};
+
+/**
+ * Positional file I/O used for the BLK and VTX files.
+ * Implementations must be thread-safe.
+ */
+class IOBackend {
+public:
+    using ReadCallback = std::function<void(std::optional<VStream>)>;
+
+    virtual ~IOBackend() = default;
+
+    virtual std::string GetName() const = 0;
+
+    /**
+     * Reads all of the ranges in one batch and concatenates them
+     * in order. Returns nullopt if any of them can't be read in full
+     */
+    virtual std::optional<VStream> Read(const std::vector<ReadRange>&) = 0;
+
+    /**
+     * Same as Read, but returns at once and executes the
+     * callback on the given pool when the batch completes
+     */
+    virtual void AsyncRead(std::vector<ReadRange>, ThreadPool&, ReadCallback) = 0;
+
+    /**
+     * Writes data to the file at offset. The file is created
+     * if it doesn't exist, but its directory has to
+     */
+    virtual bool Write(const std::string& path, uint64_t offset, const char* data, size_t size) = 0;
+};
+
+/**
+ * Blocking pread/pwrite on the calling thread
+ */
+class PreadBackend : public IOBackend {
+public:
+    std::string GetName() const override {
+        return "pread";
+    }
+
+    std::optional<VStream> Read(const std::vector<ReadRange>&) override;
+    void AsyncRead(std::vector<ReadRange>, ThreadPool&, ReadCallback) override;
+    bool Write(const std::string& path, uint64_t offset, const char* data, size_t size) override;
+};
+
+/**
+ * Returns an io_uring backend if it is compiled in and the kernel
+ * supports it, and a PreadBackend otherwise
+ */
+std::unique_ptr<IOBackend> CreateIOBackend(bool preferIoUring = true);
+
+#endif // EPIC_IO_BACKEND_H
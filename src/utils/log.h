@@ -0,0 +1,30 @@
+// Copyright (c) 2019 EPI-ONE Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef EPIC_LOG_H
+#define EPIC_LOG_H
+
+#include "spdlog/spdlog.h"
+
+/**
+ * Logging through the default logger which evaluates the arguments only if
+ * the level is enabled, so that hot paths don't pay for building strings of
+ * hashes or blocks which are filtered out anyway. Unlike the spdlog functions,
+ * the arguments must not have side effects.
+ */
+#define EPIC_LOG(level, ...)                               \
+    do {                                                   \
+        auto* epic_logger_ = spdlog::default_logger_raw(); \
+        if (epic_logger_->should_log(level)) {             \
+            epic_logger_->log(level, __VA_ARGS__);         \
+        }                                                  \
+    } while (false)
+
+#define LOG_TRACE(...) EPIC_LOG(spdlog::level::trace, __VA_ARGS__)
+#define LOG_DEBUG(...) EPIC_LOG(spdlog::level::debug, __VA_ARGS__)
+#define LOG_INFO(...) EPIC_LOG(spdlog::level::info, __VA_ARGS__)
+#define LOG_WARN(...) EPIC_LOG(spdlog::level::warn, __VA_ARGS__)
+#define LOG_ERROR(...) EPIC_LOG(spdlog::level::err, __VA_ARGS__)
+
+#endif // EPIC_LOG_H
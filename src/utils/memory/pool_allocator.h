@@ -0,0 +1,112 @@
+// Copyright (c) 2019 EPI-ONE Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef EPIC_POOL_ALLOCATOR_H
+#define EPIC_POOL_ALLOCATOR_H
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+/**
+ * A pool of fixed-size slots carved out of large chunks. Freed slots are
+ * recycled through a free list instead of being returned to the heap, so
+ * that many small objects of the same size live packed in a few chunks.
+ * The pool of each size is never destroyed, as objects allocated from it
+ * may outlive static destructors.
+ */
+template <size_t Size, size_t Align>
+class FixedPool {
+public:
+    static FixedPool& Instance() {
+        static FixedPool* pool = new FixedPool();
+        return *pool;
+    }
+
+    void* Allocate() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (free_) {
+            auto slot = free_;
+            free_     = free_->next;
+            return slot;
+        }
+
+        if (used_ == SLOTS_PER_CHUNK) {
+            chunks_.emplace_back(new Slot[SLOTS_PER_CHUNK]);
+            used_ = 0;
+        }
+        return &chunks_.back()[used_++];
+    }
+
+    void Deallocate(void* p) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto slot  = static_cast<Slot*>(p);
+        slot->next = free_;
+        free_      = slot;
+    }
+
+    /** Returns the bytes reserved by the chunks */
+    size_t Capacity() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return chunks_.size() * SLOTS_PER_CHUNK * sizeof(Slot);
+    }
+
+private:
+    static constexpr size_t SLOTS_PER_CHUNK = 4096;
+
+    union alignas(std::max(Align, alignof(void*))) Slot {
+        Slot* next;
+        std::byte data[Size];
+    };
+
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<Slot[]>> chunks_;
+    Slot* free_  = nullptr;
+    size_t used_ = SLOTS_PER_CHUNK;
+
+    FixedPool() = default;
+};
+
+/**
+ * Allocator taking single objects from the FixedPool of their size,
+ * e.g., for std::allocate_shared, and arrays from the heap
+ */
+template <typename T>
+struct pool_allocator {
+    typedef T value_type;
+
+    pool_allocator() noexcept {}
+    template <typename U>
+    pool_allocator(const pool_allocator<U>&) noexcept {}
+
+    T* allocate(std::size_t n) {
+        if (n == 1) {
+            return static_cast<T*>(FixedPool<sizeof(T), alignof(T)>::Instance().Allocate());
+        }
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T* p, std::size_t n) {
+        if (n == 1) {
+            FixedPool<sizeof(T), alignof(T)>::Instance().Deallocate(p);
+            return;
+        }
+        std::allocator<T>().deallocate(p, n);
+    }
+
+    template <typename U>
+    friend bool operator==(const pool_allocator&, const pool_allocator<U>&) {
+        return true;
+    }
+
+    template <typename U>
+    friend bool operator!=(const pool_allocator&, const pool_allocator<U>&) {
+        return false;
+    }
+};
+
+#endif // EPIC_POOL_ALLOCATOR_H
@@ -0,0 +1,149 @@
+// Copyright (c) 2019 EPI-ONE Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef EPIC_MPMC_QUEUE_H
+#define EPIC_MPMC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+/**
+ * Bounded lock-free multi-producer multi-consumer queue on a ring buffer
+ * (D. Vyukov). Every cell carries a sequence number telling whether it
+ * is ready to be written or read in the current lap, so producers and
+ * consumers only contend on their own position counter.
+ */
+template <typename T>
+class MPMCQueue {
+public:
+    /**
+     * @param capacity rounded up to a power of 2
+     */
+    explicit MPMCQueue(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        mask_   = size - 1;
+        buffer_ = std::make_unique<Cell[]>(size);
+        for (size_t i = 0; i < size; ++i) {
+            buffer_[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MPMCQueue(const MPMCQueue&) = delete;
+    MPMCQueue& operator=(const MPMCQueue&) = delete;
+
+    /**
+     * moves the element into the queue
+     * @return false if the queue is full, in which case the element is untouched
+     */
+    bool TryPush(T&& element) {
+        Cell* cell;
+        size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+        while (true) {
+            cell         = &buffer_[pos & mask_];
+            size_t seq   = cell->seq.load(std::memory_order_acquire);
+            intptr_t dif = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (dif == 0) {
+                if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (dif < 0) {
+                return false;
+            } else {
+                pos = enqueuePos_.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->data = std::move(element);
+        cell->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * moves the oldest element out of the queue
+     * @return false if the queue is empty
+     */
+    bool TryPop(T& element) {
+        Cell* cell;
+        size_t pos = dequeuePos_.load(std::memory_order_relaxed);
+        while (true) {
+            cell         = &buffer_[pos & mask_];
+            size_t seq   = cell->seq.load(std::memory_order_acquire);
+            intptr_t dif = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (dif == 0) {
+                if (dequeuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (dif < 0) {
+                return false;
+            } else {
+                pos = dequeuePos_.load(std::memory_order_relaxed);
+            }
+        }
+
+        element = std::move(cell->data);
+        cell->seq.store(pos + mask_ + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * whether the oldest element is not yet published, i.e. TryPop would fail
+     */
+    bool Empty() const {
+        size_t pos = dequeuePos_.load(std::memory_order_seq_cst);
+        return buffer_[pos & mask_].seq.load(std::memory_order_seq_cst) != pos + 1;
+    }
+
+    /**
+     * whether the next cell is not yet free, i.e. TryPush would fail
+     */
+    bool Full() const {
+        size_t pos = enqueuePos_.load(std::memory_order_seq_cst);
+        auto dif   = static_cast<intptr_t>(buffer_[pos & mask_].seq.load(std::memory_order_seq_cst)) -
+                   static_cast<intptr_t>(pos);
+        return dif < 0;
+    }
+
+    /**
+     * number of the elements, which is only a snapshot
+     * when the queue is used concurrently
+     */
+    size_t Size() const {
+        size_t head = dequeuePos_.load(std::memory_order_relaxed);
+        size_t tail = enqueuePos_.load(std::memory_order_relaxed);
+        return tail > head ? tail - head : 0;
+    }
+
+    size_t Capacity() const {
+        return mask_ + 1;
+    }
+
+    /**
+     * the oldest element, or nullptr if there is none. It is only
+     * valid until the element is popped by another thread
+     */
+    T* Front() {
+        size_t pos = dequeuePos_.load(std::memory_order_acquire);
+        Cell& cell = buffer_[pos & mask_];
+        return cell.seq.load(std::memory_order_acquire) == pos + 1 ? &cell.data : nullptr;
+    }
+
+private:
+    struct Cell {
+        std::atomic_size_t seq;
+        T data;
+    };
+
+    // the counters are kept on separate cache lines from each other and the buffer
+    alignas(64) std::atomic_size_t enqueuePos_ = 0;
+    alignas(64) std::atomic_size_t dequeuePos_ = 0;
+    alignas(64) std::unique_ptr<Cell[]> buffer_;
+    size_t mask_;
+};
+
+#endif // EPIC_MPMC_QUEUE_H
@@ -6,66 +6,117 @@
 #define EPIC_SCHEDULER_H
 
 #include "spdlog/spdlog.h"
+#include "threadpool.h"
+#include "timer_wheel.h"
 
+#include <atomic>
 #include <chrono>
 #include <functional>
-#include <thread>
+#include <mutex>
 #include <vector>
 
-class PeriodTask {
+/**
+ * A group of periodic tasks, which are started and stopped together. The
+ * TimerWheel only dispatches them to the thread of the scheduler, so that a
+ * long task neither delays the other timers of the process nor piles up
+ * behind itself: a task is skipped while its previous run is still queued.
+ */
+class Scheduler {
 public:
-    PeriodTask(uint32_t interval, std::function<void()>&& f) : interval_(interval), f_(std::move(f)) {
-        next_ = std::chrono::steady_clock::now() + std::chrono::seconds(interval_);
-    }
+    explicit Scheduler(TimerWheel& wheel = TimerWheel::Get()) : wheel_(wheel), pool_(1) {}
 
-    void Run() {
-        auto now = std::chrono::steady_clock::now();
-        if (now >= next_) {
-            next_ = std::chrono::steady_clock::now() + std::chrono::seconds(interval_);
-            f_();
-        }
+    ~Scheduler() {
+        Stop();
     }
 
-private:
-    uint32_t interval_;
-    std::chrono::time_point<std::chrono::steady_clock> next_;
-    std::function<void()> f_;
-};
-
-class Scheduler {
-public:
     void Start() {
-        thread_ = std::thread(std::bind(&Scheduler::Loop, this));
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (started_) {
+            return;
+        }
+
+        started_ = true;
+        pool_.Start();
+        for (auto& task : period_tasks_) {
+            Register(task);
+        }
     }
 
+    /**
+     * cancels the tasks, none of which is running after this returns
+     */
     void Stop() {
-        interrupt_ = true;
-        if (thread_.joinable()) {
-            thread_.join();
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!started_) {
+            return;
+        }
+
+        started_ = false;
+        for (auto& task : period_tasks_) {
+            if (task.id) {
+                wheel_.Cancel(task.id);
+                task.id = 0;
+            }
         }
+        pool_.Stop();
     }
 
+    /**
+     * @param interval in seconds
+     */
     void AddPeriodTask(uint32_t interval, std::function<void()>&& f) {
-        period_tasks_.emplace_back(interval, std::move(f));
+        std::lock_guard<std::mutex> lock(mutex_);
+        period_tasks_.push_back({interval, std::make_shared<Job>(std::move(f)), 0});
+        if (started_) {
+            Register(period_tasks_.back());
+        }
     }
 
 private:
-    void Loop() {
-        while (!interrupt_) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
-            for (auto& t : period_tasks_) {
-                t.Run();
-            }
+    struct Job {
+        explicit Job(std::function<void()>&& _f) : f(std::move(_f)) {}
+
+        std::function<void()> f;
+        std::atomic_bool queued = false;
+    };
+
+    struct PeriodTask {
+        uint32_t interval;
+        std::shared_ptr<Job> job;
+        TimerWheel::TimerId id;
+    };
+
+    TimerWheel& wheel_;
+    ThreadPool pool_;
+    std::mutex mutex_;
+    std::vector<PeriodTask> period_tasks_;
+    bool started_ = false;
+
+    void Register(PeriodTask& task) {
+        if (task.id) {
+            return;
         }
+
+        // the timers are cancelled before the pool is stopped, so the pool outlives the callbacks
+        task.id = wheel_.AddPeriodTimer(std::chrono::seconds(task.interval), [this, job = task.job]() {
+            if (!job->queued.exchange(true)) {
+                pool_.Execute([job]() {
+                    job->queued = false;
+                    job->f();
+                });
+            }
+        });
     }
-    std::vector<PeriodTask> period_tasks_;
-    std::thread thread_;
-    std::atomic_bool interrupt_ = false;
 };
 
+/**
+ * Executes the function once the duration in seconds has passed since the last Reset,
+ * on the thread of the wheel
+ */
 class Timer {
 public:
-    Timer(uint32_t _duration, std::function<void()>&& f) : duration_(_duration), f_(std::move(f)), stop_(true) {
+    Timer(uint32_t _duration, std::function<void()>&& f, TimerWheel& wheel = TimerWheel::Get())
+        : duration_(_duration), f_(std::move(f)), wheel_(wheel) {
         if (duration_ == 0) {
             spdlog::trace("Created a time of invalid duration");
         }
@@ -80,27 +131,21 @@ public:
         }
 
         Stop();
-        stop_   = false;
-        thread_ = std::thread{[&, end = std::chrono::steady_clock::now() + std::chrono::seconds{duration_}]() {
-            while (!stop_ && std::chrono::steady_clock::now() < end) {
-                std::this_thread::sleep_for(std::chrono::milliseconds{500});
-            }
-            f_();
-        }};
+        id_ = wheel_.AddTimer(std::chrono::seconds(duration_), [this]() { f_(); });
     }
 
     void Stop() {
-        if (thread_.joinable()) {
-            stop_ = true;
-            thread_.join();
+        auto id = id_.exchange(0);
+        if (id) {
+            wheel_.Cancel(id);
         }
     }
 
 private:
     uint32_t duration_;
     std::function<void()> f_;
-    std::atomic_bool stop_;
-    std::thread thread_;
+    TimerWheel& wheel_;
+    std::atomic<TimerWheel::TimerId> id_ = 0;
 };
 
 #endif // EPIC_SCHEDULER_H
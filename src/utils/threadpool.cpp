@@ -14,7 +14,8 @@ void CallableWrapper::operator()() {
     impl->Call();
 }
 
-ThreadPool::ThreadPool(size_t worker_size) : size_(worker_size), working_states(worker_size) {
+ThreadPool::ThreadPool(size_t worker_size, size_t capacity)
+    : size_(worker_size), task_queue_(capacity), working_states(worker_size) {
     workers_.reserve(size_);
 }
 
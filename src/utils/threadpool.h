@@ -49,7 +49,10 @@ private:
 
 class ThreadPool {
 public:
-    explicit ThreadPool(size_t worker_size);
+    /**
+     * @param capacity of the task queue, beyond which Execute blocks
+     */
+    explicit ThreadPool(size_t worker_size, size_t capacity = DEFAULT_CAPACITY);
 
     ThreadPool()  = delete;
     ~ThreadPool() = default;
@@ -0,0 +1,230 @@
+// Copyright (c) 2019 EPI-ONE Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "timer_wheel.h"
+
+TimerWheel::TimerWheel(Duration tick, bool manual)
+    : tick_(std::max(tick, Duration(1))), start_(Clock::now()), manual_(manual) {
+    if (!manual_) {
+        thread_ = std::thread(&TimerWheel::Loop, this);
+    }
+}
+
+TimerWheel::~TimerWheel() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        interrupt_ = true;
+    }
+    cv_.notify_one();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+TimerWheel& TimerWheel::Get() {
+    static auto* wheel = new TimerWheel();
+    return *wheel;
+}
+
+TimerWheel::TimerId TimerWheel::AddTimer(Duration delay, Callback&& callback) {
+    return Add((delay.count() + tick_.count() - 1) / tick_.count(), 0, std::move(callback));
+}
+
+TimerWheel::TimerId TimerWheel::AddPeriodTimer(Duration interval, Callback&& callback) {
+    uint64_t ticks = (interval.count() + tick_.count() - 1) / tick_.count();
+    return Add(ticks, std::max<uint64_t>(ticks, 1), std::move(callback));
+}
+
+TimerWheel::TimerId TimerWheel::Add(uint64_t delay, uint64_t interval, Callback&& callback) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto id     = nextId_++;
+    auto expiry = std::max(GetNowTick(), current_) + std::max<uint64_t>(delay, 1);
+    timers_.emplace(id, Timer{expiry, interval, std::make_shared<Callback>(std::move(callback))});
+
+    bool earliest = expiry < GetNextEventTick();
+    Insert(id, expiry);
+    lock.unlock();
+
+    if (earliest) {
+        cv_.notify_one();
+    }
+    return id;
+}
+
+bool TimerWheel::Cancel(TimerId id) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    bool cancelled = timers_.erase(id);
+    if (std::this_thread::get_id() != runner_) {
+        doneCv_.wait(lock, [&] { return running_ != id; });
+    }
+    return cancelled;
+}
+
+size_t TimerWheel::Size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return timers_.size();
+}
+
+uint64_t TimerWheel::GetTick() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return GetNowTick();
+}
+
+void TimerWheel::AdvanceBy(Duration duration) {
+    if (!manual_) {
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto target = manualNow_ + duration / tick_;
+    runner_     = std::this_thread::get_id();
+
+    // stops at every event, so that a periodic timer fires once per interval
+    // and the callbacks see the time at which they expire
+    std::vector<TimerId> expired;
+    for (auto next = GetNextEventTick(); next <= target; next = GetNextEventTick()) {
+        manualNow_ = std::max(manualNow_, next);
+        expired.clear();
+        Advance(manualNow_, expired);
+        Execute(lock, expired);
+    }
+
+    manualNow_ = target;
+    current_   = std::max(current_, target);
+    runner_    = std::thread::id();
+}
+
+uint64_t TimerWheel::GetNowTick() const {
+    if (manual_) {
+        return manualNow_;
+    }
+    return (Clock::now() - start_) / tick_;
+}
+
+void TimerWheel::Insert(TimerId id, uint64_t expiry) {
+    // the level is the one of the highest bit in which the expiry differs from the current tick,
+    // so its digit on the level is greater than the one of the current tick
+    auto level = (63 - __builtin_clzll(expiry ^ current_)) / kSlotBits;
+    auto slot  = (expiry >> (level * kSlotBits)) & (kSlots - 1);
+    wheel_[level][slot].push_back({id, expiry});
+    occupied_[level] |= uint64_t(1) << slot;
+}
+
+uint64_t TimerWheel::GetNextEventTick() const {
+    uint64_t next = UINT64_MAX;
+    for (size_t level = 0; level < kLevels; ++level) {
+        if (!occupied_[level]) {
+            continue;
+        }
+
+        // a slot is processed when the time reaches its start
+        size_t shift  = (level + 1) * kSlotBits;
+        uint64_t base = shift < 64 ? (current_ >> shift) << shift : 0;
+        uint64_t slot = __builtin_ctzll(occupied_[level]);
+        next          = std::min(next, base | (slot << (level * kSlotBits)));
+    }
+    return next;
+}
+
+void TimerWheel::Advance(uint64_t tick, std::vector<TimerId>& expired) {
+    auto isValid = [this](const Entry& entry) {
+        auto it = timers_.find(entry.id);
+        return it != timers_.end() && it->second.expiry == entry.expiry;
+    };
+
+    for (uint64_t next = GetNextEventTick(); next <= tick; next = GetNextEventTick()) {
+        current_ = next;
+
+        // cascade the slots of the higher levels starting at this tick
+        for (size_t level = kLevels - 1; level > 0; --level) {
+            uint64_t mask = (uint64_t(1) << (level * kSlotBits)) - 1;
+            auto slot     = (current_ >> (level * kSlotBits)) & (kSlots - 1);
+            if ((current_ & mask) || !(occupied_[level] & (uint64_t(1) << slot))) {
+                continue;
+            }
+
+            auto entries = std::move(wheel_[level][slot]);
+            wheel_[level][slot].clear();
+            occupied_[level] &= ~(uint64_t(1) << slot);
+            for (const auto& entry : entries) {
+                if (!isValid(entry)) {
+                    continue;
+                }
+                if (entry.expiry <= current_) {
+                    expired.push_back(entry.id);
+                } else {
+                    Insert(entry.id, entry.expiry);
+                }
+            }
+        }
+
+        auto slot = current_ & (kSlots - 1);
+        if (occupied_[0] & (uint64_t(1) << slot)) {
+            for (const auto& entry : wheel_[0][slot]) {
+                if (isValid(entry)) {
+                    expired.push_back(entry.id);
+                }
+            }
+            wheel_[0][slot].clear();
+            occupied_[0] &= ~(uint64_t(1) << slot);
+        }
+    }
+
+    current_ = std::max(current_, tick);
+}
+
+void TimerWheel::Execute(std::unique_lock<std::mutex>& lock, const std::vector<TimerId>& expired) {
+    for (auto id : expired) {
+        auto it = timers_.find(id);
+        if (it == timers_.end()) {
+            continue;
+        }
+
+        auto callback = it->second.callback;
+        bool periodic = it->second.interval > 0;
+        if (!periodic) {
+            timers_.erase(it);
+        }
+
+        running_ = id;
+        lock.unlock();
+        (*callback)();
+        lock.lock();
+        running_ = 0;
+        doneCv_.notify_all();
+
+        // a periodic timer keeps its phase unless it has fallen behind by a whole interval
+        it = timers_.find(id);
+        if (periodic && it != timers_.end()) {
+            auto& timer = it->second;
+            timer.expiry += timer.interval;
+            if (timer.expiry <= current_) {
+                timer.expiry = current_ + timer.interval;
+            }
+            Insert(id, timer.expiry);
+        }
+    }
+}
+
+void TimerWheel::Loop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    runner_ = std::this_thread::get_id();
+    std::vector<TimerId> expired;
+    while (!interrupt_) {
+        expired.clear();
+        Advance(GetNowTick(), expired);
+        Execute(lock, expired);
+
+        if (!expired.empty() || interrupt_) {
+            continue;
+        }
+
+        auto next = GetNextEventTick();
+        if (next == UINT64_MAX) {
+            cv_.wait(lock);
+        } else {
+            cv_.wait_until(lock, start_ + tick_ * next);
+        }
+    }
+}
@@ -0,0 +1,146 @@
+// Copyright (c) 2019 EPI-ONE Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef EPIC_TIMER_WHEEL_H
+#define EPIC_TIMER_WHEEL_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Hierarchical timing wheel (Varghese & Lauck) running one-shot and periodic
+ * timers on a single thread. Every level has 64 slots, each spanning 64 slots
+ * of the level below, and a bitmap of the non-empty ones, so that adding and
+ * cancelling are O(1) and the thread sleeps until the next expiry instead of
+ * polling. A timer is moved down a level when the time reaches its slot.
+ *
+ * Callbacks are executed on the thread of the wheel and should be short,
+ * dispatching longer work to a ThreadPool.
+ */
+class TimerWheel {
+public:
+    using Clock    = std::chrono::steady_clock;
+    using Duration = std::chrono::microseconds;
+    using TimerId  = uint64_t;
+    using Callback = std::function<void()>;
+
+    /**
+     * @param tick resolution of the timers
+     * @param manual if true, no thread is started and the time of the wheel only
+     * moves by AdvanceBy, e.g., in tests and simulations
+     */
+    explicit TimerWheel(Duration tick = std::chrono::milliseconds(1), bool manual = false);
+    ~TimerWheel();
+
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    /**
+     * executes the callback once after the delay
+     */
+    TimerId AddTimer(Duration delay, Callback&& callback);
+
+    /**
+     * executes the callback every interval, the first time after an interval
+     */
+    TimerId AddPeriodTimer(Duration interval, Callback&& callback);
+
+    /**
+     * Cancels the timer. If its callback is being executed on the thread of the
+     * wheel, waits for it to finish unless called from the callback itself, so
+     * that the callback never runs after this returns.
+     * @return false if the timer has already expired or been cancelled
+     */
+    bool Cancel(TimerId id);
+
+    size_t Size() const;
+
+    /**
+     * the number of ticks elapsed since the wheel was created
+     */
+    uint64_t GetTick() const;
+
+    /**
+     * Moves the time of a manual wheel forward by whole ticks, executing the
+     * timers expiring meanwhile in order on the calling thread
+     */
+    void AdvanceBy(Duration duration);
+
+    /**
+     * the wheel shared by the whole process, with a resolution of 1ms.
+     * It is never destroyed, so that timers can be cancelled at exit
+     */
+    static TimerWheel& Get();
+
+private:
+    constexpr static size_t kSlotBits = 6;
+    constexpr static size_t kSlots    = 1 << kSlotBits;
+    constexpr static size_t kLevels   = (64 + kSlotBits - 1) / kSlotBits;
+
+    struct Timer {
+        uint64_t expiry;
+        uint64_t interval;
+        std::shared_ptr<Callback> callback;
+    };
+
+    struct Entry {
+        TimerId id;
+        uint64_t expiry;
+    };
+
+    const Duration tick_;
+    const Clock::time_point start_;
+    const bool manual_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::condition_variable doneCv_;
+
+    std::array<std::array<std::vector<Entry>, kSlots>, kLevels> wheel_;
+    std::array<uint64_t, kLevels> occupied_{};
+    std::unordered_map<TimerId, Timer> timers_;
+
+    // the tick up to which the wheel has been processed
+    uint64_t current_   = 0;
+    uint64_t manualNow_ = 0;
+    TimerId nextId_     = 1;
+    TimerId running_    = 0;
+    bool interrupt_     = false;
+    std::thread thread_;
+    // the thread executing the callbacks
+    std::thread::id runner_;
+
+    uint64_t GetNowTick() const;
+
+    TimerId Add(uint64_t delay, uint64_t interval, Callback&& callback);
+
+    void Insert(TimerId id, uint64_t expiry);
+
+    /**
+     * the next tick at which a slot has to be processed, or UINT64_MAX if there is none
+     */
+    uint64_t GetNextEventTick() const;
+
+    /**
+     * processes all slots up to the tick and collects the expired timers
+     */
+    void Advance(uint64_t tick, std::vector<TimerId>& expired);
+
+    /**
+     * executes the expired timers with the lock released and reschedules the periodic ones
+     */
+    void Execute(std::unique_lock<std::mutex>& lock, const std::vector<TimerId>& expired);
+
+    void Loop();
+};
+
+#endif // EPIC_TIMER_WHEEL_H
@@ -0,0 +1,172 @@
+// Copyright (c) 2019 EPI-ONE Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "tracing.h"
+#include "spdlog/spdlog.h"
+
+#include <algorithm>
+
+#ifdef __linux__
+#include <pthread.h>
+#endif
+
+std::atomic_bool Tracer::enabled_              = false;
+const Tracer::Clock::time_point Tracer::epoch_ = Tracer::Clock::now();
+std::mutex Tracer::buffersMutex_;
+std::vector<std::shared_ptr<Tracer::Buffer>> Tracer::buffers_;
+std::atomic_uint32_t Tracer::nextTid_ = 1;
+
+/**
+ * Appends a string to a JSON string literal, escaping
+ * the quotes, backslashes and control characters
+ */
+static void EscapeJson(fmt::memory_buffer& json, const std::string_view& str) {
+    for (char c : str) {
+        switch (c) {
+            case '"':
+                fmt::format_to(json, "\\\"");
+                break;
+            case '\\':
+                fmt::format_to(json, "\\\\");
+                break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    fmt::format_to(json, "\\u{:04x}", static_cast<unsigned char>(c));
+                } else {
+                    json.push_back(c);
+                }
+        }
+    }
+}
+
+Tracer::Buffer& Tracer::GetBuffer() {
+    thread_local std::shared_ptr<Buffer> buffer = [] {
+        auto b = std::make_shared<Buffer>();
+        b->events.resize(kBufferSize);
+        b->tid = nextTid_++;
+#ifdef __linux__
+        char name[16] = {};
+        if (pthread_getname_np(pthread_self(), name, sizeof(name)) == 0) {
+            b->threadName = name;
+        }
+#endif
+        std::lock_guard<std::mutex> lock(buffersMutex_);
+        buffers_.push_back(b);
+        return b;
+    }();
+    return *buffer;
+}
+
+void Tracer::Add(Event&& event) {
+    auto& buffer = GetBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    buffer.events[buffer.next % kBufferSize] = std::move(event);
+    ++buffer.next;
+}
+
+void Tracer::Complete(const char* name, Clock::time_point start, const uint256& block, const uint256& milestone) {
+    auto now = Clock::now();
+    Add({name, static_cast<uint64_t>((start - epoch_).count()), static_cast<uint64_t>((now - start).count()), block,
+         milestone, 'X'});
+}
+
+void Tracer::AsyncBegin(const char* name, const uint256& block) {
+    Add({name, static_cast<uint64_t>((Clock::now() - epoch_).count()), 0, block, uint256{}, 'b'});
+}
+
+void Tracer::AsyncEnd(const char* name, const uint256& block) {
+    Add({name, static_cast<uint64_t>((Clock::now() - epoch_).count()), 0, block, uint256{}, 'e'});
+}
+
+std::string Tracer::ExportJson() {
+    std::string result;
+    ExportJson([&](std::string&& chunk) {
+        result += chunk;
+        return true;
+    });
+    return result;
+}
+
+bool Tracer::ExportJson(const std::function<bool(std::string&&)>& writer) {
+    std::vector<std::shared_ptr<Buffer>> buffers;
+    {
+        std::lock_guard<std::mutex> lock(buffersMutex_);
+        buffers = buffers_;
+    }
+
+    fmt::memory_buffer json;
+    auto flush = [&]() {
+        bool written = writer(fmt::to_string(json));
+        json.clear();
+        return written;
+    };
+
+    fmt::format_to(json, "{{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    const char* separator = "";
+    std::vector<Event> events;
+    for (const auto& buffer : buffers) {
+        // copied from the oldest event in the ring, so that the thread isn't blocked while the events are written
+        events.clear();
+        {
+            std::lock_guard<std::mutex> lock(buffer->mutex);
+            size_t begin = buffer->next > kBufferSize ? buffer->next - kBufferSize : 0;
+            for (size_t i = begin; i < buffer->next; ++i) {
+                events.push_back(buffer->events[i % kBufferSize]);
+            }
+        }
+
+        if (!buffer->threadName.empty()) {
+            fmt::format_to(json,
+                           "{}{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":{},"
+                           "\"args\":{{\"name\":\"",
+                           separator, buffer->tid);
+            EscapeJson(json, buffer->threadName);
+            fmt::format_to(json, "\"}}}}");
+            separator = ",";
+        }
+
+        // with timestamps in microseconds
+        for (const auto& e : events) {
+            fmt::format_to(json, "{}{{\"name\":\"", separator);
+            EscapeJson(json, e.name);
+            fmt::format_to(json, "\",\"cat\":\"block\",\"ph\":\"{}\",\"pid\":1,\"tid\":{},\"ts\":{}.{:03}", e.phase,
+                           buffer->tid, e.start / 1000, e.start % 1000);
+            separator = ",";
+
+            if (e.phase == 'X') {
+                fmt::format_to(json, ",\"dur\":{}.{:03}", e.duration / 1000, e.duration % 1000);
+            } else {
+                // the begin and the end of an async event are matched by the id
+                fmt::format_to(json, ",\"id\":\"{:#x}\"", e.block.GetUint64(0));
+            }
+
+            fmt::format_to(json, ",\"args\":{{");
+            if (!e.block.IsNull()) {
+                fmt::format_to(json, "\"block\":\"{}\"", e.block.GetHex());
+            }
+            if (!e.milestone.IsNull()) {
+                fmt::format_to(json, "{}\"milestone\":\"{}\"", e.block.IsNull() ? "" : ",", e.milestone.GetHex());
+            }
+            fmt::format_to(json, "}}}}");
+
+            if (json.size() >= kChunkSize && !flush()) {
+                return false;
+            }
+        }
+    }
+    fmt::format_to(json, "]}}");
+    return flush();
+}
+
+void Tracer::Clear() {
+    std::lock_guard<std::mutex> lock(buffersMutex_);
+    for (auto& buffer : buffers_) {
+        std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+        buffer->next = 0;
+    }
+
+    // drop the buffers of the threads which have exited
+    buffers_.erase(std::remove_if(buffers_.begin(), buffers_.end(), [](const auto& b) { return b.use_count() == 1; }),
+                   buffers_.end());
+}
@@ -0,0 +1,172 @@
+// Copyright (c) 2019 EPI-ONE Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef EPIC_TRACING_H
+#define EPIC_TRACING_H
+
+#include "big_uint.h"
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * Spans of the lifecycle of blocks tagged with block and milestone hashes.
+ * Every thread records into its own ring buffer, which keeps the latest
+ * kBufferSize events, so that tracing can stay enabled in production and the
+ * recent history is exported on demand in the trace event format of Chrome,
+ * which can be loaded by chrome://tracing or Perfetto.
+ *
+ * When disabled, a span costs a relaxed load of a flag.
+ */
+class Tracer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr size_t kBufferSize = 1 << 14;
+    static constexpr size_t kChunkSize  = 1 << 20;
+
+    static void Enable(bool enabled) {
+        enabled_.store(enabled, std::memory_order_relaxed);
+    }
+
+    static bool IsEnabled() {
+        return enabled_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * records a span from start until now
+     */
+    static void Complete(const char* name, Clock::time_point start, const uint256& block, const uint256& milestone);
+
+    /**
+     * records the start and the end of an interval which may span threads,
+     * such as the time a block waits in the OBC, identified by the name and block
+     */
+    static void AsyncBegin(const char* name, const uint256& block);
+    static void AsyncEnd(const char* name, const uint256& block);
+
+    /**
+     * the events in the buffers of all threads in the JSON trace event format
+     */
+    static std::string ExportJson();
+
+    /**
+     * Passes the same JSON to the writer in consecutive pieces of about kChunkSize bytes,
+     * so that it is never built whole, e.g., to stream it over RPC.
+     * @return false if the writer has returned false, at which the export stops
+     */
+    static bool ExportJson(const std::function<bool(std::string&&)>& writer);
+
+    static void Clear();
+
+private:
+    struct Event {
+        // a string literal
+        const char* name;
+        // nanoseconds since epoch_
+        uint64_t start;
+        uint64_t duration;
+        uint256 block;
+        uint256 milestone;
+        char phase;
+    };
+
+    /**
+     * the ring of events of a thread, locked only when
+     * the thread records and when exporting
+     */
+    struct Buffer {
+        std::mutex mutex;
+        std::vector<Event> events;
+        size_t next = 0;
+        uint32_t tid;
+        std::string threadName;
+    };
+
+    static std::atomic_bool enabled_;
+    static const Clock::time_point epoch_;
+
+    // kept after their threads exit, so that their events can still be exported
+    static std::mutex buffersMutex_;
+    static std::vector<std::shared_ptr<Buffer>> buffers_;
+    static std::atomic_uint32_t nextTid_;
+
+    static Buffer& GetBuffer();
+    static void Add(Event&& event);
+};
+
+/**
+ * RAII span which records from its creation until it goes out of scope
+ */
+class TraceSpan {
+public:
+    explicit TraceSpan(const char* name, const uint256& block = {}, const uint256& milestone = {}) : name_(name) {
+        if (Tracer::IsEnabled()) {
+            enabled_   = true;
+            start_     = Tracer::Clock::now();
+            block_     = block;
+            milestone_ = milestone;
+        }
+    }
+
+    ~TraceSpan() {
+        if (enabled_) {
+            Tracer::Complete(name_, start_, block_, milestone_);
+        }
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+    /**
+     * tags the span with a block known only after it started
+     */
+    void SetBlock(const uint256& block) {
+        if (enabled_) {
+            block_ = block;
+        }
+    }
+
+    void SetMilestone(const uint256& milestone) {
+        if (enabled_) {
+            milestone_ = milestone;
+        }
+    }
+
+private:
+    const char* name_;
+    bool enabled_ = false;
+    Tracer::Clock::time_point start_;
+    uint256 block_;
+    uint256 milestone_;
+};
+
+#define EPIC_TRACE_CONCAT_(a, b) a##b
+#define EPIC_TRACE_CONCAT(a, b) EPIC_TRACE_CONCAT_(a, b)
+
+/**
+ * TRACE_SPAN(name[, block[, milestone]]) traces the rest of the scope
+ */
+#define TRACE_SPAN(...) TraceSpan EPIC_TRACE_CONCAT(traceSpan, __LINE__)(__VA_ARGS__)
+
+#define TRACE_ASYNC_BEGIN(name, block)           \
+    do {                                         \
+        if (Tracer::IsEnabled()) {               \
+            Tracer::AsyncBegin((name), (block)); \
+        }                                        \
+    } while (false)
+
+#define TRACE_ASYNC_END(name, block)           \
+    do {                                       \
+        if (Tracer::IsEnabled()) {             \
+            Tracer::AsyncEnd((name), (block)); \
+        }                                      \
+    } while (false)
+
+#endif // EPIC_TRACING_H
@@ -15,18 +15,23 @@
 #include <utility>
 #include <vector>
 
-Wallet::Wallet(std::string walletPath, uint32_t backupPeriod, uint32_t loginSession)
+Wallet::Wallet(std::string walletPath, uint32_t backupPeriod, uint32_t loginSession, uint32_t keyPoolSize)
     : threadPool_(2), verifyThread_(1), walletStore_(walletPath), backupPeriod_(backupPeriod), totalBalance_{0},
-      timer_(loginSession, [&]() {
-          rpcLoggedin_ = false;
-          spdlog::trace("[Wallet] wallet login session expired!");
-      }) {
+      timer_(loginSession,
+             [&]() {
+                 rpcLoggedin_ = false;
+                 ClearKeyCache();
+                 spdlog::trace("[Wallet] wallet login session expired!");
+             }),
+      keyPoolSize_(keyPoolSize), keyPool_(std::max<size_t>(keyPoolSize, 1)) {
     Load();
 }
 
 void Wallet::Start() {
     verifyThread_.Start();
     threadPool_.Start();
+    startFlag_ = true;
+    TopUpKeyPool();
     if (backupPeriod_) {
         SendPeriodicTasks(backupPeriod_);
     }
@@ -35,6 +40,8 @@ void Wallet::Start() {
 void Wallet::Stop() {
     spdlog::info("Stopping wallet...");
     stopFlag_ = true;
+    timer_.Stop();
+    ClearKeyCache();
     scheduler_.Stop();
     verifyThread_.Stop();
     threadPool_.Stop();
@@ -131,13 +138,16 @@ void Wallet::OnLvsConfirmed(std::vector<VertexPtr> vertices,
 
 void Wallet::ProcessUTXO(const uint256& utxokey, const UTXOPtr& utxo) {
     // keyId is a decoded address
-    auto keyId = ParseAddrFromScript(utxo->GetOutput().listingContent);
+    auto keyId = utxo->GetKeyID();
+    if (!keyId) {
+        keyId = ParseAddrFromScript(utxo->GetListing());
+    }
     if (keyId) {
         if (keyBook.find(*keyId) != keyBook.end()) {
             auto indices = utxo->GetIndices();
             unspent.insert(
-                {utxokey, std::make_tuple(*keyId, indices.first, indices.second, utxo->GetOutput().value.GetValue())});
-            totalBalance_ += utxo->GetOutput().value.GetValue();
+                {utxokey, std::make_tuple(*keyId, indices.first, indices.second, utxo->GetValue().GetValue())});
+            totalBalance_ += utxo->GetValue().GetValue();
         }
     }
 }
@@ -206,11 +216,19 @@ void Wallet::ProcessVertex(const VertexPtr& vertex) {
 }
 
 CKeyID Wallet::CreateNewKey(bool compressed) {
+    CKeyID pooled;
+    if (compressed && keyPool_.TryPop(pooled)) {
+        TopUpKeyPool();
+        return pooled;
+    }
+    TopUpKeyPool();
+
     CKey privkey{};
     privkey.MakeNewKey(compressed);
     CPubKey pubkey = privkey.GetPubKey();
     auto addr      = pubkey.GetID();
 
+    std::lock_guard<std::mutex> lock(cryptoMutex_);
     CiphertextKey ciphertext;
     crypter_.EncryptKey(master_, pubkey, privkey, ciphertext);
 
@@ -219,6 +237,76 @@ CKeyID Wallet::CreateNewKey(bool compressed) {
     return addr;
 }
 
+void Wallet::TopUpKeyPool() {
+    if (keyPoolSize_ == 0 || !startFlag_ || stopFlag_) {
+        return;
+    }
+    if ((keyPool_.Size() + keyPoolPending_) * 2 > keyPoolSize_) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(cryptoMutex_);
+        if (master_.empty() || !crypter_.IsReady()) {
+            return;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(keyPoolMutex_);
+    size_t available = keyPool_.Size() + keyPoolPending_;
+    if (available * 2 > keyPoolSize_) {
+        return;
+    }
+
+    // split the keys among the threads, each of which stores its share in one batch
+    size_t n      = keyPoolSize_ - available;
+    size_t nTasks = std::min(threadPool_.GetThreadSize(), n);
+
+    keyPoolPending_ += n;
+    for (size_t i = 0; i < nTasks; ++i) {
+        size_t share = n / nTasks + (i < n % nTasks);
+        threadPool_.Execute([this, share]() { FillKeyPool(share); });
+    }
+}
+
+void Wallet::FillKeyPool(size_t n) {
+    std::vector<CKey> privkeys(n);
+    for (size_t i = 0; i < n && !stopFlag_; ++i) {
+        privkeys[i].MakeNewKey(true);
+    }
+
+    // the keys are encrypted and added to the key book either before or after a change of passphrase,
+    // which holds the lock while re-encrypting the key book
+    std::vector<std::tuple<CKeyID, CiphertextKey, CPubKey>> keys;
+    keys.reserve(n);
+    std::unique_lock<std::mutex> lock(cryptoMutex_);
+    for (const auto& privkey : privkeys) {
+        if (stopFlag_ || !privkey.IsValid()) {
+            break;
+        }
+        CPubKey pubkey = privkey.GetPubKey();
+
+        CiphertextKey ciphertext;
+        if (!crypter_.EncryptKey(master_, pubkey, privkey, ciphertext)) {
+            break;
+        }
+        keys.emplace_back(pubkey.GetID(), std::move(ciphertext), pubkey);
+    }
+
+    if (!keys.empty() && !walletStore_.StoreKeys(keys)) {
+        spdlog::error("[Wallet] Fail to store {} keys of the key pool", keys.size());
+        keys.clear();
+    }
+    for (auto& [addr, ciphertext, pubkey] : keys) {
+        keyBook.emplace(addr, std::make_pair(std::move(ciphertext), pubkey));
+    }
+    lock.unlock();
+
+    for (const auto& key : keys) {
+        keyPool_.TryPush(CKeyID{std::get<0>(key)});
+    }
+    keyPoolPending_ -= n;
+}
+
 std::vector<CKeyID> Wallet::GetAllAddresses() {
     std::vector<CKeyID> result;
     result.reserve(keyBook.size());
@@ -261,7 +349,7 @@ TxInput Wallet::CreateSignedVin(const CKeyID& targetAddr, TxOutPoint outpoint, c
         std::cout << e.what() << " when creating signed vin\n";
     }
     CKey privkey{};
-    if (!crypter_.DecryptKey(master_, pubkey, ciphertext, privkey)) {
+    if (!GetPrivKey(targetAddr, pubkey, ciphertext, privkey)) {
         spdlog::error("[Wallet] Fail to decrypt private keys");
         return TxInput{};
     }
@@ -537,95 +625,162 @@ inline uint64_t CurrentTimeInMs() {
         .count();
 }
 
+bool Wallet::GetPrivKey(const CKeyID& addr,
+                        const CPubKey& pubkey,
+                        const CiphertextKey& ciphertext,
+                        CKey& privkey) {
+    if (!rpcLoggedin_) {
+        std::lock_guard<std::mutex> lock(cryptoMutex_);
+        return crypter_.DecryptKey(master_, pubkey, ciphertext, privkey);
+    }
+
+    {
+        READER_LOCK(keyCacheMutex_)
+        auto it = keyCache_.find(addr);
+        if (it != keyCache_.end()) {
+            privkey = it->second;
+            return true;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(cryptoMutex_);
+        if (!crypter_.DecryptKey(master_, pubkey, ciphertext, privkey)) {
+            return false;
+        }
+    }
+
+    WRITER_LOCK(keyCacheMutex_)
+    // the session may have expired while decrypting
+    if (rpcLoggedin_) {
+        keyCache_.emplace(addr, privkey);
+    }
+    return true;
+}
+
+void Wallet::ClearKeyCache() {
+    WRITER_LOCK(keyCacheMutex_)
+    keyCache_.clear();
+}
+
 bool Wallet::SetPassphrase(const SecureString& phrase) {
-    if (IsCrypted()) {
-        return false;
+    {
+        std::lock_guard<std::mutex> lock(cryptoMutex_);
+        if (IsCrypted() || !ApplyPassphrase(phrase)) {
+            return false;
+        }
     }
-    GetRDRandBytes(masterInfo_.salt.data(), masterInfo_.salt.size());
+
+    TopUpKeyPool();
+    return true;
+}
+
+bool Wallet::ApplyPassphrase(const SecureString& phrase) {
+    // derived aside, so that crypter_ is only replaced once the master is encrypted with the new key
+    Crypter crypter{};
+    MasterInfo info = masterInfo_;
+    GetRDRandBytes(info.salt.data(), info.salt.size());
 
     // get the number of rounds to cost about 0.1 second
     auto start = CurrentTimeInMs();
-    crypter_.SetKeyFromPassphrase(phrase, masterInfo_.salt, 25000);
-    masterInfo_.nDeriveIterations = static_cast<unsigned int>(25000 * 100 / (CurrentTimeInMs() - start));
+    crypter.SetKeyFromPassphrase(phrase, info.salt, 25000);
+    info.nDeriveIterations = static_cast<unsigned int>(25000 * 100 / (CurrentTimeInMs() - start));
 
     start = CurrentTimeInMs();
-    crypter_.SetKeyFromPassphrase(phrase, masterInfo_.salt, masterInfo_.nDeriveIterations);
-    masterInfo_.nDeriveIterations =
-        (static_cast<unsigned int>(masterInfo_.nDeriveIterations * 100 / (CurrentTimeInMs() - start)) +
-         masterInfo_.nDeriveIterations) /
+    crypter.SetKeyFromPassphrase(phrase, info.salt, info.nDeriveIterations);
+    info.nDeriveIterations =
+        (static_cast<unsigned int>(info.nDeriveIterations * 100 / (CurrentTimeInMs() - start)) +
+         info.nDeriveIterations) /
         2;
 
-    if (masterInfo_.nDeriveIterations < 25000) {
-        masterInfo_.nDeriveIterations = 25000;
+    if (info.nDeriveIterations < 25000) {
+        info.nDeriveIterations = 25000;
     }
 
-    if (!crypter_.SetKeyFromPassphrase(phrase, masterInfo_.salt, masterInfo_.nDeriveIterations)) {
+    if (!crypter.SetKeyFromPassphrase(phrase, info.salt, info.nDeriveIterations)) {
         return false;
     }
-    if (!crypter_.EncryptMaster(master_, masterInfo_.cryptedMaster)) {
+    if (!crypter.EncryptMaster(master_, info.cryptedMaster)) {
         return false;
     }
 
     // store master information
-    walletStore_.StoreMasterInfo(masterInfo_);
+    walletStore_.StoreMasterInfo(info);
     // TODO: set HD wallet
+    masterInfo_  = std::move(info);
+    crypter_     = std::move(crypter);
     cryptedFlag_ = true;
     return crypter_.IsReady();
 }
 
 bool Wallet::ChangePassphrase(const SecureString& oldPhrase, const SecureString& newPhrase) {
-    if (!IsCrypted()) {
-        return false;
-    }
+    {
+        // keys of the pool being filled are added either before the re-encryption or after it with the new key
+        std::lock_guard<std::mutex> lock(cryptoMutex_);
+        if (!IsCrypted()) {
+            return false;
+        }
 
-    Crypter oldCrypter{};
-    if (auto oCrypter = CheckPassphraseMatch(oldPhrase)) {
-        oldCrypter = *oCrypter;
-    } else {
-        return false;
-    }
+        Crypter oldCrypter{};
+        if (auto oCrypter = CheckPassphraseMatch(oldPhrase)) {
+            oldCrypter = *oCrypter;
+        } else {
+            return false;
+        }
 
-    cryptedFlag_ = false;
-    if (!SetPassphrase(newPhrase)) {
-        return false;
-    }
+        if (!ApplyPassphrase(newPhrase)) {
+            return false;
+        }
 
-    // change all encrypted content
-    for (auto it = keyBook.begin(); it != keyBook.end(); it++) {
-        auto value = it->second;
-        CKey priv{};
-        oldCrypter.DecryptKey(master_, value.second, value.first, priv);
-        CiphertextKey newCiphterText{};
-        crypter_.EncryptKey(master_, value.second, priv, newCiphterText);
-        value.first = newCiphterText;
-
-        if (!walletStore_.StoreKeys(it->first, value.first, value.second)) {
-            spdlog::error("[Wallet] Fail to store key with key-id {}", it->first.GetHex());
+        // change all encrypted content
+        for (auto it = keyBook.begin(); it != keyBook.end(); it++) {
+            auto value = it->second;
+            CKey priv{};
+            if (!oldCrypter.DecryptKey(master_, value.second, value.first, priv)) {
+                // keeps the ciphertext rather than overwriting it with garbage
+                spdlog::error("[Wallet] Fail to decrypt key with key-id {}", it->first.GetHex());
+                continue;
+            }
+            CiphertextKey newCiphterText{};
+            crypter_.EncryptKey(master_, value.second, priv, newCiphterText);
+            value.first = newCiphterText;
+
+            if (!walletStore_.StoreKeys(it->first, value.first, value.second)) {
+                spdlog::error("[Wallet] Fail to store key with key-id {}", it->first.GetHex());
+            }
+            std::tie(it, std::ignore) = keyBook.insert_or_assign(it->first, std::move(value));
         }
-        std::tie(it, std::ignore) = keyBook.insert_or_assign(it->first, std::move(value));
     }
 
+    TopUpKeyPool();
     return true;
 }
 
 bool Wallet::CheckPassphrase(const SecureString& phrase) {
-    if (auto oCrypter = CheckPassphraseMatch(phrase)) {
+    {
+        std::lock_guard<std::mutex> lock(cryptoMutex_);
+        auto oCrypter = CheckPassphraseMatch(phrase);
+        if (!oCrypter) {
+            return false;
+        }
         if (!master_.empty()) {
             return true;
-        } else {
-            // when there is no available master key, i.e. loading data, we do decryption to get one
-            if (!oCrypter->IsReady()) {
-                return false;
-            }
+        }
 
-            crypter_ = std::move(*oCrypter);
-            crypter_.DecryptMaster(masterInfo_.cryptedMaster, master_);
+        // when there is no available master key, i.e. loading data, we do decryption to get one
+        if (!oCrypter->IsReady()) {
+            return false;
+        }
 
-            return crypter_.IsReady();
+        crypter_ = std::move(*oCrypter);
+        crypter_.DecryptMaster(masterInfo_.cryptedMaster, master_);
+        if (!crypter_.IsReady()) {
+            return false;
         }
-    } else {
-        return false;
     }
+
+    TopUpKeyPool();
+    return true;
 }
 
 std::optional<Crypter> Wallet::CheckPassphraseMatch(const SecureString& phrase) const {
@@ -9,6 +9,7 @@
 #include "crypter.h"
 #include "key.h"
 #include "mnemonics.h"
+#include "mpmc_queue.h"
 #include "scheduler.h"
 #include "threadpool.h"
 #include "vertex.h"
@@ -32,7 +33,10 @@ private:
     enum { CKEY_ID = 0, TX_INDEX, OUTPUT_INDEX, COIN };
 
 public:
-    Wallet(std::string walletPath, uint32_t backupPeriod, uint32_t loginSession);
+    /**
+     * @param keyPoolSize the number of addresses generated ahead by CreateNewKey, 0 to disable the key pool
+     */
+    Wallet(std::string walletPath, uint32_t backupPeriod, uint32_t loginSession, uint32_t keyPoolSize = 0);
 
     ~Wallet();
 
@@ -47,7 +51,14 @@ public:
     CKeyID GetRandomAddress();
     std::vector<CKeyID> GetAllAddresses();
 
+    /**
+     * hands out an address of the key pool without blocking when it is not empty,
+     * or else generates one in place
+     */
     CKeyID CreateNewKey(bool compressed);
+    size_t GetKeyPoolSize() const {
+        return keyPool_.Size();
+    }
     std::string CreateFirstRegistration(const CKeyID&);
     std::string CreateFirstRegWhenPossible(const CKeyID&);
     ConstTxPtr CreateRedemption(const CKeyID&, const CKeyID&, const Coin&, const std::string&);
@@ -133,6 +144,8 @@ private:
     WalletStore walletStore_;
 
     std::atomic_bool stopFlag_ = false;
+    // the key pool is filled on threadPool_, which drops the tasks queued before it starts
+    std::atomic_bool startFlag_ = false;
     Scheduler scheduler_;
     uint32_t backupPeriod_;
 
@@ -168,10 +181,47 @@ private:
     MasterInfo masterInfo_;
     Crypter crypter_;
 
+    /**
+     * guards master_, masterInfo_ and crypter_ once the wallet has started, so that
+     * the key pool never encrypts a key with a crypter being replaced, and a change of
+     * passphrase re-encrypts every key stored before it
+     */
+    std::mutex cryptoMutex_;
+
     // check if the old pass phrase matches
     std::optional<Crypter> CheckPassphraseMatch(const SecureString&) const;
+
+    /**
+     * derives a new crypter from the phrase and stores the master encrypted with it,
+     * with cryptoMutex_ held
+     */
+    bool ApplyPassphrase(const SecureString& phrase);
     std::atomic_bool rpcLoggedin_ = false;
     Timer timer_;
+
+    /**
+     * private keys decrypted during the login session, so that signing many inputs
+     * decrypts every key only once; CKey keeps its data in the locked pool
+     * and the cache is cleansed as soon as the session expires
+     */
+    mutable std::shared_mutex keyCacheMutex_;
+    std::unordered_map<CKeyID, CKey> keyCache_;
+
+    bool GetPrivKey(const CKeyID&, const CPubKey&, const CiphertextKey&, CKey&);
+    void ClearKeyCache();
+
+    /**
+     * compressed keys generated, encrypted and stored ahead in batches on threadPool_,
+     * and refilled whenever less than half of keyPoolSize_ is left
+     */
+    const uint32_t keyPoolSize_;
+    MPMCQueue<CKeyID> keyPool_;
+    std::mutex keyPoolMutex_;
+    // the number of keys being generated
+    std::atomic<size_t> keyPoolPending_ = 0;
+
+    void TopUpKeyPool();
+    void FillKeyPool(size_t n);
 };
 
 extern std::unique_ptr<Wallet> WALLET;
@@ -92,6 +92,18 @@ bool WalletStore::StoreKeys(const CKeyID& addr, const CiphertextKey& encrypted,
     return put(db_, handleMap_.at(kKeyBook), key, value);
 }
 
+bool WalletStore::StoreKeys(const std::vector<std::tuple<CKeyID, CiphertextKey, CPubKey>>& keys) const {
+    class WriteBatch wb;
+    for (const auto& [addr, encrypted, pubkey] : keys) {
+        VStream key, value;
+        key << EncodeAddress(addr);
+        value << encrypted << pubkey;
+        wb.Put(handleMap_.at(kKeyBook), Slice{key.data(), key.size()}, Slice{value.data(), value.size()});
+    }
+
+    return db_->Write(WriteOptions(), &wb).ok();
+}
+
 bool WalletStore::IsExistKey(const CKeyID& addr) const {
     VStream key;
     key << EncodeAddress(addr);
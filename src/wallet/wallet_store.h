@@ -26,6 +26,8 @@ public:
 
     bool StoreTx(const Transaction&) const;
     bool StoreKeys(const CKeyID& addr, const CiphertextKey& encrypted, const CPubKey& pubkey) const;
+    // stores the keys in a single batch
+    bool StoreKeys(const std::vector<std::tuple<CKeyID, CiphertextKey, CPubKey>>& keys) const;
     bool StoreUnspent(const uint256&, const CKeyID&, uint32_t, uint32_t, uint64_t) const;
     bool StorePending(const uint256&, const CKeyID&, uint32_t, uint32_t, uint64_t) const;
     bool StoreSpent(const uint256&, const CKeyID&, uint32_t, uint32_t, uint64_t) const;
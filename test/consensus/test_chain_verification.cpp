@@ -92,6 +92,34 @@ TEST_F(TestChainVerification, UTXO) {
     EXPECT_EQ(ArithToUint256(bHash ^ 0 ^ index), key);
 }
 
+TEST_F(TestChainVerification, compact_utxo) {
+    auto [privkey, pubkey] = fac.CreateKeyPair();
+    Transaction tx;
+    tx.AddOutput(42, pubkey.GetID());
+    tx.AddOutput(TxOutput(1, tasm::Listing(std::vector<uint8_t>{tasm::VERIFY}, VStream(std::string("not an addr")))));
+
+    // the pay-to-key-ID listing collapses to the key ID
+    const auto& output = tx.GetOutputs()[0];
+    auto putxo         = CreateUTXO(output, 0, 0);
+    ASSERT_EQ(*putxo->GetKeyID(), pubkey.GetID());
+    ASSERT_EQ(putxo->GetValue(), output.value);
+    ASSERT_EQ(putxo->GetListing(), output.listingContent);
+
+    VStream stream(putxo);
+    ASSERT_LT(stream.size(), VStream(output).size());
+    ASSERT_EQ(UTXO(stream), *putxo);
+
+    // any other listing is kept as is
+    const auto& raw = tx.GetOutputs()[1];
+    UTXO rawUtxo(raw, 0, 1);
+    ASSERT_FALSE(rawUtxo.GetKeyID());
+    ASSERT_EQ(rawUtxo.GetListing(), raw.listingContent);
+
+    VStream rawStream(rawUtxo);
+    ASSERT_EQ(UTXO(rawStream), rawUtxo);
+    ASSERT_NE(rawUtxo, *putxo);
+}
+
 TEST_F(TestChainVerification, verify_with_redemption_and_reward) {
     // Prepare keys and signature
     auto keypair        = fac.CreateKeyPair();
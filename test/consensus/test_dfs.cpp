@@ -125,3 +125,38 @@ TEST_F(DFSTest, complex_test) {
     ASSERT_EQ(graph[6]->GetTime(), 3);
     ASSERT_EQ(graph[7]->GetTime(), 9);
 }
+
+TEST_F(DFSTest, children_inserted_before_parents) {
+    Chain chain{};
+    auto parent     = fac.CreateBlock();
+    auto child      = fac.CreateBlock();
+    auto grandchild = fac.CreateBlock();
+    child.SetMilestoneHash(parent.GetHash());
+    grandchild.SetPrevHash(child.GetHash());
+    grandchild.SetTipHash(parent.GetHash());
+
+    auto pparent     = std::make_shared<Block>(parent);
+    auto pchild      = std::make_shared<Block>(child);
+    auto pgrandchild = std::make_shared<Block>(grandchild);
+    chain.AddPendingBlock(pgrandchild);
+    chain.AddPendingBlock(pchild);
+    chain.AddPendingBlock(pparent);
+
+    // peeking keeps the blocks pending
+    auto peeked = chain.PeekSortedSubgraph(pgrandchild);
+    ASSERT_EQ(chain.GetPendingBlockCount(), 3);
+
+    auto graph = chain.GetSortedSubgraph(pgrandchild);
+    ASSERT_EQ(chain.GetPendingBlockCount(), 0);
+    ASSERT_EQ(graph, peeked);
+    ASSERT_EQ(graph, (std::vector<ConstBlockPtr>{pparent, pchild, pgrandchild}));
+
+    // the child left waits for its parent to be inserted again
+    chain.AddPendingBlock(pchild);
+    chain.AddPendingBlock(pgrandchild);
+    graph = chain.GetSortedSubgraph(pchild);
+    ASSERT_EQ(graph, std::vector<ConstBlockPtr>{pchild});
+    chain.AddPendingBlock(pchild);
+    graph = chain.GetSortedSubgraph(pgrandchild);
+    ASSERT_EQ(graph, (std::vector<ConstBlockPtr>{pchild, pgrandchild}));
+}
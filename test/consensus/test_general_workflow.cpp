@@ -358,6 +358,56 @@ TEST_F(TestConsensus, flush_single_chain_to_cat) {
     }
 }
 
+TEST_F(TestConsensus, milestone_locator_spans_db_and_cache) {
+    const size_t HEIGHT  = GetParams().punctualityThred + 30;
+    auto [chain, vMsVtx] = fac.CreateRawChain(GENESIS_VERTEX, HEIGHT);
+
+    for (size_t i = 0; i < chain.size(); i++) {
+        if (i > GetParams().punctualityThred) {
+            usleep(50000);
+        }
+        for (auto& blkptr : chain[i]) {
+            DAG->AddNewBlock(blkptr, nullptr);
+        }
+    }
+
+    usleep(50000);
+    STORE->Wait();
+    DAG->Wait();
+
+    // some of the milestones are flushed and the others are still cached
+    ASSERT_GT(STORE->GetHeadHeight(), 0);
+    ASSERT_EQ(DAG->GetBestMilestoneHeight(), HEIGHT);
+
+    std::vector<uint256> msHashes{GENESIS->GetHash()};
+    for (const auto& vtx : vMsVtx) {
+        ASSERT_EQ(vtx->height, msHashes.size());
+        msHashes.push_back(vtx->cblock->GetHash());
+    }
+
+    for (size_t height = 0; height < msHashes.size(); height++) {
+        ASSERT_EQ(DAG->GetMainChainMsHashAt(height), msHashes[height]);
+    }
+    ASSERT_TRUE(DAG->GetMainChainMsHashAt(HEIGHT + 1).IsNull());
+
+    auto forward = DAG->TraverseMilestoneForward(GENESIS_VERTEX, HEIGHT + 10);
+    ASSERT_EQ(forward, std::vector<uint256>(msHashes.begin() + 1, msHashes.end()));
+    ASSERT_EQ(DAG->TraverseMilestoneForward(GENESIS_VERTEX, 5).size(), 5);
+
+    // dense at the head, then exponential strides down to the genesis
+    auto locator = DAG->TraverseMilestoneBackward(DAG->GetMilestoneHead(), 100);
+    ASSERT_LT(locator.size(), 20);
+    ASSERT_EQ(locator.back(), GENESIS->GetHash());
+    for (size_t i = 0; i < 10; i++) {
+        ASSERT_EQ(locator[i], msHashes[HEIGHT - i]);
+    }
+    ASSERT_EQ(locator[10], msHashes[HEIGHT - 11]);
+    ASSERT_EQ(locator[11], msHashes[HEIGHT - 15]);
+
+    // the length limit applies
+    ASSERT_EQ(DAG->TraverseMilestoneBackward(DAG->GetMilestoneHead(), 3).size(), 3);
+}
+
 TEST_F(TestConsensus, delete_fork_and_flush_multiple_chains) {
     const size_t HEIGHT    = GetParams().punctualityThred + 3;
     constexpr size_t hfork = 15;
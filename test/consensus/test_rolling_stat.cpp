@@ -0,0 +1,63 @@
+// Copyright (c) 2019 EPI-ONE Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <gtest/gtest.h>
+
+#include "rolling_stat.h"
+
+class TestRollingStat : public testing::Test {};
+
+TEST_F(TestRollingStat, empty) {
+    RollingStat stat;
+    for (const auto& window : stat.GetWindows()) {
+        ASSERT_EQ(window.counters.nBlks, 0);
+        ASSERT_EQ(window.GetTPS(), 0);
+        ASSERT_EQ(window.GetAvgLvsSize(), 0);
+        ASSERT_EQ(window.GetOrphanRate(), 0);
+    }
+    ASSERT_EQ(stat.GetWindow(42).seconds, 0);
+}
+
+TEST_F(TestRollingStat, windows_slide) {
+    RollingStat stat;
+    const uint32_t t0 = 12 * 24 * 60 * 60;
+
+    // a level set of 10 blocks and 20 transactions every 10 seconds for 2 hours
+    for (uint32_t t = t0; t <= t0 + 7200; t += 10) {
+        stat.AddLevelSet(t, 10, 20);
+        stat.AddReceived(t, false);
+    }
+    stat.AddReceived(t0 + 7200, true);
+    stat.AddFork(t0 + 7000);
+    stat.AddFork(t0 - 100);
+
+    auto minute = stat.GetWindow(60);
+    ASSERT_EQ(minute.timeTo, t0 + 7200);
+    ASSERT_EQ(minute.timeFrom, t0 + 7141);
+    ASSERT_EQ(minute.counters.nLvs, 6);
+    ASSERT_EQ(minute.counters.nBlks, 60);
+    ASSERT_EQ(minute.counters.nForks, 0);
+    ASSERT_DOUBLE_EQ(minute.GetTPS(), 120 / 59.0);
+    ASSERT_DOUBLE_EQ(minute.GetAvgLvsSize(), 10);
+    ASSERT_DOUBLE_EQ(minute.GetOrphanRate(), 1.0 / 7);
+
+    auto hour = stat.GetWindow(60 * 60);
+    ASSERT_EQ(hour.timeFrom, t0 + 3660);
+    ASSERT_EQ(hour.counters.nLvs, 355);
+    ASSERT_EQ(hour.counters.nTxs, 7100);
+    ASSERT_EQ(hour.counters.nForks, 1);
+
+    // the day is not over yet
+    auto day = stat.GetWindow(24 * 60 * 60);
+    ASSERT_EQ(day.timeFrom, t0 - 100);
+    ASSERT_EQ(day.counters.nLvs, 721);
+    ASSERT_EQ(day.counters.nForks, 2);
+    ASSERT_DOUBLE_EQ(day.GetTPS(), 721 * 20 / 7300.0);
+
+    // a gap longer than the windows but the day clears them
+    stat.AddLevelSet(t0 + 7200 + 3 * 60 * 60, 1, 1);
+    ASSERT_EQ(stat.GetWindow(60).counters.nLvs, 1);
+    ASSERT_EQ(stat.GetWindow(60 * 60).counters.nLvs, 1);
+    ASSERT_EQ(stat.GetWindow(24 * 60 * 60).counters.nLvs, 722);
+}
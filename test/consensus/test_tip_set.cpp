@@ -0,0 +1,79 @@
+// Copyright (c) 2019 EPI-ONE Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <gtest/gtest.h>
+
+#include "chain.h"
+#include "test_factory.h"
+#include "tip_set.h"
+
+#include <unordered_map>
+
+class TestTipSet : public testing::Test {
+public:
+    TestFactory fac;
+
+    ConstBlockPtr CreateBlock(Block::Source source) {
+        Block block  = fac.CreateBlock();
+        block.source = source;
+        return std::make_shared<const Block>(std::move(block));
+    }
+};
+
+TEST_F(TestTipSet, insert_erase_and_sample) {
+    TipSet tips;
+    ASSERT_EQ(tips.Random(), nullptr);
+    ASSERT_EQ(tips.RandomForeign(), nullptr);
+
+    std::vector<ConstBlockPtr> blocks;
+    for (int i = 0; i < 10; ++i) {
+        blocks.push_back(CreateBlock(i % 2 ? Block::MINER : Block::NETWORK));
+        tips.Insert(blocks.back());
+    }
+    tips.Insert(blocks[0]);
+    ASSERT_EQ(tips.Size(), blocks.size());
+
+    // removing from the middle keeps the rest of the blocks reachable
+    ASSERT_TRUE(tips.Erase(blocks[4]->GetHash()));
+    ASSERT_FALSE(tips.Erase(blocks[4]->GetHash()));
+    ASSERT_TRUE(tips.Erase(blocks[5]->GetHash()));
+    ASSERT_FALSE(tips.Contains(blocks[4]->GetHash()));
+    ASSERT_EQ(tips.Size(), blocks.size() - 2);
+
+    std::unordered_map<uint256, size_t> counts;
+    const size_t nSamples = 8000;
+    for (size_t i = 0; i < nSamples; ++i) {
+        auto tip = tips.RandomForeign();
+        ASSERT_NE(tip->source, Block::MINER);
+        counts[tip->GetHash()]++;
+        ASSERT_TRUE(tips.Contains(tips.Random()->GetHash()));
+    }
+
+    // blocks 0, 2, 6 and 8 are sampled uniformly
+    ASSERT_EQ(counts.size(), 4);
+    for (const auto& [hash, count] : counts) {
+        ASSERT_GT(count, nSamples / 4 * 0.8);
+        ASSERT_LT(count, nSamples / 4 * 1.2);
+    }
+
+    tips.Clear();
+    ASSERT_EQ(tips.Size(), 0);
+    ASSERT_EQ(tips.Random(), nullptr);
+}
+
+TEST_F(TestTipSet, follows_pending_blocks_of_chain) {
+    Chain chain{};
+    auto block = CreateBlock(Block::NETWORK);
+    chain.AddPendingBlock(block);
+    ASSERT_EQ(chain.GetRandomTip(), block);
+    ASSERT_EQ(chain.GetRandomForeignTip(), block);
+
+    chain.GetSortedSubgraph(block);
+    ASSERT_EQ(chain.GetRandomTip(), nullptr);
+
+    auto mined = CreateBlock(Block::MINER);
+    chain.AddPendingBlock(mined);
+    ASSERT_EQ(chain.GetRandomTip(), mined);
+    ASSERT_EQ(chain.GetRandomForeignTip(), nullptr);
+}
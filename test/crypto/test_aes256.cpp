@@ -4,6 +4,8 @@
 #include "test_env.h"
 #include "utilstrencodings.h"
 
+#include <cstring>
+
 class TestAES256 : public testing::Test {
 public:
     TestFactory fac = EpicTestEnvironment::GetFactory();
@@ -109,3 +111,23 @@ TEST_F(TestAES256, aes256CBC_maliciout_test) {
     int size_1 = decryptor.Decrypt(ciphertext.data(), ciphertext.size(), plaintext.data());
     ASSERT_EQ(size_1, 0);
 }
+
+TEST_F(TestAES256, aes256_matches_ctaes) {
+    // the blocks encrypted by AES-NI, when the CPU supports it, must be those of ctaes
+    for (int i = 0; i < 100; i++) {
+        auto key   = fac.GetRandomString(AES256_KEYSIZE);
+        auto plain = fac.GetRandomString(AES_BLOCKSIZE);
+        auto k     = reinterpret_cast<const unsigned char*>(key.data());
+        auto p     = reinterpret_cast<const unsigned char*>(plain.data());
+
+        AES256_ctx ctx;
+        AES256_init(&ctx, k);
+        unsigned char expected[AES_BLOCKSIZE], cipher[AES_BLOCKSIZE], decrypted[AES_BLOCKSIZE];
+        AES256_encrypt(&ctx, 1, expected, p);
+
+        AES256Encrypt{k}.Encrypt(cipher, p);
+        ASSERT_EQ(memcmp(cipher, expected, AES_BLOCKSIZE), 0);
+        AES256Decrypt{k}.Decrypt(decrypted, cipher);
+        ASSERT_EQ(memcmp(decrypted, p, AES_BLOCKSIZE), 0);
+    }
+}
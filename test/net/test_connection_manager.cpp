@@ -8,6 +8,7 @@
 #include "connection_manager.h"
 #include "message_header.h"
 #include "sync_messages.h"
+#include "version_message.h"
 
 #include <atomic>
 
@@ -196,6 +197,44 @@ TEST_F(TestConnectionManager, SendAndReceive) {
     test_connect_handle->Disconnect();
 }
 
+TEST_F(TestConnectionManager, SendAndReceiveCompressed) {
+    client.RegisterNewConnectionCallback(
+        std::bind(&TestConnectionManager::TestNewConnectionCallback, this, std::placeholders::_1));
+
+    uint16_t port = GetFreePort();
+    ASSERT_TRUE(server.Bind(0x7f000001));
+    ASSERT_TRUE(server.Listen(port));
+    ASSERT_TRUE(client.Connect(0x7f000001, port));
+
+    usleep(50000);
+
+    // the server accepts compressed payloads only after seeing it in the version message
+    auto version           = std::make_unique<VersionMessage>();
+    version->local_service = NODE_COMPRESSION;
+    test_connect_handle->SendMessage(std::move(version));
+    test_connect_handle->EnableCompression();
+
+    size_t size = 4 * 1024 * 1024 / 32;
+    uint256 h   = uintS<256>(std::string(64, 'a'));
+    test_connect_handle->SendMessage(std::make_unique<Inv>(std::vector<uint256>(size, h), 1));
+
+    usleep(50000);
+    connection_message_t receive_message;
+    ASSERT_TRUE(server.ReceiveMessage(receive_message));
+    ASSERT_EQ(receive_message.second->GetType(), NetMessage::VERSION_MSG);
+    ASSERT_TRUE(receive_message.first->IsCompressionEnabled());
+
+    ASSERT_TRUE(server.ReceiveMessage(receive_message));
+    Inv* msg = dynamic_cast<Inv*>(receive_message.second.get());
+    ASSERT_TRUE(msg != nullptr);
+    ASSERT_EQ(msg->hashes.size(), size);
+    for (auto hash : msg->hashes) {
+        ASSERT_EQ(h, hash);
+    }
+
+    test_connect_handle->Disconnect();
+}
+
 TEST_F(TestConnectionManager, SendAndReceiveOnlyHeader) {
     client.RegisterNewConnectionCallback(
         std::bind(&TestConnectionManager::TestNewConnectionCallback, this, std::placeholders::_1));
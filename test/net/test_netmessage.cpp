@@ -73,6 +73,26 @@ TEST_F(TestNetMsg, VersionMessage) {
     EXPECT_EQ(versionMessage.version_info, versionMessage1.version_info);
 }
 
+TEST_F(TestNetMsg, VersionMessageLowestHeight) {
+    VersionMessage versionMessage(a1, a1, 100, 123, "version info");
+    versionMessage.lowest_height = 42;
+    VStream stream(versionMessage);
+
+    VersionMessage versionMessage1(stream);
+    EXPECT_EQ(versionMessage.current_height, versionMessage1.current_height);
+    EXPECT_EQ(versionMessage.lowest_height, versionMessage1.lowest_height);
+
+    // a message without the trailing field is from a peer keeping all level sets
+    VStream old;
+    old << versionMessage.client_version << versionMessage.local_service << versionMessage.nTime
+        << versionMessage.address_you << versionMessage.address_me << versionMessage.current_height
+        << versionMessage.id << versionMessage.version_info;
+
+    VersionMessage versionMessage2(old);
+    EXPECT_EQ(versionMessage.version_info, versionMessage2.version_info);
+    EXPECT_EQ(0, versionMessage2.lowest_height);
+}
+
 TEST_F(TestNetMsg, Bundle) {
     Bundle bundle(1);
     bundle.AddBlock(factory.CreateBlockPtr(1, 1, true));
@@ -56,6 +56,7 @@ TEST_F(TestPeerManager, CheckHaveConnectedSameIP) {
     EXPECT_EQ(same_ip_client.GetConnectedPeerSize(), 1);
 
     ASSERT_EQ(server.RandomlySelect(2).size(), 2);
+    ASSERT_EQ(server.SelectRelayPeers(3).size(), 2);
 
     same_ip_client.Stop();
 }
@@ -0,0 +1,56 @@
+// Copyright (c) 2019 EPI-ONE Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <gtest/gtest.h>
+
+#include "peer_quality.h"
+
+TEST(TestPeerQuality, moving_averages) {
+    PeerQuality q;
+    q.AddRtt(100);
+    ASSERT_DOUBLE_EQ(q.GetRtt(), 100);
+    q.AddRtt(200);
+    ASSERT_DOUBLE_EQ(q.GetRtt(), 100 + PeerQuality::kWeight * 100);
+
+    q.AddDelivery(1000, 0);
+    ASSERT_DOUBLE_EQ(q.GetBandwidth(), 1000 * 1000);
+    q.AddTimeout();
+    ASSERT_DOUBLE_EQ(q.GetTimeoutRate(), PeerQuality::kWeight);
+
+    q.AddMessage(false);
+    ASSERT_DOUBLE_EQ(q.GetInvalidRate(), 1);
+    q.AddMessage(true);
+    ASSERT_DOUBLE_EQ(q.GetInvalidRate(), 1 - PeerQuality::kWeight);
+}
+
+TEST(TestPeerQuality, score) {
+    PeerQuality fresh, fast, slow, faulty;
+    for (size_t i = 0; i < PeerQuality::kMinSamples; ++i) {
+        fast.AddRtt(20);
+        fast.AddDelivery(1 << 20, 100);
+        slow.AddRtt(2000);
+        slow.AddDelivery(1 << 20, 10000);
+        faulty.AddRtt(20);
+        faulty.AddTimeout();
+    }
+
+    // unmeasured peers rank between fast and slow ones
+    ASSERT_GT(fast.GetScore(), fresh.GetScore());
+    ASSERT_GT(fresh.GetScore(), slow.GetScore());
+    ASSERT_GT(fast.GetScore(), faulty.GetScore());
+    ASSERT_DOUBLE_EQ(faulty.GetScore(), 0);
+
+    ASSERT_FALSE(fresh.IsChronicallySlow());
+    ASSERT_FALSE(fast.IsChronicallySlow());
+    ASSERT_FALSE(slow.IsChronicallySlow());
+    ASSERT_TRUE(faulty.IsChronicallySlow());
+
+    PeerQuality laggy;
+    for (size_t i = 0; i < PeerQuality::kMinSamples - 1; ++i) {
+        laggy.AddRtt(PeerQuality::kMaxRtt * 2);
+    }
+    ASSERT_FALSE(laggy.IsChronicallySlow());
+    laggy.AddRtt(PeerQuality::kMaxRtt * 2);
+    ASSERT_TRUE(laggy.IsChronicallySlow());
+}
@@ -38,7 +38,7 @@ public:
         while (!RPC->IsRunning()) {
             std::this_thread::yield();
         }
-        client = std::make_unique<RPCClient>(grpc::CreateChannel(addr, grpc::InsecureChannelCredentials()));
+        client = std::make_unique<RPCClient>(RPCClient::CreateChannel(addr));
     }
 
     void TearDown() {
@@ -260,6 +260,33 @@ TEST_F(TestRPCServer, basic_dag_info_query) {
         ASSERT_TRUE(SameVertex(*(DAG->GetMainChainVertex(pick_hash)), rpc_get_ver.vertex()));
     }
 
+    // the same queries in batches pipelined in small requests, with a missing hash in the middle
+    std::vector<std::string> hashes;
+    for (const auto& blk : blocks) {
+        hashes.emplace_back(std::to_string(blk->cblock->GetHash()));
+    }
+    hashes.insert(hashes.begin() + hashes.size() / 2, std::to_string(fac.CreateRandomHash()));
+    client->SetPipeline(64, 4);
+
+    std::vector<size_t> failed;
+    rpc::GetBlocksResponse rpc_get_blks;
+    JsonStringToMessage(StringPiece(*client->GetBlocks(hashes, &failed)), &rpc_get_blks);
+    rpc::GetVerticesResponse rpc_get_vers;
+    JsonStringToMessage(StringPiece(*client->GetVertices(hashes, &failed)), &rpc_get_vers);
+    ASSERT_TRUE(failed.empty());
+    ASSERT_EQ(rpc_get_blks.blocks_size(), hashes.size());
+    ASSERT_EQ(rpc_get_vers.vertices_size(), hashes.size());
+
+    for (size_t i = 0; i < hashes.size(); i++) {
+        const auto vertex = DAG->GetMainChainVertex(uintS<256>(hashes[i]));
+        if (!vertex) {
+            ASSERT_TRUE(rpc_get_blks.blocks(i).hash().empty());
+            continue;
+        }
+        ASSERT_TRUE(SameBlock(*vertex->cblock, rpc_get_blks.blocks(i)));
+        ASSERT_TRUE(SameVertex(*vertex, rpc_get_vers.vertices(i)));
+    }
+
     auto re_forks = client->GetForks(); // get forks
     rpc::GetForksResponse rpc_forks;
     JsonStringToMessage(StringPiece(*re_forks), &rpc_forks);
@@ -278,6 +305,8 @@ TEST_F(TestRPCServer, basic_dag_info_query) {
     rpc::GetRecentStatResponse rpc_recent_stat;
     JsonStringToMessage(StringPiece(*re_recent_stat), &rpc_recent_stat);
     ASSERT_EQ(rpc_recent_stat.nblks(), nBlkCached);
+    ASSERT_EQ(rpc_recent_stat.windows_size(), 3);
+    ASSERT_EQ(rpc_recent_stat.windows(2).seconds(), 24 * 60 * 60);
 
     auto re_stat = client->Statistic(); // get total statistic data
     rpc::StatisticResponse rpc_stat;
@@ -375,6 +404,8 @@ TEST_F(TestRPCServer, transaction_and_miner) {
 
     ASSERT_EQ(client->CreateRandomTx(1).value(), testCode[AnswerCode::WALLET_NOT_START]);
     ASSERT_EQ(client->CreateTx({}, 0).value(), testCode[AnswerCode::WALLET_NOT_START]);
+    ASSERT_EQ(client->CreateTxBatch({{{}, 0}, {{}, 1}}).value(),
+              testCode[AnswerCode::WALLET_NOT_START] + "\n" + testCode[AnswerCode::WALLET_NOT_START] + "\n");
     ASSERT_EQ(client->GenerateNewKey().value(), testCode[AnswerCode::WALLET_NOT_START]);
     ASSERT_EQ(client->GetBalance().value(), testCode[AnswerCode::WALLET_NOT_START]);
 
@@ -494,3 +525,22 @@ TEST_F(TestRPCServer, Subscription) {
 
     PUBLISHER.reset();
 }
+
+TEST_F(TestRPCServer, batch_failures) {
+    // every item of the requests which fail is reported
+    RPCClient unreachable(RPCClient::CreateChannel("127.0.0.1:3790"));
+    unreachable.SetPipeline(2, 2);
+
+    std::vector<size_t> failed;
+    ASSERT_FALSE(unreachable.GetBlocks({"a", "b", "c"}, &failed));
+    ASSERT_EQ(failed, std::vector<size_t>({0, 1, 2}));
+
+    failed.clear();
+    ASSERT_FALSE(unreachable.CreateTxBatch({{{}, 0}, {{}, 1}, {{}, 2}}, &failed));
+    ASSERT_EQ(failed, std::vector<size_t>({0, 1, 2}));
+
+    // while an empty batch has nothing to fail
+    failed.clear();
+    ASSERT_TRUE(unreachable.GetVertices({}, &failed));
+    ASSERT_TRUE(failed.empty());
+}
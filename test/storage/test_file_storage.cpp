@@ -8,6 +8,7 @@
 #include "crc32.h"
 #include "file_utils.h"
 #include "test_env.h"
+#include <fstream>
 #include <string>
 
 class TestFileStorage : public testing::Test {
@@ -24,6 +25,60 @@ public:
     }
 };
 
+/**
+ * Serializes the VTX file holding the level sets in [height1, height2) as indexed in DB,
+ * in the legacy format for the level sets below legacyHeight and in the compact one after
+ */
+static std::pair<VStream, std::vector<LevelSetVtxPoses>> SerializeVtxFile(
+    const DBStore& db,
+    const std::unordered_map<uint256, VertexPtr>& vertices,
+    uint64_t height1,
+    uint64_t height2,
+    uint64_t legacyHeight) {
+    VStream records;
+    std::vector<LevelSetVtxPoses> levelSets;
+    for (uint64_t height = height1; height < height2; ++height) {
+        auto msPos   = db.GetMsPos(height);
+        auto offsets = db.GetLevelSetOffsets(height);
+
+        LevelSetVtxPoses lvs{height, std::get<0>(offsets.front()), msPos->first, msPos->second, {}, {}, {}};
+        lvs.msVtxPos.nOffset = file::checksum_size + records.size();
+        for (const auto& [hash, blkOffset, vtxOffset] : offsets) {
+            lvs.hashes.push_back(hash);
+            lvs.blkOffsets.push_back(blkOffset);
+            lvs.vtxOffsets.push_back(file::checksum_size + records.size() - lvs.msVtxPos.nOffset);
+
+            const auto& v = *vertices.at(hash);
+            if (height < legacyHeight) {
+                records << v.isRedeemed << VARINT(v.height) << v.cumulativeReward << VARINT(v.minerChainHeight)
+                        << v.validity << static_cast<uint8_t>(v.GetMilestoneStatus());
+                if (v.snapshot) {
+                    records << *v.snapshot;
+                }
+            } else {
+                v.Serialize(records, vtxOffset == 0);
+            }
+        }
+        levelSets.push_back(std::move(lvs));
+    }
+
+    VStream output;
+    output << crc32c((uint8_t*) records.data(), records.size());
+    output.write(records.data(), records.size());
+    return {std::move(output), std::move(levelSets)};
+}
+
+static void WriteFile(const std::string& path, const VStream& data) {
+    std::ofstream f(path, std::ios::binary | std::ios::trunc);
+    f.write(data.data(), data.size());
+}
+
+static bool IsCompact(const FilePos& pos) {
+    std::ifstream f(file::GetFilePath(file::VTX, pos), std::ios::binary);
+    f.seekg(file::checksum_size);
+    return (static_cast<uint8_t>(f.get()) & Vertex::FORMAT_MASK) == Vertex::FORMAT_COMPACT;
+}
+
 TEST_F(TestFileStorage, basic_read_write) {
     EpicTestEnvironment::SetUpDAG(prefix);
     Miner m{1};
@@ -279,3 +334,169 @@ TEST_F(TestFileStorage, test_modifier) {
     vtx_modified->isRedeemed = Vertex::NOT_YET_REDEEMED;
     ASSERT_EQ(*vtx_modified, *vertex);
 }
+
+TEST_F(TestFileStorage, serialize_level_set_ahead_of_storing) {
+    EpicTestEnvironment::SetUpDAG(prefix);
+
+    std::vector<VertexPtr> lvs;
+    for (int i = 0; i < 3; ++i) {
+        auto b         = fac.CreateVertexPtr(fac.GetRand() % 10, fac.GetRand() % 10, true);
+        b->isMilestone = false;
+        b->height      = 1;
+        lvs.push_back(b);
+    }
+
+    auto ms = fac.CreateVertexPtr(1, 1, true);
+    fac.CreateMilestonePtr(GENESIS_VERTEX->snapshot, ms);
+    ms->isMilestone = true;
+    ms->height      = 1;
+    lvs.push_back(ms);
+
+    auto serialized = BlockStore::SerializeLevelSet(lvs);
+    ASSERT_EQ(serialized.height, 1);
+    ASSERT_EQ(serialized.msHash, ms->cblock->GetHash());
+    ASSERT_EQ(serialized.hashes.size(), lvs.size());
+    ASSERT_EQ(serialized.hashes.front(), ms->cblock->GetHash());
+
+    // sizes have to agree with the ones used to carry over files
+    size_t blkSize = 0, vtxSize = 0;
+    for (auto& vtx : lvs) {
+        blkSize += vtx->cblock->GetOptimalEncodingSize();
+        vtxSize += vtx->GetOptimalStorageSize(vtx == ms);
+    }
+    ASSERT_EQ(serialized.blks.size(), blkSize);
+    ASSERT_EQ(serialized.vtcs.size(), vtxSize);
+
+    ASSERT_TRUE(STORE->StoreLevelSet(serialized));
+    for (auto& vtx : lvs) {
+        auto stored = STORE->GetVertex(vtx->cblock->GetHash());
+        ASSERT_TRUE(stored);
+        ASSERT_EQ(*stored, *vtx);
+    }
+    ASSERT_EQ(STORE->GetMilestoneHashAt(1), ms->cblock->GetHash());
+}
+
+TEST_F(TestFileStorage, convert_legacy_vtx_files) {
+    const std::string dir = prefix + "convert";
+    file::SetDataDirPrefix(dir);
+    STORE = std::make_unique<BlockStore>(dir);
+    STORE->SetFileCapacities(800, 100);
+
+    std::unordered_map<uint256, VertexPtr> vertices{{GENESIS->GetHash(), GENESIS_VERTEX}};
+    std::vector<VertexPtr> genesisLvs = {GENESIS_VERTEX};
+    ASSERT_TRUE(STORE->StoreLevelSet(genesisLvs));
+
+    constexpr uint64_t nLvs = 30;
+    auto prevMs             = GENESIS_VERTEX;
+    for (uint64_t i = 1; i <= nLvs; ++i) {
+        std::vector<VertexPtr> lvs;
+        for (int j = fac.GetRand() % 5; j > 0; --j) {
+            auto b         = fac.CreateVertexPtr(fac.GetRand() % 10, fac.GetRand() % 10, true);
+            b->isMilestone = false;
+            b->height      = i;
+            lvs.push_back(b);
+        }
+
+        auto ms = fac.CreateVertexPtr(1, 1, true);
+        fac.CreateMilestonePtr(prevMs->snapshot, ms);
+        ms->isMilestone = true;
+        ms->height      = i;
+        lvs.push_back(ms);
+        prevMs = ms;
+
+        ASSERT_TRUE(STORE->StoreLevelSet(lvs));
+        for (const auto& v : lvs) {
+            vertices.emplace(v->cblock->GetHash(), v);
+        }
+    }
+    STORE->SaveHeadHeight(nLvs);
+
+    auto restart = [&]() {
+        STORE = std::make_unique<BlockStore>(dir);
+        ASSERT_TRUE(STORE->CheckFileSanity(false));
+        STORE->ConvertLegacyVtxFiles();
+        STORE->Wait();
+    };
+    auto check = [&]() {
+        for (const auto& [hash, vtx] : vertices) {
+            auto stored = STORE->GetVertex(hash, false);
+            ASSERT_TRUE(stored);
+            ASSERT_EQ(*vtx, *stored);
+        }
+        for (uint64_t height = 1; height <= nLvs; ++height) {
+            auto lvs = STORE->GetLevelSetVtcsAt(height);
+            ASSERT_FALSE(lvs.empty());
+            for (const auto& vtx : lvs) {
+                ASSERT_EQ(*vertices.at(vtx->cblock->GetHash()), *vtx);
+            }
+        }
+    };
+
+    STORE->Stop();
+    STORE.reset();
+
+    // the heights in [first, last) of each VTX file, of which the last one is still being appended to
+    struct VtxFile {
+        FilePos pos;
+        uint64_t first, last;
+    };
+    std::vector<VtxFile> files;
+    {
+        DBStore db(dir);
+        for (uint64_t height = 0; height <= nLvs; ++height) {
+            auto pos    = db.GetMsPos(height)->second;
+            pos.nOffset = 0;
+            if (files.empty() || !files.back().pos.SameFileAs(pos)) {
+                files.push_back({pos, height, height});
+            }
+            files.back().last = height + 1;
+        }
+        ASSERT_GE(files.size(), 6);
+
+        auto rewrite = [&](const VtxFile& f, uint64_t legacyHeight) {
+            auto [data, poses] = SerializeVtxFile(db, vertices, f.first, f.last, legacyHeight);
+            WriteFile(file::GetFilePath(file::VTX, f.pos), data);
+            ASSERT_TRUE(db.RewriteVtxPoses(poses, f.pos));
+            ASSERT_TRUE(db.ClearVtxRewrite());
+        };
+
+        // written before the upgrade
+        rewrite(files[0], UINT64_MAX);
+        rewrite(files[1], UINT64_MAX);
+        // the upgrade took place while it was being appended to
+        rewrite(files[2], files[2].first + 1);
+
+        // interrupted after the positions in the converted file are written to DB
+        rewrite(files[3], UINT64_MAX);
+        auto [compact, poses] = SerializeVtxFile(db, vertices, files[3].first, files[3].last, 0);
+        WriteFile(file::GetFilePath(file::VTX, files[3].pos) + ".compact", compact);
+        ASSERT_TRUE(db.RewriteVtxPoses(poses, files[3].pos));
+    }
+
+    restart();
+    ASSERT_FALSE(CheckFileExist(file::GetFilePath(file::VTX, files[3].pos) + ".compact"));
+    for (const auto& f : files) {
+        ASSERT_TRUE(IsCompact(f.pos));
+    }
+    check();
+
+    STORE->Stop();
+    STORE.reset();
+
+    // the next start resumes from the file being appended to at the last one,
+    // leaving the files before untouched
+    {
+        DBStore db(dir);
+        ASSERT_EQ(db.GetInfo<uint64_t>("vtxConverted"), files.back().first);
+        ASSERT_EQ(db.GetVtxRewrite(), FilePos{});
+
+        auto [data, poses] = SerializeVtxFile(db, vertices, files[0].first, files[0].last, UINT64_MAX);
+        WriteFile(file::GetFilePath(file::VTX, files[0].pos), data);
+        ASSERT_TRUE(db.RewriteVtxPoses(poses, files[0].pos));
+        ASSERT_TRUE(db.ClearVtxRewrite());
+    }
+
+    restart();
+    ASSERT_FALSE(IsCompact(files[0].pos));
+    check();
+}
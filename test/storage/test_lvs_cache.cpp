@@ -0,0 +1,73 @@
+// Copyright (c) 2019 EPI-ONE Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <gtest/gtest.h>
+
+#include "lvs_cache.h"
+#include "test_env.h"
+
+class TestLevelSetCache : public testing::Test {
+public:
+    TestFactory fac;
+
+    VStream MakePayload(size_t size) {
+        VStream payload;
+        payload.resize(size, static_cast<char>(fac.GetRand()));
+        return payload;
+    }
+};
+
+TEST_F(TestLevelSetCache, evicts_least_recently_used_by_bytes) {
+    LevelSetCache cache(1000);
+
+    std::vector<uint256> hashes;
+    for (int i = 0; i < 4; ++i) {
+        hashes.push_back(fac.CreateRandomHash());
+        cache.Put(hashes.back(), i, MakePayload(300));
+    }
+
+    // the first one is evicted to make room for the fourth
+    ASSERT_EQ(cache.Count(), 3);
+    ASSERT_EQ(cache.Size(), 900);
+    ASSERT_FALSE(cache.Get(hashes[0]));
+    ASSERT_FALSE(cache.ContainsHeight(0));
+
+    // touch the second so that the third goes next
+    ASSERT_TRUE(cache.Get(hashes[1]));
+    cache.Put(fac.CreateRandomHash(), 4, MakePayload(300));
+    ASSERT_TRUE(cache.Contains(hashes[1]));
+    ASSERT_FALSE(cache.Contains(hashes[2]));
+    ASSERT_TRUE(cache.ContainsHeight(3));
+    ASSERT_FALSE(cache.ContainsHeight(2));
+
+    // too large to be cached at all
+    cache.Put(fac.CreateRandomHash(), 5, MakePayload(1001));
+    ASSERT_EQ(cache.Count(), 3);
+
+    // the payload is kept intact
+    auto payload = MakePayload(100);
+    auto h       = fac.CreateRandomHash();
+    cache.Put(h, 6, payload);
+    ASSERT_EQ(*cache.Get(h), payload);
+
+    cache.Clear();
+    ASSERT_EQ(cache.Count(), 0);
+    ASSERT_EQ(cache.Size(), 0);
+}
+
+TEST_F(TestLevelSetCache, read_ahead_marks) {
+    LevelSetCache cache(1000);
+    auto h = fac.CreateRandomHash();
+
+    ASSERT_TRUE(cache.MarkReadAhead(h));
+    ASSERT_FALSE(cache.MarkReadAhead(h));
+
+    // cleared by either putting or unmarking
+    cache.Put(h, 1, MakePayload(10));
+    ASSERT_FALSE(cache.MarkReadAhead(h));
+    cache.Clear();
+    ASSERT_TRUE(cache.MarkReadAhead(h));
+    cache.UnmarkReadAhead(h);
+    ASSERT_TRUE(cache.MarkReadAhead(h));
+}
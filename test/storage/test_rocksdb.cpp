@@ -7,8 +7,10 @@
 #include "db.h"
 #include "test_env.h"
 
+#include <algorithm>
 #include <cstdio>
 #include <iostream>
+#include <map>
 #include <string>
 
 class TestRocksDB : public testing::Test {
@@ -39,6 +41,38 @@ protected:
 std::string TestRocksDB::prefix = "test_rocks/"; // temporary db folder prefix
 DBStore* TestRocksDB::db        = nullptr;
 
+/**
+ * Overwrites records of a closed database without
+ * triggering the migrations of DBStore
+ */
+static void PutRaw(const std::string& path, const std::map<std::string, std::map<std::string, std::string>>& records) {
+    std::vector<std::string> names;
+    ASSERT_TRUE(rocksdb::DB::ListColumnFamilies(rocksdb::DBOptions(), path, &names).ok());
+
+    std::vector<rocksdb::ColumnFamilyDescriptor> descriptors;
+    for (const auto& name : names) {
+        descriptors.emplace_back(name, rocksdb::ColumnFamilyOptions());
+    }
+    std::vector<rocksdb::ColumnFamilyHandle*> handles;
+    rocksdb::DB* raw;
+    ASSERT_TRUE(rocksdb::DB::Open(rocksdb::DBOptions(), path, descriptors, &handles, &raw).ok());
+
+    for (size_t i = 0; i < names.size(); ++i) {
+        auto column = records.find(names[i]);
+        if (column != records.end()) {
+            for (const auto& [key, value] : column->second) {
+                ASSERT_TRUE(raw->Put(rocksdb::WriteOptions(), handles[i], key, value).ok());
+            }
+        }
+        delete handles[i];
+    }
+    delete raw;
+}
+
+static std::string ToBytes(VStream&& s) {
+    return std::string(s.data(), s.size());
+}
+
 TEST_F(TestRocksDB, single_insertion_and_deletion) {
     // Consturct a milestone file position
     auto msHash     = fac.CreateRandomHash();
@@ -185,3 +219,108 @@ TEST_F(TestRocksDB, headheight) {
         ASSERT_EQ(i, read_height);
     }
 }
+
+TEST_F(TestRocksDB, batch_deletion_by_height) {
+    // Use heights beyond the range of the other cases as they share the same db
+    uint64_t base = (uint64_t) UINT32_MAX + 1;
+    std::vector<uint256> hashes;
+    std::vector<uint64_t> heights;
+
+    for (uint64_t h = base; h < base + 10; ++h) {
+        for (int i = 0; i < 5; ++i) {
+            hashes.push_back(fac.CreateRandomHash());
+            heights.push_back(h);
+        }
+    }
+
+    std::vector<uint32_t> offsets(hashes.size(), 0);
+    ASSERT_TRUE(db->WriteVtxPoses(hashes, heights, offsets, offsets));
+
+    // Single deletion also removes the height index entry
+    ASSERT_TRUE(db->DeleteVtxPos(hashes.back()));
+    ASSERT_EQ(UINT_FAST64_MAX, db->GetHeight(hashes.back()));
+
+    uint64_t threshold = base + 6;
+    ASSERT_TRUE(db->DeleteBatchVtxPos(threshold));
+
+    for (size_t i = 0; i < hashes.size(); ++i) {
+        if (heights[i] >= threshold) {
+            ASSERT_EQ(UINT_FAST64_MAX, db->GetHeight(hashes[i]));
+        } else {
+            ASSERT_EQ(heights[i], db->GetHeight(hashes[i]));
+        }
+    }
+
+    // Re-inserting blocks at deleted heights works as before
+    ASSERT_TRUE(db->WriteVtxPos(hashes.back(), heights.back(), 0, 0));
+    ASSERT_EQ(heights.back(), db->GetHeight(hashes.back()));
+}
+
+TEST_F(TestRocksDB, range_deletion_of_pruned_heights) {
+    uint64_t base = (uint64_t) UINT32_MAX << 1;
+    std::vector<uint256> hashes;
+    std::vector<uint64_t> heights;
+
+    for (uint64_t h = base; h < base + 10; ++h) {
+        for (int i = 0; i < 3; ++i) {
+            hashes.push_back(fac.CreateRandomHash());
+            heights.push_back(h);
+        }
+        ASSERT_TRUE(db->WriteMsPos(h, hashes.back(), FilePos{0, 0, 0}, FilePos{0, 0, 0}));
+    }
+
+    std::vector<uint32_t> offsets(hashes.size(), 0);
+    ASSERT_TRUE(db->WriteVtxPoses(hashes, heights, offsets, offsets));
+
+    uint64_t from = base + 2, to = base + 5;
+    ASSERT_TRUE(db->DeleteMsPosBetween(from, to));
+    ASSERT_TRUE(db->DeleteVtxPosBetween(from, to));
+
+    for (size_t i = 0; i < hashes.size(); ++i) {
+        bool deleted = heights[i] >= from && heights[i] < to;
+        ASSERT_EQ(deleted ? UINT_FAST64_MAX : heights[i], db->GetHeight(hashes[i]));
+        ASSERT_EQ(!deleted, db->GetMsPos(heights[i]).has_value());
+    }
+}
+
+TEST_F(TestRocksDB, utxo_migration) {
+    std::string path = prefix + "migration";
+    {
+        // creates the columns
+        DBStore created(path);
+    }
+
+    auto block    = fac.CreateBlock(1, 4);
+    auto& outputs = block.GetTransactions()[0]->GetOutputs();
+
+    // keys in the order of the column
+    std::vector<uint256> keys;
+    for (size_t i = 0; i < outputs.size(); ++i) {
+        keys.push_back(fac.CreateRandomHash());
+    }
+    std::sort(keys.begin(), keys.end(),
+              [](const uint256& a, const uint256& b) { return ToBytes(VStream(a)) < ToBytes(VStream(b)); });
+
+    // the first two records have been converted by an interrupted migration
+    std::map<std::string, std::string> utxos;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        utxos[ToBytes(VStream(keys[i]))] =
+            i < 2 ? ToBytes(VStream(UTXO(outputs[i], 0, 0))) : ToBytes(VStream(outputs[i]));
+    }
+    PutRaw(path, {{"utxo", utxos},
+                  {"info", {{"utxoFormat", ToBytes(VStream((uint16_t) 0))},
+                            {"utxoCompacted", ToBytes(VStream(keys[1]))}}}});
+
+    auto migrated = std::make_unique<DBStore>(path);
+    for (size_t i = 0; i < keys.size(); ++i) {
+        ASSERT_EQ(UTXO(outputs[i], 0, 0), *migrated->GetUTXO(keys[i]));
+    }
+    migrated.reset();
+
+    // a record that is not a legacy output fails the migration instead of being dropped
+    PutRaw(path, {{"utxo", {{ToBytes(VStream(keys[3])), "\xff"}}},
+                  {"info", {{"utxoFormat", ToBytes(VStream((uint16_t) 0))},
+                            {"utxoCompacted", ToBytes(VStream(keys[2]))}}}});
+    ASSERT_THROW(DBStore{path}, std::string);
+    ASSERT_THROW(DBStore{path}, std::string);
+}
@@ -0,0 +1,60 @@
+// Copyright (c) 2019 EPI-ONE Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <gtest/gtest.h>
+
+#include "arith_uint256.h"
+#include "big_uint.h"
+
+class TestArithUint256 : public testing::Test {
+public:
+    const arith_uint256 a = (arith_uint256(0x0123456789abcdefULL) << 190) + arith_uint256(0xfedcba9876543210ULL);
+    const arith_uint256 b = arith_uint256(0xdeadbeefULL) << 70;
+};
+
+// Compact conversions are usable in constant expressions
+static_assert(arith_uint256().SetCompact(0x1d00ffff).GetCompact() == 0x1d00ffff);
+static_assert((arith_uint256(1) << 255 >> 255) == 1);
+static_assert(arith_uint256(0) - 1 == ~arith_uint256(0));
+
+TEST_F(TestArithUint256, Arithmetic) {
+    // Expected values are given by the former 32-bit limb implementation
+    auto diff = b - a;
+    EXPECT_EQ(0x0123456789abcdf0ULL, diff.GetLow64());
+    EXPECT_EQ(0xffb72ea61d950c84ULL, (diff >> 192).GetLow64());
+    EXPECT_EQ(a, b - diff);
+
+    EXPECT_EQ(166, (a * b).bits());
+    EXPECT_EQ(a * 0xdeadbeef, a * arith_uint256(0xdeadbeef));
+
+    auto quotient = a / b;
+    EXPECT_EQ(145, quotient.bits());
+    EXPECT_EQ(9128537425420296746ULL, quotient.GetLow64());
+    EXPECT_LE(quotient * b, a);
+    EXPECT_GT(quotient * b + b, a);
+
+    // Short division by a single limb
+    EXPECT_EQ(a, a / 1);
+    EXPECT_EQ(a >> 1, a / 2);
+    EXPECT_THROW(a / 0, uint_error);
+}
+
+TEST_F(TestArithUint256, Conversions) {
+    EXPECT_EQ(0x1f48d159, a.GetCompact());
+    EXPECT_DOUBLE_EQ(1.2865787693035133e+74, a.GetDouble());
+
+    auto maxTarget = arith_uint256().SetCompact(0x2100ffff);
+    EXPECT_EQ(65536, (maxTarget / arith_uint256().SetCompact(0x1f00ffff)).GetLow64());
+
+    bool negative = false, overflow = false;
+    arith_uint256().SetCompact(0x01fedcba, &negative, &overflow);
+    EXPECT_TRUE(negative);
+    EXPECT_FALSE(overflow);
+    arith_uint256().SetCompact(0xff123456, &negative, &overflow);
+    EXPECT_TRUE(overflow);
+
+    EXPECT_EQ(a, UintToArith256(ArithToUint256(a)));
+    EXPECT_EQ(a.GetHex(), ArithToUint256(a).GetHex());
+    EXPECT_EQ(256 - a.bits(), a.LeadingZeros());
+}
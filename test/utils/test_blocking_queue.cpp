@@ -0,0 +1,110 @@
+// Copyright (c) 2019 EPI-ONE Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <gtest/gtest.h>
+
+#include "blocking_queue.h"
+
+#include <memory>
+#include <numeric>
+#include <thread>
+
+class TestBlockingQueue : public testing::Test {};
+
+TEST_F(TestBlockingQueue, mpmc_queue) {
+    MPMCQueue<std::unique_ptr<int>> queue(3);
+    ASSERT_EQ(queue.Capacity(), 4);
+    ASSERT_TRUE(queue.Empty());
+
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_TRUE(queue.TryPush(std::make_unique<int>(i)));
+    }
+    auto rejected = std::make_unique<int>(4);
+    ASSERT_TRUE(queue.Full());
+    ASSERT_FALSE(queue.TryPush(std::move(rejected)));
+    ASSERT_TRUE(rejected);
+    ASSERT_EQ(**queue.Front(), 0);
+
+    // the elements wrap around the ring in order
+    std::unique_ptr<int> element;
+    for (int i = 0; i < 10; ++i) {
+        ASSERT_TRUE(queue.TryPop(element));
+        ASSERT_EQ(*element, i);
+        ASSERT_TRUE(queue.TryPush(std::make_unique<int>(i + 4)));
+    }
+    ASSERT_EQ(queue.Size(), 4);
+}
+
+TEST_F(TestBlockingQueue, producers_and_consumers) {
+    constexpr size_t nThreads = 4, nElements = 100000;
+    BlockingQueue<size_t> queue(64);
+
+    std::vector<std::thread> threads;
+    std::atomic_size_t sum = 0, count = 0;
+    for (size_t t = 0; t < nThreads; ++t) {
+        threads.emplace_back([&, t]() {
+            for (size_t i = t; i < nElements; i += nThreads) {
+                queue.Put(i);
+            }
+        });
+        threads.emplace_back([&]() {
+            size_t element;
+            while (count < nElements && queue.Take(element)) {
+                sum += element;
+                if (++count == nElements) {
+                    queue.Quit();
+                }
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    ASSERT_EQ(count, nElements);
+    ASSERT_EQ(sum, nElements * (nElements - 1) / 2);
+}
+
+TEST_F(TestBlockingQueue, batches) {
+    BlockingQueue<int> queue(16);
+    std::vector<int> input(100);
+    std::iota(input.begin(), input.end(), 0);
+
+    // the producer blocks on the full queue until the consumer takes the batches
+    std::thread producer([&]() { ASSERT_EQ(queue.PutAll(input), input.size()); });
+
+    std::vector<int> output;
+    while (output.size() < input.size()) {
+        ASSERT_TRUE(queue.TakeAll(output, 10));
+    }
+    producer.join();
+    ASSERT_EQ(output, input);
+}
+
+TEST_F(TestBlockingQueue, quit) {
+    BlockingQueue<int> queue(2);
+    int element;
+
+    std::thread consumer([&]() { ASSERT_FALSE(queue.Take(element)); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    queue.Quit();
+    consumer.join();
+
+    // puts have no effect until enabled
+    queue.Put(1);
+    ASSERT_TRUE(queue.Empty());
+    queue.Enable();
+    queue.Put(1);
+    queue.Put(2);
+
+    std::thread producer([&]() { queue.Put(3); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    ASSERT_EQ(queue.Size(), 2);
+    ASSERT_TRUE(queue.Take(element));
+    producer.join();
+    ASSERT_EQ(queue.Size(), 2);
+
+    queue.Clear();
+    ASSERT_TRUE(queue.Empty());
+}
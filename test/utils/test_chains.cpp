@@ -72,3 +72,55 @@ TEST_F(TestChains, BasicFunctions) {
     q.pop();
     EXPECT_EQ(q.size(), testSize - 2);
 }
+
+TEST_F(TestChains, CumulatorSlidingAndForking) {
+    const size_t n = GetParams().sortitionThreshold;
+
+    std::vector<ConstBlockPtr> blocks;
+    for (size_t i = 0; i < 4 * n + 2; ++i) {
+        Block b = fac.CreateBlock();
+        b.SetDifficultyTarget(GetParams().maxTarget.GetCompact() - (rand() % 1000) * 0x100);
+        b.SetTime(1000 + i * 10 + rand() % 10);
+        blocks.push_back(std::make_shared<const Block>(std::move(b)));
+    }
+
+    // Reference of the window over the blocks [0, end)
+    auto expected = [&](size_t end) {
+        arith_uint256 sum = 0;
+        for (size_t i = 0; i < end; ++i) {
+            sum += blocks[i]->GetChainWork();
+            if (i >= n) {
+                sum -= arith_uint256().SetCompact(blocks[i - n]->GetChainWork().GetCompact());
+            }
+        }
+        size_t front = end > n ? end - n : 0;
+        return std::make_pair(sum, blocks[end - 1]->GetTime() - blocks[front]->GetTime());
+    };
+
+    Cumulator cum;
+    ASSERT_TRUE(cum.Empty());
+    for (size_t i = 0; i < 4 * n; ++i) {
+        cum.Add(blocks[i]);
+        ASSERT_EQ(cum.Full(), i + 1 >= n);
+        ASSERT_EQ(expected(i + 1), std::make_pair(cum.Sum(), cum.TimeSpan()));
+    }
+
+    // A fork sharing the window with cum
+    Cumulator fork = cum;
+    cum.Add(blocks[4 * n]);
+    fork.Add(blocks[4 * n + 1]);
+
+    auto sum = expected(4 * n).first;
+    EXPECT_EQ(sum + blocks[4 * n]->GetChainWork() -
+                  arith_uint256().SetCompact(blocks[3 * n]->GetChainWork().GetCompact()),
+              cum.Sum());
+    EXPECT_EQ(sum + blocks[4 * n + 1]->GetChainWork() -
+                  arith_uint256().SetCompact(blocks[3 * n]->GetChainWork().GetCompact()),
+              fork.Sum());
+    EXPECT_EQ(blocks[4 * n]->GetTime() - blocks[3 * n + 1]->GetTime(), cum.TimeSpan());
+    EXPECT_EQ(blocks[4 * n + 1]->GetTime() - blocks[3 * n + 1]->GetTime(), fork.TimeSpan());
+
+    cum.Clear();
+    EXPECT_TRUE(cum.Empty());
+    EXPECT_FALSE(fork.Empty());
+}
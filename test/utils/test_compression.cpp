@@ -0,0 +1,44 @@
+// Copyright (c) 2019 EPI-ONE Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <gtest/gtest.h>
+
+#include "compression.h"
+
+#include <numeric>
+
+TEST(TestCompression, round_trip) {
+    std::vector<char> data(200000);
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = i % 97;
+    }
+
+    VStream compressed;
+    ASSERT_TRUE(compression::Compress(data.data(), data.size(), compressed));
+    ASSERT_LT(compressed.size(), data.size());
+
+    VStream decompressed;
+    ASSERT_TRUE(compression::Decompress(compressed.data(), compressed.size(), decompressed, data.size()));
+    ASSERT_EQ(decompressed.size(), data.size());
+    ASSERT_TRUE(std::equal(data.begin(), data.end(), decompressed.data()));
+
+    // exceeding the limit by a single byte fails
+    ASSERT_FALSE(compression::Decompress(compressed.data(), compressed.size(), decompressed, data.size() - 1));
+    ASSERT_TRUE(decompressed.empty());
+
+    // truncated or corrupted input fails
+    ASSERT_FALSE(compression::Decompress(compressed.data(), compressed.size() - 1, decompressed, data.size()));
+    compressed.data()[compressed.size() / 2] ^= 0xff;
+    ASSERT_FALSE(compression::Decompress(compressed.data(), compressed.size(), decompressed, data.size()));
+}
+
+TEST(TestCompression, incompressible) {
+    // a short sequence of distinct bytes doesn't get smaller
+    std::vector<char> data(64);
+    std::iota(data.begin(), data.end(), 0);
+
+    VStream compressed;
+    ASSERT_FALSE(compression::Compress(data.data(), data.size(), compressed));
+    ASSERT_FALSE(compression::Compress(data.data(), 0, compressed));
+}
@@ -73,3 +73,34 @@ TEST_F(TestConcurrentContainers, HashSet) {
 
     ASSERT_TRUE(s.empty());
 }
+
+TEST_F(TestConcurrentContainers, HashSetTryPop) {
+    ConcurrentHashSet<int> s;
+    for (int i = 0; i < testSize; ++i) {
+        s.insert(i);
+    }
+
+    // every element is taken by exactly one of the consumers
+    ConcurrentHashSet<int> popped;
+    std::atomic_int nDuplicates = 0;
+    for (int i = 0; i < 4; ++i) {
+        threadPool.Execute([&]() {
+            while (auto e = s.TryPop()) {
+                if (!popped.insert(*e).second) {
+                    nDuplicates++;
+                }
+            }
+        });
+    }
+
+    while (!threadPool.IsIdle()) {
+        usleep(100000);
+    }
+
+    threadPool.Stop();
+
+    ASSERT_TRUE(s.empty());
+    ASSERT_FALSE(s.TryPop());
+    ASSERT_EQ(popped.size(), static_cast<size_t>(testSize));
+    ASSERT_EQ(nDuplicates, 0);
+}
@@ -0,0 +1,78 @@
+// Copyright (c) 2019 EPI-ONE Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <gtest/gtest.h>
+
+#include "file_utils.h"
+#include "io_backend.h"
+
+#include <atomic>
+#include <numeric>
+#include <string>
+
+class TestIOBackend : public testing::Test {
+public:
+    const std::string dir = "test_io_backend";
+
+    void SetUp() override {
+        MkdirRecursive(dir);
+    }
+
+    void TearDown() override {
+        DeleteDir(dir);
+    }
+
+    void ReadAndWrite(IOBackend& io) {
+        std::vector<char> data(10000);
+        std::iota(data.begin(), data.end(), 0);
+
+        const std::string path1 = dir + "/" + io.GetName() + "1";
+        const std::string path2 = dir + "/" + io.GetName() + "2";
+        ASSERT_TRUE(io.Write(path1, 0, data.data(), 4000));
+        ASSERT_TRUE(io.Write(path1, 4000, data.data() + 4000, 2000));
+        ASSERT_TRUE(io.Write(path2, 0, data.data() + 6000, 4000));
+
+        // ranges across files are concatenated in order
+        auto result = io.Read({{path1, 100, 5900}, {path2, 0, 3000}, {path1, 0, 100}});
+        ASSERT_TRUE(result);
+        ASSERT_EQ(result->size(), 9000);
+        ASSERT_TRUE(std::equal(data.begin() + 100, data.begin() + 9000, result->data()));
+        ASSERT_TRUE(std::equal(data.begin(), data.begin() + 100, result->data() + 8900));
+
+        // reading beyond the end of file fails
+        ASSERT_FALSE(io.Read({{path2, 3000, 2000}}));
+        ASSERT_FALSE(io.Read({{dir + "/missing", 0, 1}}));
+        ASSERT_TRUE(io.Read({}));
+
+        // async reads call back on the pool
+        ThreadPool pool(2);
+        pool.Start();
+        constexpr int nReads = 1000;
+        std::atomic_int nDone = 0, nCorrect = 0;
+        for (int i = 0; i < nReads; ++i) {
+            io.AsyncRead({{path1, uint64_t(i), 10}}, pool, [&, i](std::optional<VStream> r) {
+                if (r && r->size() == 10 && std::equal(data.begin() + i, data.begin() + i + 10, r->data())) {
+                    nCorrect++;
+                }
+                nDone++;
+            });
+        }
+        while (nDone < nReads) {
+            std::this_thread::yield();
+        }
+        pool.Stop();
+        ASSERT_EQ(nCorrect, nReads);
+    }
+};
+
+TEST_F(TestIOBackend, pread) {
+    PreadBackend io;
+    ReadAndWrite(io);
+}
+
+TEST_F(TestIOBackend, default_backend) {
+    auto io = CreateIOBackend();
+    ASSERT_TRUE(io);
+    ReadAndWrite(*io);
+}
@@ -0,0 +1,80 @@
+// Copyright (c) 2019 EPI-ONE Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <gtest/gtest.h>
+
+#include "binary_trace.h"
+#include "file_utils.h"
+#include "log.h"
+
+#include <thread>
+
+class TestLog : public testing::Test {
+public:
+    const std::string dir = "test_log";
+
+    void SetUp() override {
+        MkdirRecursive(dir);
+    }
+
+    void TearDown() override {
+        DeleteDir(dir);
+    }
+};
+
+TEST_F(TestLog, lazy_arguments) {
+    auto level = spdlog::default_logger()->level();
+    spdlog::set_level(spdlog::level::info);
+
+    int evaluated = 0;
+    auto arg      = [&]() { return ++evaluated; };
+    LOG_DEBUG("filtered out {}", arg());
+    LOG_TRACE("filtered out {}", arg());
+    ASSERT_EQ(evaluated, 0);
+    LOG_INFO("logged {}", arg());
+    ASSERT_EQ(evaluated, 1);
+
+    spdlog::set_level(level);
+}
+
+TEST_F(TestLog, binary_trace) {
+    const std::string path = dir + "/trace.bin";
+
+    // nothing is recorded before the trace is opened
+    TRACE_EVENT(BLOCK_RECEIVED, uintS<256>("1"));
+    ASSERT_FALSE(BinaryTrace::IsEnabled());
+    ASSERT_TRUE(BinaryTrace::Open(path, 1 << 10));
+    ASSERT_TRUE(BinaryTrace::IsEnabled());
+
+    constexpr size_t nThreads = 4, nEvents = 10000;
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < nThreads; ++t) {
+        threads.emplace_back([t]() {
+            for (size_t i = 0; i < nEvents; ++i) {
+                TRACE_EVENT(TX_INVALID, uintS<256>(std::to_string(t)), i);
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    BinaryTrace::Close();
+    ASSERT_FALSE(BinaryTrace::IsEnabled());
+
+    // entries are dropped rather than blocking when the ring is full
+    auto entries = BinaryTrace::ReadFile(path);
+    ASSERT_EQ(entries.size() + BinaryTrace::GetDropped(), nThreads * nEvents);
+    ASSERT_FALSE(entries.empty());
+
+    std::vector<size_t> next(nThreads, 0);
+    for (const auto& entry : entries) {
+        ASSERT_EQ(entry.event, static_cast<uint32_t>(TraceEvent::TX_INVALID));
+        auto t = std::stoul(entry.hash.GetHex());
+        ASSERT_LT(t, nThreads);
+
+        // the events of a thread keep their order
+        ASSERT_GE(entry.arg, next[t]);
+        next[t] = entry.arg + 1;
+    }
+}
@@ -249,3 +249,44 @@ TEST_F(TestSer, SerializeEqDeserializeVertex) {
     ASSERT_EQ(block, block1);
     ASSERT_EQ(block.height, block1.snapshot->height);
 }
+
+TEST_F(TestSer, DeserializeLegacyAndCompactVertex) {
+    Vertex vtx;
+    vtx.height           = 42;
+    vtx.cumulativeReward = 10;
+    vtx.minerChainHeight = 7;
+    vtx.isRedeemed       = Vertex::IS_REDEEMED;
+    vtx.validity         = {Vertex::VALID, Vertex::INVALID, Vertex::UNKNOWN, Vertex::VALID, Vertex::INVALID};
+
+    // the record layout before the compact format
+    VStream legacy;
+    legacy << vtx.isRedeemed << VARINT(vtx.height) << vtx.cumulativeReward << VARINT(vtx.minerChainHeight)
+           << vtx.validity << static_cast<uint8_t>(IS_NOT_MILESTONE);
+    const size_t legacySize = legacy.size();
+
+    Vertex fromLegacy;
+    legacy >> fromLegacy;
+    ASSERT_EQ(legacy.size(), 0);
+    ASSERT_EQ(fromLegacy, vtx);
+
+    // 5 validities take 2 bytes instead of 5, and the milestone status moves into the header
+    VStream compact;
+    fromLegacy.Serialize(compact);
+    ASSERT_EQ(compact.size(), fromLegacy.GetOptimalStorageSize());
+    ASSERT_EQ(compact.size(), legacySize - 4);
+
+    Vertex fromCompact;
+    compact >> fromCompact;
+    ASSERT_EQ(fromCompact, vtx);
+
+    // the height is left to the milestone of the level set
+    VStream noHeight;
+    vtx.Serialize(noHeight, false);
+    ASSERT_EQ(noHeight.size(), vtx.GetOptimalStorageSize(false));
+
+    Vertex withoutHeight;
+    noHeight >> withoutHeight;
+    ASSERT_EQ(withoutHeight.height, 0);
+    withoutHeight.SetHeight(vtx.height);
+    ASSERT_EQ(withoutHeight, vtx);
+}
@@ -0,0 +1,156 @@
+// Copyright (c) 2019 EPI-ONE Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <gtest/gtest.h>
+
+#include "scheduler.h"
+#include "timer_wheel.h"
+
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+class TestTimerWheel : public testing::Test {};
+
+TEST_F(TestTimerWheel, one_shot_order) {
+    TimerWheel wheel(1ms, true);
+    std::vector<std::pair<int, uint64_t>> fired;
+
+    // delays crossing the first level are cascaded down before they expire
+    for (int i : {5, 1, 200, 70, 30}) {
+        wheel.AddTimer(std::chrono::milliseconds(i), [&, i]() { fired.emplace_back(i, wheel.GetTick()); });
+    }
+    ASSERT_EQ(wheel.Size(), 5);
+
+    wheel.AdvanceBy(400ms);
+    std::vector<std::pair<int, uint64_t>> expected{{1, 1}, {5, 5}, {30, 30}, {70, 70}, {200, 200}};
+    ASSERT_EQ(fired, expected);
+    ASSERT_EQ(wheel.Size(), 0);
+}
+
+TEST_F(TestTimerWheel, cascade_levels) {
+    TimerWheel wheel(1ms, true);
+    std::vector<uint64_t> fired;
+
+    // expiries on the second, third and fourth level
+    for (uint64_t delay : {4097, 64, 262145, 4095}) {
+        wheel.AddTimer(std::chrono::milliseconds(delay), [&]() { fired.push_back(wheel.GetTick()); });
+    }
+
+    wheel.AdvanceBy(4096ms);
+    ASSERT_EQ(fired, std::vector<uint64_t>({64, 4095}));
+    wheel.AdvanceBy(300s);
+    ASSERT_EQ(fired, std::vector<uint64_t>({64, 4095, 4097, 262145}));
+}
+
+TEST_F(TestTimerWheel, period_and_cancel) {
+    TimerWheel wheel(1ms, true);
+    int period = 0, cancelled = 0;
+
+    auto id = wheel.AddPeriodTimer(20ms, [&]() { ++period; });
+    wheel.AddTimer(50ms, [&]() { ++cancelled; });
+    ASSERT_TRUE(wheel.Cancel(wheel.AddTimer(30ms, [&]() { ++cancelled; })));
+
+    wheel.AdvanceBy(210ms);
+    ASSERT_TRUE(wheel.Cancel(id));
+    ASSERT_FALSE(wheel.Cancel(id));
+    ASSERT_EQ(period, 10);
+    ASSERT_EQ(cancelled, 1);
+
+    wheel.AdvanceBy(60ms);
+    ASSERT_EQ(period, 10);
+}
+
+TEST_F(TestTimerWheel, sub_millisecond_tick) {
+    TimerWheel wheel(100us, true);
+    bool fired = false;
+
+    wheel.AddTimer(500us, [&]() { fired = true; });
+    wheel.AdvanceBy(400us);
+    ASSERT_FALSE(fired);
+    wheel.AdvanceBy(100us);
+    ASSERT_TRUE(fired);
+    ASSERT_EQ(wheel.GetTick(), 5);
+}
+
+TEST_F(TestTimerWheel, cancel_from_callback) {
+    TimerWheel wheel(1ms, true);
+    int count              = 0;
+    TimerWheel::TimerId id = 0;
+
+    // the callback may cancel its own periodic timer without deadlocking
+    id = wheel.AddPeriodTimer(5ms, [&]() {
+        if (++count == 3) {
+            wheel.Cancel(id);
+        }
+    });
+    wheel.AdvanceBy(100ms);
+    ASSERT_EQ(count, 3);
+    ASSERT_EQ(wheel.Size(), 0);
+}
+
+TEST_F(TestTimerWheel, thread_of_wheel) {
+    TimerWheel wheel;
+    std::promise<TimerWheel::Clock::time_point> fired;
+    auto start = TimerWheel::Clock::now();
+
+    // only checks that the timer doesn't fire early, as the scheduling delay is unbounded;
+    // the delay counts from the start of the current tick
+    wheel.AddTimer(10ms, [&]() { fired.set_value(TimerWheel::Clock::now()); });
+    auto future = fired.get_future();
+    ASSERT_EQ(future.wait_for(10s), std::future_status::ready);
+    ASSERT_GE(future.get() - start, 9ms);
+}
+
+TEST_F(TestTimerWheel, scheduler_timer) {
+    TimerWheel wheel(1ms, true);
+    int fired = 0;
+    Timer timer(1, [&]() { ++fired; }, wheel);
+
+    // stopping the timer doesn't execute the function
+    timer.Reset();
+    timer.Stop();
+    wheel.AdvanceBy(1100ms);
+    ASSERT_EQ(fired, 0);
+
+    timer.Reset();
+    wheel.AdvanceBy(500ms);
+    timer.Reset();
+    wheel.AdvanceBy(700ms);
+    ASSERT_EQ(fired, 0);
+    wheel.AdvanceBy(300ms);
+    ASSERT_EQ(fired, 1);
+}
+
+TEST_F(TestTimerWheel, scheduler_dispatch) {
+    TimerWheel wheel(1ms, true);
+    Scheduler scheduler(wheel);
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<std::thread::id> threads;
+
+    scheduler.AddPeriodTask(1, [&]() {
+        std::lock_guard<std::mutex> lock(mutex);
+        threads.push_back(std::this_thread::get_id());
+        cv.notify_one();
+    });
+    scheduler.Start();
+
+    // the task is executed on the thread of the scheduler rather than the one of the wheel
+    for (size_t i = 1; i <= 2; ++i) {
+        wheel.AdvanceBy(1s);
+        std::unique_lock<std::mutex> lock(mutex);
+        ASSERT_TRUE(cv.wait_for(lock, 10s, [&]() { return threads.size() == i; }));
+        ASSERT_NE(threads.back(), std::this_thread::get_id());
+    }
+
+    scheduler.Stop();
+    ASSERT_EQ(wheel.Size(), 0);
+    wheel.AdvanceBy(1s);
+    ASSERT_EQ(threads.size(), 2);
+}
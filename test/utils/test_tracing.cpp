@@ -0,0 +1,117 @@
+// Copyright (c) 2019 EPI-ONE Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <gtest/gtest.h>
+
+#include "tracing.h"
+
+#include <thread>
+
+#ifdef __linux__
+#include <pthread.h>
+#endif
+
+class TestTracing : public testing::Test {
+public:
+    void TearDown() override {
+        Tracer::Enable(false);
+        Tracer::Clear();
+    }
+
+    static size_t Count(const std::string& json, const std::string& pattern) {
+        size_t n = 0;
+        for (auto pos = json.find(pattern); pos != std::string::npos; pos = json.find(pattern, pos + 1)) {
+            ++n;
+        }
+        return n;
+    }
+};
+
+TEST_F(TestTracing, spans) {
+    const auto block     = uintS<256>("b10c");
+    const auto milestone = uintS<256>("3e57");
+
+    { TRACE_SPAN("disabled", block); }
+    ASSERT_EQ(Count(Tracer::ExportJson(), "\"ph\":\"X\""), 0);
+
+    Tracer::Enable(true);
+    {
+        TRACE_SPAN("Chain::Verify", milestone, milestone);
+        TraceSpan span("AddNewBlock");
+        span.SetBlock(block);
+        TRACE_ASYNC_BEGIN("OBC", block);
+    }
+    std::thread([&]() { TRACE_ASYNC_END("OBC", block); }).join();
+
+    auto json = Tracer::ExportJson();
+    ASSERT_EQ(json.front(), '{');
+    ASSERT_EQ(json.back(), '}');
+    ASSERT_EQ(Count(json, "{"), Count(json, "}"));
+    ASSERT_EQ(Count(json, "\"name\":\"Chain::Verify\""), 1);
+    ASSERT_EQ(Count(json, "\"name\":\"AddNewBlock\""), 1);
+    ASSERT_EQ(Count(json, "\"block\":\"" + block.GetHex() + "\""), 3);
+    ASSERT_EQ(Count(json, "\"milestone\":\"" + milestone.GetHex() + "\""), 1);
+
+    // the begin and end of the async event are on different threads but share the id
+    ASSERT_EQ(Count(json, "\"ph\":\"b\""), 1);
+    ASSERT_EQ(Count(json, "\"ph\":\"e\""), 1);
+    ASSERT_EQ(Count(json, "\"id\":\"0xb10c\""), 2);
+
+    Tracer::Clear();
+    ASSERT_EQ(Count(Tracer::ExportJson(), "\"cat\":\"block\""), 0);
+}
+
+TEST_F(TestTracing, ring_keeps_latest) {
+    Tracer::Enable(true);
+    for (size_t i = 0; i < Tracer::kBufferSize + 10; ++i) {
+        TRACE_SPAN(i < 10 ? "old" : "new");
+    }
+
+    auto json = Tracer::ExportJson();
+    ASSERT_EQ(Count(json, "\"name\":\"old\""), 0);
+    ASSERT_EQ(Count(json, "\"name\":\"new\""), Tracer::kBufferSize);
+}
+
+TEST_F(TestTracing, export_in_chunks) {
+    Tracer::Enable(true);
+    const auto block = uintS<256>("b10c");
+    for (size_t i = 0; i < Tracer::kBufferSize; ++i) {
+        TRACE_SPAN("chunked", block, block);
+    }
+
+    std::vector<std::string> chunks;
+    ASSERT_TRUE(Tracer::ExportJson([&](std::string&& chunk) {
+        chunks.push_back(std::move(chunk));
+        return true;
+    }));
+
+    // every chunk but the last is cut at the first event reaching the size
+    ASSERT_GT(chunks.size(), 1);
+    std::string json;
+    for (const auto& chunk : chunks) {
+        ASSERT_LT(chunk.size(), Tracer::kChunkSize + 1024);
+        json += chunk;
+    }
+    ASSERT_EQ(json, Tracer::ExportJson());
+    ASSERT_EQ(Count(json, "\"name\":\"chunked\""), Tracer::kBufferSize);
+
+    // the export stops once the writer fails
+    size_t n = 0;
+    ASSERT_FALSE(Tracer::ExportJson([&](std::string&&) { return ++n < 1; }));
+    ASSERT_EQ(n, 1);
+}
+
+#ifdef __linux__
+TEST_F(TestTracing, escape_thread_name) {
+    Tracer::Enable(true);
+    std::thread([]() {
+        pthread_setname_np(pthread_self(), "a\"b\\c");
+        TRACE_SPAN("escaped");
+    }).join();
+
+    auto json = Tracer::ExportJson();
+    ASSERT_EQ(Count(json, "\"args\":{\"name\":\"a\\\"b\\\\c\"}"), 1);
+    ASSERT_EQ(Count(json, "\"name\":\"escaped\""), 1);
+}
+#endif
@@ -10,6 +10,8 @@
 #include "wallet.h"
 
 #include <chrono>
+#include <thread>
+#include <unordered_set>
 
 class TestWallet : public testing::Test {
 public:
@@ -176,6 +178,79 @@ TEST_F(TestWallet, test_wallet_store) {
     system(cmd.c_str());
 }
 
+TEST_F(TestWallet, key_pool) {
+    const uint32_t poolSize = 10;
+    std::unordered_set<CKeyID> addrs;
+    {
+        Wallet wallet{dir, 0, 0, poolSize};
+        wallet.GenerateMaster();
+        ASSERT_TRUE(wallet.SetPassphrase("pool"));
+        wallet.Start();
+
+        while (wallet.GetKeyPoolSize() < poolSize) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+
+        // addresses are handed out while the pool is being refilled
+        for (uint32_t i = 0; i < 3 * poolSize; ++i) {
+            addrs.insert(wallet.CreateNewKey(true));
+        }
+        ASSERT_EQ(addrs.size(), 3 * poolSize);
+
+        auto all = wallet.GetAllAddresses();
+        for (const auto& addr : addrs) {
+            ASSERT_NE(std::find(all.begin(), all.end(), addr), all.end());
+        }
+    }
+
+    WalletStore store{dir};
+    for (const auto& addr : addrs) {
+        ASSERT_TRUE(store.IsExistKey(addr));
+    }
+}
+
+TEST_F(TestWallet, change_passphrase_while_filling_key_pool) {
+    const uint32_t poolSize = 200;
+    {
+        Wallet wallet{dir, 0, 0, poolSize};
+        wallet.GenerateMaster();
+        wallet.Start();
+        ASSERT_TRUE(wallet.SetPassphrase("old"));
+
+        // the pool is being filled with the first key meanwhile
+        ASSERT_TRUE(wallet.ChangePassphrase("old", "new"));
+        while (wallet.GetKeyPoolSize() < poolSize) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+
+        // and refilled while changing it again
+        for (uint32_t i = 0; i < poolSize; ++i) {
+            wallet.CreateNewKey(true);
+        }
+        ASSERT_TRUE(wallet.ChangePassphrase("new", "newer"));
+        while (wallet.GetKeyPoolSize() < poolSize) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+
+    // every stored key is encrypted with the last passphrase
+    WalletStore store{dir};
+    auto info = store.GetMasterInfo();
+    ASSERT_TRUE(info);
+    Crypter crypter{};
+    SecureByte master{};
+    ASSERT_TRUE(crypter.SetKeyFromPassphrase("newer", info->salt, info->nDeriveIterations));
+    ASSERT_TRUE(crypter.DecryptMaster(info->cryptedMaster, master));
+
+    auto keys = store.GetAllKey();
+    ASSERT_GE(keys.size(), 2 * poolSize);
+    for (const auto& [addr, encryptedPair] : keys) {
+        CKey privkey{};
+        ASSERT_TRUE(crypter.DecryptKey(master, std::get<1>(encryptedPair), std::get<0>(encryptedPair), privkey));
+        ASSERT_EQ(privkey.GetPubKey().GetID(), addr);
+    }
+}
+
 TEST_F(TestWallet, workflow) {
     WALLET->GenerateMaster();
     WALLET->SetPassphrase("");